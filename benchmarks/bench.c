@@ -0,0 +1,293 @@
+// bench.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "bench.h"
+#include "cmsis_device.h"
+#include "cycle_counter.h"
+
+#if defined(RTOS)
+#include "feabhOS_scheduler.h"
+#include "feabhOS_task.h"
+#endif
+
+// ----------------------------------------------------------------------------
+
+// Benchmark firmware main(): runs every registered benchmark and writes
+// one line per result to stdout (semihosting) for scripts/qemu_bench.py:
+//
+//   BENCH-CAL {"counter":"systick","ticks":26880,"instructions":20000,...}
+//   BENCH {"name":"memcpy_1k","iterations":1000,"ticks":..,"pass":true}
+//   BENCH-END {"benchmarks":4,"failures":0}
+//
+// and exits with status 0 if every benchmark passed, 1 otherwise.
+//
+// Ticks are core clock cycles from the DWT cycle counter where it is
+// present (real hardware). QEMU does not implement the DWT so SysTick is
+// used instead: it counts the core clock derived from QEMU virtual time
+// which, when run with -icount, advances a fixed time per instruction.
+// The calibration line gives the ticks taken by a loop of a known number
+// of instructions so ticks can be converted to instruction counts.
+//
+// SysTick is only 24 bits wide so each benchmark is run in batches that
+// complete within half a SysTick period. If SysTick is already running
+// (RTOS builds, or the timer drivers) its reload value is left unchanged
+// and the tick interrupts are included in the measurements.
+
+// ----------------------------------------------------------------------------
+
+typedef enum
+{
+  COUNTER_DWT, COUNTER_SYSTICK
+} counter_type;
+
+static counter_type counter;
+static uint32_t counter_limit;          // longest batch that can be timed
+static uint32_t counter_overhead;       // ticks to read the counter twice
+
+static bench* bench_head;
+static bench** bench_tail = &bench_head;
+
+void
+bench_register (bench* b)
+{
+  b->next = 0;
+  *bench_tail = b;
+  bench_tail = &b->next;
+}
+
+// ----------------------------------------------------------------------------
+
+static void
+counter_initialize (void)
+{
+  if (cycle_counter_enable ())
+    {
+      counter = COUNTER_DWT;
+      counter_limit = 0x80000000u;
+      return;
+    }
+
+  counter = COUNTER_SYSTICK;
+  if ((SysTick->CTRL & SysTick_CTRL_ENABLE_Msk) == 0)
+    {
+      // free running from the core clock, no interrupt
+      SysTick->LOAD = SysTick_LOAD_RELOAD_Msk;
+      SysTick->VAL = 0;
+      SysTick->CTRL = SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;
+    }
+  counter_limit = (SysTick->LOAD + 1) / 2;
+}
+
+static inline uint32_t
+counter_read (void)
+{
+  return (counter == COUNTER_DWT) ? cycle_counter_read () : SysTick->VAL;
+}
+
+static inline uint32_t
+counter_elapsed (uint32_t start, uint32_t end)
+{
+  if (counter == COUNTER_DWT)
+    {
+      return end - start;
+    }
+  // SysTick counts down from LOAD to 0 and reloads
+  return (start >= end) ? (start - end) : (start + SysTick->LOAD + 1 - end);
+}
+
+static uint32_t
+counter_net (uint32_t start, uint32_t end)
+{
+  uint32_t ticks = counter_elapsed (start, end);
+  return (ticks > counter_overhead) ? (ticks - counter_overhead) : 0;
+}
+
+static void
+counter_measure_overhead (void)
+{
+  uint32_t least = UINT32_MAX;
+  for (unsigned i = 0; i < 8; ++i)
+    {
+      uint32_t start = counter_read ();
+      uint32_t end = counter_read ();
+      uint32_t ticks = counter_elapsed (start, end);
+      least = (ticks < least) ? ticks : least;
+    }
+  counter_overhead = least;
+}
+
+// ----------------------------------------------------------------------------
+
+// Two instructions per iteration.
+static void __attribute__((noinline))
+calibration_loop (uint32_t count)
+{
+  __asm__ volatile (
+      "1: subs %0, %0, #1 \n"
+      "   bne 1b          \n"
+      : "+r" (count) : : "cc");
+}
+
+static uint32_t
+calibrate (uint32_t* instructions)
+{
+  uint32_t count = 10000;
+  for (;;)
+    {
+      uint32_t start = counter_read ();
+      calibration_loop (count);
+      uint32_t ticks = counter_net (start, counter_read ());
+      if (ticks < counter_limit || count == 1)
+        {
+          *instructions = 2 * count;
+          return ticks;
+        }
+      count /= 4;
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+// newlib-nano printf has no 64-bit conversions
+static const char*
+u64_to_string (uint64_t value, char buffer[21])
+{
+  char* p = &buffer[20];
+  *p = '\0';
+  do
+    {
+      *--p = (char) ('0' + (value % 10));
+      value /= 10;
+    }
+  while (value != 0);
+  return p;
+}
+
+static bool
+run_hook (bench_hook hook)
+{
+  return (hook == 0) || hook ();
+}
+
+static bool
+run_benchmark (const bench* b)
+{
+  char buffer[21];
+  uint64_t total = 0;
+  bool overflow = false;
+
+  // a benchmark whose setup fails is not run
+  bool pass = run_hook (b->setup);
+  if (pass)
+    {
+      // a single iteration both warms the caches and sizes the batches
+      uint32_t start = counter_read ();
+      pass = b->function (1);
+      uint32_t single = counter_net (start, counter_read ());
+
+      if (single >= counter_limit)
+        {
+          overflow = true;
+          pass = false;
+        }
+      else
+        {
+          uint32_t batch = counter_limit / (single + 1);
+          batch = (batch == 0) ? 1 : batch;
+
+          // setup and verify are outside the timed calls
+          for (unsigned done = 0; done < b->iterations;)
+            {
+              uint32_t remaining = b->iterations - done;
+              uint32_t count = (remaining < batch) ? remaining : batch;
+
+              if (!run_hook (b->setup))
+                {
+                  pass = false;
+                  break;
+                }
+              start = counter_read ();
+              pass = b->function (count) && pass;
+              total += counter_net (start, counter_read ());
+              done += count;
+            }
+          pass = run_hook (b->verify) && pass;
+        }
+    }
+
+  printf ("BENCH {\"name\":\"%s\",\"iterations\":%u,\"ticks\":%s,"
+          "\"overflow\":%s,\"pass\":%s}\n",
+          b->name, b->iterations, u64_to_string (total, buffer),
+          overflow ? "true" : "false", pass ? "true" : "false");
+  return pass;
+}
+
+static int
+run_all (void)
+{
+  counter_initialize ();
+  counter_measure_overhead ();
+
+  uint32_t instructions;
+  uint32_t ticks = calibrate (&instructions);
+
+  printf ("BENCH-CAL {\"counter\":\"%s\",\"ticks\":%lu,\"instructions\":%lu,"
+          "\"overhead\":%lu,\"clock\":%lu}\n",
+          (counter == COUNTER_DWT) ? "dwt" : "systick",
+          (unsigned long) ticks, (unsigned long) instructions,
+          (unsigned long) counter_overhead, (unsigned long) SystemCoreClock);
+
+  unsigned count = 0;
+  unsigned failures = 0;
+  for (const bench* b = bench_head; b != 0; b = b->next)
+    {
+      ++count;
+      if (!run_benchmark (b))
+        {
+          ++failures;
+        }
+    }
+
+  printf ("BENCH-END {\"benchmarks\":%u,\"failures\":%u}\n", count, failures);
+  return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// ----------------------------------------------------------------------------
+
+#if defined(RTOS)
+
+static void
+bench_task (void* param __attribute__((unused)))
+{
+  exit (run_all ());
+}
+
+int
+main (void)
+{
+  feabhOS_TASK task;
+
+  feabhOS_scheduler_init ();
+  if (feabhOS_task_create (&task, bench_task, NULL, STACK_LARGE,
+                           PRIORITY_NORMAL) != ERROR_OK)
+    {
+      puts ("BENCH-END {\"benchmarks\":0,\"failures\":1}");
+      return EXIT_FAILURE;
+    }
+  feabhOS_scheduler_start ();
+  return EXIT_FAILURE;
+}
+
+#else
+
+int
+main (void)
+{
+  return run_all ();
+}
+
+#endif
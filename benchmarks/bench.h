@@ -0,0 +1,108 @@
+// bench.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#ifndef BENCH_H_
+#define BENCH_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+
+// Benchmark firmware harness (see bench.c).
+//
+// Each benchmark is a function that runs its operation 'iterations'
+// times and returns false if a result is wrong:
+//
+//     BENCHMARK(memcpy_1k, 1000)
+//     {
+//       for (unsigned i = 0; i < iterations; ++i)
+//         {
+//           memcpy (dst, src, sizeof src);
+//           bench_clobber ();
+//         }
+//       return memcmp (dst, src, sizeof src) == 0;
+//     }
+//
+// The harness may call the function several times with smaller batches
+// so a single call must be repeatable. Benchmarks run in the order of
+// the source files on the link line; under RTOS builds they run in a
+// feabhOS task once the scheduler has started.
+//
+// Work that is not part of the operation being measured, such as
+// generating the input or computing a reference result, goes in the
+// optional setup and verify functions of BENCHMARK_WITH. They are not
+// timed: setup runs before every call of the benchmark function and
+// verify once after the last call. Either returns false to fail the
+// benchmark; if setup fails the benchmark is not run.
+//
+//     BENCHMARK_WITH(fir_q15, 100, fir_setup, fir_verify)
+//     {
+//       for (unsigned i = 0; i < iterations; ++i)
+//         {
+//           arm_fir_q15 (&fir, input, output, BLOCK_SIZE);
+//           bench_clobber ();
+//         }
+//       return true;
+//     }
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  typedef bool
+  (*bench_function) (unsigned iterations);
+
+  typedef bool
+  (*bench_hook) (void);
+
+  typedef struct bench
+  {
+    const char* name;
+    bench_function function;
+    unsigned iterations;
+    bench_hook setup;                   // optional, untimed
+    bench_hook verify;                  // optional, untimed
+    struct bench* next;
+  } bench;
+
+  void
+  bench_register (bench* b);
+
+  // Stop the compiler optimising away a result, or assuming memory
+  // is unchanged between iterations.
+  static inline void
+  bench_use (uint32_t value)
+  {
+    __asm__ volatile ("" : : "r" (value) : "memory");
+  }
+
+  static inline void
+  bench_clobber (void)
+  {
+    __asm__ volatile ("" : : : "memory");
+  }
+
+#if defined(__cplusplus)
+}
+#endif
+
+#define BENCHMARK(name_, iterations_)                                   \
+  BENCHMARK_WITH(name_, iterations_, 0, 0)
+
+#define BENCHMARK_WITH(name_, iterations_, setup_, verify_)             \
+  static bool name_ (unsigned iterations);                              \
+  static bench bench_##name_ =                                          \
+    { #name_, name_, (iterations_), (setup_), (verify_), 0 };           \
+  static void __attribute__((constructor))                              \
+  bench_register_##name_ (void)                                         \
+  {                                                                     \
+    bench_register (&bench_##name_);                                    \
+  }                                                                     \
+  static bool name_ (unsigned iterations)
+
+// ----------------------------------------------------------------------------
+
+#endif // BENCH_H_
@@ -0,0 +1,354 @@
+// bench_dsp.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include "bench.h"
+
+#if defined(OS_USE_CMSIS_DSP)
+
+#include <math.h>
+#include <string.h>
+
+#include "cmsis_device.h"
+#include "arm_math.h"
+
+// ----------------------------------------------------------------------------
+
+// CMSIS-DSP q15 kernels against plain C loops over one 512-sample ADC
+// block, so ticks / iterations is the cost per block. Each pair of
+// benchmarks is checked to agree to within the kernels' rounding.
+// Generating the input, initialising the kernels and the checks are
+// in the untimed setup and verify functions. Only built when the dsp
+// target exists (see dsp/CMakeLists.txt).
+
+#define BLOCK_SIZE      512
+#define FIR_TAPS        32
+#define BIQUAD_STAGES   2
+#define BIQUAD_SHIFT    1
+
+static q15_t input[BLOCK_SIZE];
+static q15_t output[BLOCK_SIZE];
+static q15_t reference[BLOCK_SIZE];
+
+// Sawtooth plus noise, as 12-bit ADC samples converted to q15
+static void
+make_input (void)
+{
+  uint32_t noise = 1;
+  for (unsigned i = 0; i < BLOCK_SIZE; ++i)
+    {
+      noise = noise * 1664525u + 1013904223u;
+      int32_t sample = (int32_t) ((i * 37u) & 0xFFFu) + (int32_t) (noise >> 28) - 0x808;
+      input[i] = (q15_t) (sample * 8);
+    }
+}
+
+static bool
+agree (const q15_t* a, const q15_t* b, unsigned length, int tolerance)
+{
+  for (unsigned i = 0; i < length; ++i)
+    {
+      int difference = a[i] - b[i];
+      if (difference > tolerance || difference < -tolerance)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+static q15_t
+saturate (int64_t value)
+{
+  return (q15_t) ((value > INT16_MAX) ? INT16_MAX : (value < INT16_MIN) ? INT16_MIN : value);
+}
+
+// ----------------------------------------------------------------------------
+// 32-tap FIR, triangular low-pass (symmetric, so the CMSIS time-reversed
+// coefficient order does not matter)
+
+static q15_t fir_coefficients[FIR_TAPS];
+static q15_t fir_state[FIR_TAPS + BLOCK_SIZE];
+static arm_fir_instance_q15 fir;
+
+static q15_t fir_history[FIR_TAPS - 1 + BLOCK_SIZE];
+
+static bool
+fir_setup (void)
+{
+  make_input ();
+  for (unsigned k = 0; k < FIR_TAPS; ++k)
+    {
+      unsigned weight = (k < FIR_TAPS / 2) ? (k + 1) : (FIR_TAPS - k);
+      fir_coefficients[k] = (q15_t) (weight * 120);
+    }
+  arm_fir_init_q15 (&fir, FIR_TAPS, fir_coefficients, fir_state, BLOCK_SIZE);
+  for (unsigned i = 0; i < FIR_TAPS - 1; ++i)
+    {
+      fir_history[i] = 0;
+    }
+  return true;
+}
+
+static void
+fir_scalar (const q15_t* source, q15_t* destination)
+{
+  for (unsigned i = 0; i < BLOCK_SIZE; ++i)
+    {
+      fir_history[FIR_TAPS - 1 + i] = source[i];
+    }
+  for (unsigned n = 0; n < BLOCK_SIZE; ++n)
+    {
+      int64_t sum = 0;
+      for (unsigned k = 0; k < FIR_TAPS; ++k)
+        {
+          sum += (int32_t) fir_coefficients[k] * fir_history[FIR_TAPS - 1 + n - k];
+        }
+      destination[n] = saturate (sum >> 15);
+    }
+  for (unsigned i = 0; i < FIR_TAPS - 1; ++i)
+    {
+      fir_history[i] = fir_history[BLOCK_SIZE + i];
+    }
+}
+
+// The state left by the timed calls depends on the batch sizes, so
+// both filters start again from zero
+static bool
+fir_verify (void)
+{
+  fir_setup ();
+  arm_fir_q15 (&fir, input, output, BLOCK_SIZE);
+  fir_scalar (input, reference);
+  return agree (output, reference, BLOCK_SIZE, 0);
+}
+
+BENCHMARK_WITH(dsp_fir_q15_cmsis, 100, fir_setup, fir_verify)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      arm_fir_q15 (&fir, input, output, BLOCK_SIZE);
+      bench_clobber ();
+    }
+  return true;
+}
+
+BENCHMARK_WITH(dsp_fir_q15_scalar, 100, fir_setup, 0)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      fir_scalar (input, output);
+      bench_clobber ();
+    }
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+// Two-stage biquad (direct form I), Butterworth low-pass at fs / 10.
+// Coefficients { b0, 0, b1, b2, a1, a2 } halved (post shift 1), with
+// the feedback terms negated as CMSIS adds them
+
+static const q15_t biquad_coefficients[6 * BIQUAD_STAGES] = {
+  1106, 0, 2210, 1106, 18727, -6763,
+  1106, 0, 2210, 1106, 18727, -6763,
+};
+static q15_t biquad_state[4 * BIQUAD_STAGES];
+static arm_biquad_casd_df1_inst_q15 biquad;
+
+static q15_t biquad_history[4 * BIQUAD_STAGES];    // x1, x2, y1, y2 per stage
+
+static bool
+biquad_setup (void)
+{
+  make_input ();
+  arm_biquad_cascade_df1_init_q15 (&biquad, BIQUAD_STAGES, (q15_t*) biquad_coefficients,
+                                   biquad_state, BIQUAD_SHIFT);
+  for (unsigned i = 0; i < 4 * BIQUAD_STAGES; ++i)
+    {
+      biquad_history[i] = 0;
+    }
+  return true;
+}
+
+static void
+biquad_scalar (const q15_t* source, q15_t* destination)
+{
+  const q15_t* in = source;
+  for (unsigned stage = 0; stage < BIQUAD_STAGES; ++stage)
+    {
+      const q15_t* c = &biquad_coefficients[6 * stage];
+      q15_t* h = &biquad_history[4 * stage];
+      for (unsigned n = 0; n < BLOCK_SIZE; ++n)
+        {
+          int64_t sum = (int32_t) c[0] * in[n];
+          sum += (int32_t) c[2] * h[0];
+          sum += (int32_t) c[3] * h[1];
+          sum += (int32_t) c[4] * h[2];
+          sum += (int32_t) c[5] * h[3];
+          q15_t y = saturate (sum >> (15 - BIQUAD_SHIFT));
+          h[1] = h[0];
+          h[0] = in[n];
+          h[3] = h[2];
+          h[2] = y;
+          destination[n] = y;
+        }
+      in = destination;
+    }
+}
+
+static bool
+biquad_verify (void)
+{
+  biquad_setup ();
+  arm_biquad_cascade_df1_q15 (&biquad, input, output, BLOCK_SIZE);
+  biquad_scalar (input, reference);
+  return agree (output, reference, BLOCK_SIZE, 1);
+}
+
+BENCHMARK_WITH(dsp_biquad_q15_cmsis, 100, biquad_setup, biquad_verify)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      arm_biquad_cascade_df1_q15 (&biquad, input, output, BLOCK_SIZE);
+      bench_clobber ();
+    }
+  return true;
+}
+
+BENCHMARK_WITH(dsp_biquad_q15_scalar, 100, biquad_setup, 0)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      biquad_scalar (input, output);
+      bench_clobber ();
+    }
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+// RMS of a block
+
+static q15_t
+rms_scalar (const q15_t* source)
+{
+  int64_t sum = 0;
+  for (unsigned i = 0; i < BLOCK_SIZE; ++i)
+    {
+      sum += (int32_t) source[i] * source[i];
+    }
+
+  // Mean square is q30, its square root q15
+  uint32_t square = (uint32_t) (sum / BLOCK_SIZE);
+  uint32_t root = 0;
+  for (uint32_t bit = 1u << 30; bit != 0; bit >>= 2)
+    {
+      if (square >= root + bit)
+        {
+          square -= root + bit;
+          root = (root >> 1) + bit;
+        }
+      else
+        {
+          root >>= 1;
+        }
+    }
+  return (q15_t) root;
+}
+
+static q15_t rms;
+
+static bool
+rms_setup (void)
+{
+  make_input ();
+  return true;
+}
+
+static bool
+rms_verify (void)
+{
+  q15_t expected = rms_scalar (input);
+  return (rms - expected <= 8) && (expected - rms <= 8);
+}
+
+BENCHMARK_WITH(dsp_rms_q15_cmsis, 100, rms_setup, rms_verify)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      arm_rms_q15 (input, BLOCK_SIZE, &rms);
+      bench_use ((uint32_t) rms);
+    }
+  return true;
+}
+
+BENCHMARK_WITH(dsp_rms_q15_scalar, 100, rms_setup, 0)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      bench_use ((uint32_t) rms_scalar (input));
+      bench_clobber ();
+    }
+  return true;
+}
+
+// ----------------------------------------------------------------------------
+// 512-point real FFT and magnitude of a tone in bin 16; no scalar
+// equivalent, the check is that the tone is found
+
+static q15_t tone[BLOCK_SIZE];
+static q15_t fft_input[BLOCK_SIZE];
+static q15_t spectrum[2 * BLOCK_SIZE];
+static q15_t magnitude[BLOCK_SIZE / 2];
+
+static arm_rfft_instance_q15 rfft;
+static arm_cfft_radix4_instance_q15 cfft;
+
+// The instance and the tone do not change, so are set up once
+static bool
+rfft_setup (void)
+{
+  static bool ready;
+  if (!ready)
+    {
+      if (arm_rfft_init_q15 (&rfft, &cfft, BLOCK_SIZE, 0, 1) != ARM_MATH_SUCCESS)
+        {
+          return false;
+        }
+      for (unsigned n = 0; n < BLOCK_SIZE; ++n)
+        {
+          tone[n] = (q15_t) (16000.0f * sinf (2.0f * PI * 16.0f * (float) n / BLOCK_SIZE));
+        }
+      ready = true;
+    }
+  return true;
+}
+
+static bool
+rfft_verify (void)
+{
+  unsigned peak = 1;
+  for (unsigned bin = 1; bin < BLOCK_SIZE / 2; ++bin)
+    {
+      if (magnitude[bin] > magnitude[peak])
+        {
+          peak = bin;
+        }
+    }
+  return peak == 16;
+}
+
+// arm_rfft_q15 overwrites its input, so the copy is part of the
+// cost per block
+BENCHMARK_WITH(dsp_rfft_q15_cmsis, 100, rfft_setup, rfft_verify)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      memcpy (fft_input, tone, sizeof fft_input);
+      arm_rfft_q15 (&rfft, fft_input, spectrum);
+      arm_cmplx_mag_q15 (spectrum, magnitude, BLOCK_SIZE / 2);
+      bench_clobber ();
+    }
+  return true;
+}
+
+#endif // OS_USE_CMSIS_DSP
@@ -0,0 +1,53 @@
+// bench_feabhos.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#if defined(RTOS)
+
+#include "bench.h"
+#include "feabhOS_mutex.h"
+#include "feabhOS_queue.h"
+
+// ----------------------------------------------------------------------------
+
+// Uncontended feabhOS (FreeRTOS) calls from the benchmark task. The
+// objects are created on first use as the scheduler must be running.
+
+BENCHMARK(mutex_lock_unlock, 1000)
+{
+  static feabhOS_MUTEX mutex;
+  bool pass = true;
+
+  if (mutex == NULL)
+    {
+      pass = feabhOS_mutex_create (&mutex) == ERROR_OK;
+    }
+  for (unsigned i = 0; pass && i < iterations; ++i)
+    {
+      pass = (feabhOS_mutex_lock (&mutex, NO_WAIT) == ERROR_OK)
+          && (feabhOS_mutex_unlock (&mutex) == ERROR_OK);
+    }
+  return pass;
+}
+
+BENCHMARK(queue_post_get, 1000)
+{
+  static feabhOS_QUEUE queue;
+  bool pass = true;
+
+  if (queue == NULL)
+    {
+      pass = feabhOS_queue_create (&queue, sizeof (uint32_t), 4) == ERROR_OK;
+    }
+  for (uint32_t i = 0; pass && i < iterations; ++i)
+    {
+      uint32_t in = i;
+      uint32_t out = 0;
+      pass = (feabhOS_queue_post (&queue, &in, NO_WAIT) == ERROR_OK)
+          && (feabhOS_queue_get (&queue, &out, NO_WAIT) == ERROR_OK)
+          && (out == i);
+    }
+  return pass;
+}
+
+#endif // defined(RTOS)
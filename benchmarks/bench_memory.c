@@ -0,0 +1,63 @@
+// bench_memory.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <string.h>
+
+#include "bench.h"
+
+// ----------------------------------------------------------------------------
+
+// C library block copy/fill and a table-free CRC-32 over 1K of SRAM.
+
+static uint8_t source[1024];
+static uint8_t destination[1024];
+
+BENCHMARK(memcpy_1k, 1000)
+{
+  for (unsigned i = 0; i < sizeof source; ++i)
+    {
+      source[i] = (uint8_t) i;
+    }
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      memcpy (destination, source, sizeof destination);
+      bench_clobber ();
+    }
+  return memcmp (destination, source, sizeof destination) == 0;
+}
+
+BENCHMARK(memset_1k, 1000)
+{
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      memset (destination, (int) (i & 0x7Fu), sizeof destination);
+      bench_clobber ();
+    }
+  return destination[sizeof destination - 1] == ((iterations - 1) & 0x7Fu);
+}
+
+static uint32_t
+crc32 (const uint8_t* data, size_t length)
+{
+  uint32_t crc = 0xFFFFFFFFu;
+  while (length-- != 0)
+    {
+      crc ^= *data++;
+      for (unsigned bit = 0; bit < 8; ++bit)
+        {
+          crc = (crc >> 1) ^ (0xEDB88320u & (0u - (crc & 1u)));
+        }
+    }
+  return ~crc;
+}
+
+BENCHMARK(crc32_1k, 100)
+{
+  static const uint8_t check[] = "123456789";
+  for (unsigned i = 0; i < iterations; ++i)
+    {
+      bench_use (crc32 (source, sizeof source));
+    }
+  return crc32 (check, sizeof check - 1) == 0xCBF43926u;
+}
@@ -39,6 +39,7 @@ Usage: ${0#.*/} [options...]
     reset      -- regenerate make files and do a clean build
     debug      -- build debug version (default)
     release    -- build release version
+    release-lto -- build release version with link time optimisation
     --rtos     -- include RTOS middleware if not found automatically
     --exc      -- enable exceptions also --exceptions
     --Cnn      -- set C langauge version to nn, also -c
@@ -49,6 +50,10 @@ Usage: ${0#.*/} [options...]
     clean      -- remove object files and build
     test       -- run cmake with test target after a build
     clang-tidy -- run clang-tidy after a build 
+    stack-usage -- report worst case stack depth after a build
+    size       -- report flash/RAM usage against the size baseline after a build
+    size-baseline -- save flash/RAM usage as the size baseline after a build
+    bench      -- build the benchmarks and run them under QEMU after a build
   Other options:
     --c        -- generate main.c if it doesn't exist
     --cpp      -- generate main.cpp if it doesn't exist
@@ -123,6 +128,9 @@ CONFIG=debug
 VERBOSE=
 TEST=
 CLANG_TIDY=
+STACK_USAGE=
+SIZE=
+BENCH=
 RESET=
 CLEAN=
 CMAKE_OPTS=
@@ -136,8 +144,13 @@ for arg; do
     --verbose|-v)  VERBOSE="$BUILD_VERBOSE" ;;
     debug)         CONFIG=debug ;;
     release)       CONFIG=release ;;
+    release-lto)   CONFIG=release-lto ;;
     test)          TEST=1   ;;
     clang-tidy)    CLANG_TIDY=1 ;;
+    stack-usage)   STACK_USAGE='-DSTACK_USAGE=ON' ;;
+    size)          SIZE=size-report ;;
+    size-baseline) SIZE=size-baseline ;;
+    bench)         BENCH=1 ;;
     clean)         CLEAN=1  ;;
     reset)         RESET=1  ;;
     --[cC])        LANG=c   ;;
@@ -184,6 +197,14 @@ if [[ -n $RTOS ]]; then
     [[ -f src/main.cpp ]] && EXC='-DEXCEPTIONS=ON'
 fi
 
+# check if stack usage files not generated before
+
+if [[ -n $STACK_USAGE ]]; then
+    if ! grep -q 'STACK_USAGE:BOOL=ON' $BUILD/$CONFIG/CMakeCache.txt 2>/dev/null; then
+        RESET=1
+    fi
+fi
+
 # check for exceptions not used
 
 if [[ -n $EXC ]]; then
@@ -212,7 +233,7 @@ fi
 # run cmake
 
 if [[ -n $RESET ]]; then
-    $CMAKE --preset ${CONFIG} -G "$GENERATOR"  $CMAKE_OPTS $RTOS $EXC
+    $CMAKE --preset ${CONFIG} -G "$GENERATOR"  $CMAKE_OPTS $RTOS $EXC $STACK_USAGE
 fi
 
 if [[ -n $CLEAN ]]; then
@@ -224,6 +245,15 @@ then
   if [[ -n $CLANG_TIDY ]]; then
     $CMAKE --build --preset clang-tidy
   fi
+  if [[ -n $STACK_USAGE ]]; then
+    $CMAKE --build --preset ${CONFIG} --target stack-usage
+  fi
+  if [[ -n $SIZE ]]; then
+    $CMAKE --build --preset ${CONFIG} --target $SIZE
+  fi
+  if [[ -n $BENCH ]]; then
+    $CMAKE --build --preset ${CONFIG} --target bench
+  fi
   if [[ -n $TEST ]]; then
     $CMAKE --build --preset test
   fi
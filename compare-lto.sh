@@ -0,0 +1,75 @@
+#!/bin/bash
+# Compare the release and release-lto builds of the application:
+# flash/RAM usage from the linked images and, when run on hardware,
+# the reset to main() cycle count recorded by the BOOT_TIME option.
+
+set -o nounset 
+set -o errexit
+
+CMAKE='cmake'
+BUILD=build/compare
+PRESETS="release release-lto"
+
+function usage {
+  cat <<EOT
+Usage: ${0#.*/} [options...]
+  Builds the release and release-lto configurations into $BUILD
+  (leaving the normal build folders untouched) and compares their size.
+  Options:
+    --help     -- this help information also -h -?
+  Both images are built with BOOT_TIME=ON: to compare cycle counts flash
+  each image to a board and, once main() is reached, read the variable
+  __startup_boot_cycles with the debugger. QEMU does not emulate the
+  DWT cycle counter.
+EOT
+  exit 1
+}
+
+for arg; do
+  case "$arg" in
+    --help|-h|-\?) usage ;;
+    *)             echo "Unknown option $arg" >&2
+                   usage ;;
+  esac
+done
+
+SIZE=$(grep -hs '^TOOLCHAIN_SIZE:' build/*/CMakeCache.txt | head -1 | cut -d= -f2 || true)
+[[ -z "$SIZE" ]] && SIZE=arm-none-eabi-size
+
+declare -A TEXT DATA BSS
+
+for preset in $PRESETS; do
+  echo "=== Building $preset"
+  $CMAKE --preset $preset -B $BUILD/$preset -DBOOT_TIME=ON >/dev/null
+  $CMAKE --build $BUILD/$preset
+  read -r text data bss _ < <("$SIZE" --format=berkeley $BUILD/$preset/Application.elf | tail -1)
+  TEXT[$preset]=$text
+  DATA[$preset]=$data
+  BSS[$preset]=$bss
+done
+
+function delta {
+  local base=$1 new=$2
+  if (( base == 0 )); then
+    echo "n/a"
+  else
+    awk -v b="$base" -v n="$new" 'BEGIN { printf "%+d (%+.1f%%)", n - b, 100.0 * (n - b) / b }'
+  fi
+}
+
+echo
+printf "%-12s %10s %10s %10s %12s %12s\n" "" "text" "data" "bss" "flash" "ram"
+for preset in $PRESETS; do
+  flash=$(( ${TEXT[$preset]} + ${DATA[$preset]} ))
+  ram=$(( ${DATA[$preset]} + ${BSS[$preset]} ))
+  printf "%-12s %10d %10d %10d %12d %12d\n" $preset \
+         ${TEXT[$preset]} ${DATA[$preset]} ${BSS[$preset]} $flash $ram
+done
+base_flash=$(( ${TEXT[release]} + ${DATA[release]} ))
+lto_flash=$(( ${TEXT[release-lto]} + ${DATA[release-lto]} ))
+base_ram=$(( ${DATA[release]} + ${BSS[release]} ))
+lto_ram=$(( ${DATA[release-lto]} + ${BSS[release-lto]} ))
+echo
+echo "flash: $(delta $base_flash $lto_flash)"
+echo "ram:   $(delta $base_ram $lto_ram)"
+
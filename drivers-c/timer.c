@@ -16,6 +16,7 @@ void vApplicationTickHook(void)
 
 #include <stdbool.h>
 #include "cmsis_device.h"
+#include "memory_sections.h"
 
 #define TIMER_FREQUENCY_HZ (1000u)
 
@@ -47,6 +48,8 @@ void sleep(duration_mSec period)
 }
 
 
+void SysTick_Handler (void) FEABHAS_RAMFUNC;
+
 void SysTick_Handler (void)
 {
   if(timer_counter != 0)
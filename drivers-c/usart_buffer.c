@@ -3,8 +3,11 @@
 // Feabhas Ltd
 
 #include "usart_buffer.h"
+#include "memory_sections.h"
 
-static uint32_t buffer[USART_BUFFER_SIZE];     // Array of void values
+// Only accessed by the CPU (task and ISR), so held in CCMRAM
+//
+static uint32_t buffer[USART_BUFFER_SIZE] FEABHAS_CCM_BSS;     // Array of void values
 static unsigned int next_in   = 0;        // Next input location
 static unsigned int next_out  = 0;        // Next output location
 static unsigned int num_items = 0;        // Current buffer size
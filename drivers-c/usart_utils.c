@@ -4,6 +4,7 @@
 
 #include "stdint.h"
 #include "stm32f4xx.h"
+#include "system_clock.h"
 #include "usart_utils.h"
 
 
@@ -62,8 +63,9 @@ void usart_utils_init(void)
     cr2 &= ~(0x3u << 12);                   // 1 stop bit
     USART3->CR2 = cr2;
 
-    uint32_t brr = USART3->BRR;
-    brr = 0x008Bu;                          // Baud_rate::baud_115200
+    // 115.2kb, 16x oversampling: BRR = PCLK1 / baud (rounded)
+    //
+    uint32_t brr = (SystemClock_PCLK1() + (115200u / 2)) / 115200u;
     USART3->BRR = brr;
 
     cr1 = USART3->CR1;
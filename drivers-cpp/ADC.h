@@ -0,0 +1,501 @@
+// ADC.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef ADC_H
+#define ADC_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "NVIC.h"
+#include "DMA.h"
+#include "Timer_registers.h"
+#include "system_clock.h"
+
+#if defined(RTOS)
+#include "feabhOS_signal.h"
+#endif
+
+namespace STM32F407
+{
+  namespace ADC_config
+  {
+    // ---------------------------------------------------------------------
+    // ADC register definitions (RM0090 section 13.13)
+    //
+    template <uintptr_t base>
+    struct Registers
+    {
+      struct SR : Register<SR, base + 0x00>
+      {
+        using AWD   = Field<SR, 0, 1>;      // Analog watchdog
+        using EOC   = Field<SR, 1, 1>;      // End of conversion
+        using JEOC  = Field<SR, 2, 1>;      // Injected end of conversion
+        using JSTRT = Field<SR, 3, 1>;      // Injected start
+        using STRT  = Field<SR, 4, 1>;      // Regular start
+        using OVR   = Field<SR, 5, 1>;      // Overrun
+      };
+
+      struct CR1 : Register<CR1, base + 0x04>
+      {
+        using EOCIE = Field<CR1, 5, 1>;     // End of conversion interrupt enable
+        using SCAN  = Field<CR1, 8, 1>;     // Scan mode
+        using RES   = Field<CR1, 24, 2>;    // Resolution (0 is 12 bits)
+        using OVRIE = Field<CR1, 26, 1>;    // Overrun interrupt enable
+      };
+
+      struct CR2 : Register<CR2, base + 0x08>
+      {
+        using ADON    = Field<CR2, 0, 1>;   // A/D converter on
+        using CONT    = Field<CR2, 1, 1>;   // Continuous conversion
+        using DMA     = Field<CR2, 8, 1>;   // DMA mode
+        using DDS     = Field<CR2, 9, 1>;   // DMA requests after the last transfer
+        using EOCS    = Field<CR2, 10, 1>;  // End of conversion selection
+        using ALIGN   = Field<CR2, 11, 1>;  // Data alignment (left)
+        using EXTSEL  = Field<CR2, 24, 4>;  // Regular group trigger
+        using EXTEN   = Field<CR2, 28, 2>;  // Regular group trigger edge
+        using SWSTART = Field<CR2, 30, 1>;  // Start regular conversion
+
+        static constexpr std::uint32_t rising_edge { 0x1 };
+      };
+
+      // Sample time, 3 bits per channel: 10-18 (SMPR1), 0-9 (SMPR2)
+      //
+      struct SMPR1 : Register<SMPR1, base + 0x0C> { };
+      struct SMPR2 : Register<SMPR2, base + 0x10> { };
+
+      // Regular sequence, 5 bits per conversion: 13-16 and the
+      // length (SQR1), 7-12 (SQR2), 1-6 (SQR3)
+      //
+      struct SQR1 : Register<SQR1, base + 0x2C>
+      {
+        using L = Field<SQR1, 20, 4>;       // Sequence length - 1
+      };
+      struct SQR2 : Register<SQR2, base + 0x30> { };
+      struct SQR3 : Register<SQR3, base + 0x34> { };
+
+      struct DR : Register<DR, base + 0x4C, Access::read_only> { };
+    };
+
+    // Registers shared by the three ADCs
+    //
+    struct CCR : Register<CCR, ADC_common_base + 0x04>
+    {
+      using ADCPRE  = Field<CCR, 16, 2>;    // ADC clock prescaler, PCLK2 / 2, 4, 6, 8
+      using VBATE   = Field<CCR, 22, 1>;    // VBAT channel enable
+      using TSVREFE = Field<CCR, 23, 1>;    // Temperature sensor and Vrefint enable
+    };
+
+    // Maximum ADC clock (DS8626 table 66)
+    //
+    constexpr std::uint32_t max_clock { 36000000 };
+
+    // ---------------------------------------------------------------------
+    // ADC instances and their DMA stream (RM0090 table 43)
+    //
+    enum class Instance { adc_1, adc_2, adc_3 };
+
+    struct Instance_info
+    {
+      uintptr_t             base;
+      APB2_Device           clock;
+      DMA_config::Stream_id dma;
+    };
+
+    inline constexpr Instance_info instances[] {
+      { ADC1_base,         ADC_1, { 2, 0, 0 } },
+      { ADC1_base + 0x100, ADC_2, { 2, 2, 1 } },
+      { ADC1_base + 0x200, ADC_3, { 2, 1, 2 } },
+    };
+
+    constexpr const Instance_info& info(Instance instance)
+    {
+      return instances[static_cast<unsigned>(instance)];
+    }
+
+    // Scan trigger: the update event (TRGO) of a general-purpose
+    // timer, giving EXTSEL, the timer and its enable bit
+    //
+    enum class Trigger { tim2_trgo, tim3_trgo };
+
+    struct Trigger_info
+    {
+      std::uint32_t extsel;
+      APB1_Device   timer;
+    };
+
+    constexpr Trigger_info trigger_info(Trigger trigger)
+    {
+      return (trigger == Trigger::tim2_trgo) ? Trigger_info { 0x6, TIMER_2 } : Trigger_info { 0x8, TIMER_3 };
+    }
+
+    enum class Sample_time : std::uint32_t
+    {
+      cycles_3, cycles_15, cycles_28, cycles_56, cycles_84, cycles_112, cycles_144, cycles_480
+    };
+
+    // Input channels 0-15 are pins; 16 is the temperature
+    // sensor, 17 Vrefint and 18 VBAT / 2
+    //
+    constexpr unsigned max_channel { 18 };
+
+    struct Channel
+    {
+      unsigned    number;
+      Sample_time sample_time { Sample_time::cycles_15 };
+    };
+
+  } // namespace ADC_config
+
+
+  // -----------------------------------------------------------------------------------
+  // Timer-triggered multi-channel ADC scans into a DMA ping-pong
+  // buffer.
+  //
+  // Each trigger converts the channels in order and the DMA stream
+  // stores the results in a circular buffer of two blocks of
+  // 'scans_per_block' scans. The DMA half-transfer and
+  // transfer-complete interrupts each mark a block as complete and
+  // call the handler with a Block: a view onto the samples in the
+  // DMA buffer, not a copy. The CPU is not involved per sample,
+  // only once per block.
+  //
+  // A block is overwritten one block period after it completes, so it
+  // must be processed, or copied, within that time. Blocks are
+  // numbered from 0 when the scan starts: a consumer that sees the
+  // sequence jump by more than one has missed blocks.
+  //
+  // If the DMA misses a conversion the ADC overruns and stops making
+  // DMA requests. The overrun interrupt restarts the DMA stream and
+  // the scan from block 0 of the buffer. The partly filled block is
+  // discarded, so the sequence skips a number.
+  //
+  //   using Sampler = ADC_scan<ADC_config::Instance::adc_1, 2, 64>;
+  //   Sampler adc { { { 1 }, { 16, ADC_config::Sample_time::cycles_144 } }, handler };
+  //
+  //   extern "C" void DMA2_Stream0_IRQHandler() { adc.dma_interrupt(); }
+  //   extern "C" void ADC_IRQHandler()          { adc.adc_interrupt(); }
+  //
+  //   adc.start(10000);       // 10k scans per second
+  //
+  // The DMA stream and ADC interrupts are enabled in the NVIC by
+  // start(). ADC_IRQ is shared by the three ADCs: its handler calls
+  // adc_interrupt() for each ADC_scan. The object holds the DMA buffer,
+  // so it must be in SRAM (see DMA.h).
+  //
+  template <ADC_config::Instance instance,
+            std::size_t channel_count,
+            std::size_t scans_per_block,
+            ADC_config::Trigger trigger = ADC_config::Trigger::tim2_trgo>
+  class ADC_scan
+  {
+  public:
+    using Sample = std::uint16_t;
+
+    static constexpr std::size_t scan_size  { channel_count };
+    static constexpr std::size_t scans      { scans_per_block };
+    static constexpr std::size_t block_size { channel_count * scans_per_block };
+
+    static_assert(channel_count >= 1 && channel_count <= 16, "An ADC sequence has 1 to 16 channels");
+    static_assert(scans_per_block >= 1, "A block must have at least one scan");
+    static_assert(2 * block_size <= 0xFFFF, "DMA transfers are limited to 65535 samples");
+
+    static constexpr const ADC_config::Instance_info& config { ADC_config::info(instance) };
+
+    using Registers  = ADC_config::Registers<config.base>;
+    using DMA_stream = DMA::Stream<config.dma.controller, config.dma.stream>;
+    using Timer      = Timer_config::Registers<device_base_address(ADC_config::trigger_info(trigger).timer)>;
+
+    // A completed block of samples, scan by scan
+    //
+    class Block
+    {
+    public:
+      Block(const Sample* block, std::uint32_t number) : samples { block }, sequence_number { number } { }
+
+      Sample operator()(std::size_t scan, std::size_t channel) const
+      {
+        return samples[(scan * channel_count) + channel];
+      }
+
+      const Sample* begin()    const { return samples; }
+      const Sample* end()      const { return samples + block_size; }
+      std::size_t   size()     const { return block_size; }
+      std::uint32_t sequence() const { return sequence_number; }
+
+    private:
+      const Sample* samples;
+      std::uint32_t sequence_number;
+    };
+
+    // Called in interrupt context
+    //
+    using Handler = void (*)(const Block& block, void* context);
+
+    ADC_scan(const ADC_config::Channel (&scan_channels)[channel_count],
+             Handler callback,
+             void* callback_context = nullptr);
+
+    ~ADC_scan() { stop(); }
+
+    ADC_scan(const ADC_scan&)            = delete;
+    ADC_scan& operator=(const ADC_scan&) = delete;
+
+    // Start scanning at 'scan_rate' scans per second. Returns
+    // false if the trigger timer cannot generate the rate
+    //
+    bool start(std::uint32_t scan_rate);
+    void stop();
+
+    // Call from the DMA stream's IRQ handler (DMA_stream::irq)
+    //
+    void dma_interrupt();
+
+    // Call from the ADC IRQ handler (ADC_IRQ)
+    //
+    void adc_interrupt();
+
+    // Blocks completed since start(); block(completed() - 1)
+    // is the latest
+    //
+    std::uint32_t completed() const { return blocks; }
+    Block block(std::uint32_t sequence) const
+    {
+      return Block { &buffer[(sequence % 2) * block_size], sequence };
+    }
+
+    std::uint32_t errors() const { return error_count; }
+
+#if defined(RTOS)
+    // Handler for tasks waiting on a feabhOS signal; pass the
+    // signal as the context. The task uses completed() and block()
+    // to find the blocks to process
+    //
+    static void notify_signal(const Block&, void* signal)
+    {
+      feabhOS_signal_notify_one_ISR(static_cast<feabhOS_SIGNAL*>(signal));
+    }
+#endif
+
+  private:
+    void configure_adc();
+    void configure_sample_clock();
+
+    ADC_config::Channel channels[channel_count];
+    Handler handler;
+    void*   context;
+
+    volatile std::uint32_t blocks      { };
+    volatile std::uint32_t error_count { };
+
+    alignas(4) Sample buffer[2 * block_size] { };
+  };
+
+
+  template <ADC_config::Instance instance, std::size_t channel_count, std::size_t scans_per_block, ADC_config::Trigger trigger>
+  ADC_scan<instance, channel_count, scans_per_block, trigger>::ADC_scan(
+    const ADC_config::Channel (&scan_channels)[channel_count],
+    Handler callback,
+    void* callback_context) :
+    handler { callback },
+    context { callback_context }
+  {
+    for (std::size_t i = 0; i < channel_count; ++i) {
+      channels[i] = scan_channels[i];
+    }
+  }
+
+
+  template <ADC_config::Instance instance, std::size_t channel_count, std::size_t scans_per_block, ADC_config::Trigger trigger>
+  bool ADC_scan<instance, channel_count, scans_per_block, trigger>::start(std::uint32_t scan_rate)
+  {
+    // Trigger timer period in timer clocks, split into a
+    // prescaler and a 16-bit reload so TIM3 works as well as TIM2
+    //
+    const std::uint32_t clock { Timer_config::APB1_timer_clock() };
+    if (scan_rate == 0 || scan_rate > clock) return false;
+
+    const std::uint32_t period    { clock / scan_rate };
+    const std::uint32_t prescaler { (period - 1) / 0x10000 };
+    if (prescaler > 0xFFFF) return false;
+    const std::uint32_t reload    { (period / (prescaler + 1)) - 1 };
+
+    stop();
+
+    blocks      = 0;
+    error_count = 0;
+
+    STM32F407::enable(config.clock);
+    STM32F407::enable(ADC_config::trigger_info(trigger).timer);
+    DMA_stream::enable_clock();
+
+    configure_sample_clock();
+    configure_adc();
+
+    DMA::Transfer transfer { };
+    transfer.channel                 = config.dma.channel;
+    transfer.direction               = DMA::Direction::peripheral_to_memory;
+    transfer.peripheral              = Registers::DR::address;
+    transfer.memory                  = buffer;
+    transfer.count                   = static_cast<std::uint16_t>(2 * block_size);
+    transfer.size                    = DMA::Size::half_word;
+    transfer.priority                = DMA::Priority::high;
+    transfer.circular                = true;
+    transfer.half_transfer_interrupt = true;
+    transfer.complete_interrupt      = true;
+    DMA_stream::start(transfer);
+
+    NVIC::enable(DMA_stream::irq);
+    NVIC::enable(ADC_IRQ);
+
+    // The ADC waits for the first trigger
+    //
+    Registers::CR2::modify(Registers::CR2::ADON::set);
+
+    Timer::CR1::write(Timer::CR1::CEN::clear);
+    Timer::PSC::write(prescaler);
+    Timer::ARR::write(reload);
+    Timer::CR2::modify(Timer::CR2::MMS::template value<Timer::CR2::trgo_update>());
+    Timer::EGR::write(Timer::EGR::UG::set);
+    Timer::CR1::modify(Timer::CR1::CEN::set);
+    return true;
+  }
+
+
+  template <ADC_config::Instance instance, std::size_t channel_count, std::size_t scans_per_block, ADC_config::Trigger trigger>
+  void ADC_scan<instance, channel_count, scans_per_block, trigger>::stop()
+  {
+    // ADC_IRQ is left enabled as other ADCs may use it
+    //
+    Timer::CR1::modify(Timer::CR1::CEN::clear);
+    Registers::CR1::modify(Registers::CR1::OVRIE::clear);
+    Registers::CR2::modify(Registers::CR2::ADON::clear | Registers::CR2::DMA::clear);
+    NVIC::disable(DMA_stream::irq);
+    DMA_stream::stop();
+  }
+
+
+  template <ADC_config::Instance instance, std::size_t channel_count, std::size_t scans_per_block, ADC_config::Trigger trigger>
+  void ADC_scan<instance, channel_count, scans_per_block, trigger>::dma_interrupt()
+  {
+    const std::uint32_t flags { DMA_stream::interrupt_flags() };
+
+    if ((flags & (DMA_config::Flags::TEIF | DMA_config::Flags::FEIF | DMA_config::Flags::DMEIF)) != 0) {
+      error_count = error_count + 1;
+    }
+
+    // Half transfer: block 0 (first half) is complete; transfer
+    // complete: block 1. Both can be set if the interrupt was
+    // delayed; the blocks are then reported in order
+    //
+    constexpr std::uint32_t block_flags[] { DMA_config::Flags::HTIF, DMA_config::Flags::TCIF };
+    for (std::uint32_t flag : block_flags) {
+      if ((flags & flag) != 0) {
+        const std::uint32_t sequence { blocks };
+        blocks = sequence + 1;
+        if (handler != nullptr) {
+          handler(block(sequence), context);
+        }
+      }
+    }
+  }
+
+
+  template <ADC_config::Instance instance, std::size_t channel_count, std::size_t scans_per_block, ADC_config::Trigger trigger>
+  void ADC_scan<instance, channel_count, scans_per_block, trigger>::adc_interrupt()
+  {
+    using CR2 = typename Registers::CR2;
+    using SR  = typename Registers::SR;
+
+    if (!SR::OVR::is_set()) return;
+
+    // An overrun stops the DMA requests. Recover as RM0090 13.8.1:
+    // re-arm the stream at the start of the buffer, clear OVR and
+    // retrigger. Toggling CR2.DMA resets the ADC's DMA request
+    // logic. Block 0 is filled next, so an odd sequence number
+    // is skipped
+    //
+    error_count = error_count + 1;
+
+    CR2::modify(CR2::DMA::clear);
+    DMA_stream::restart(static_cast<std::uint16_t>(2 * block_size));
+    blocks = (blocks + 1) & ~0x1u;
+    SR::modify(SR::OVR::clear);
+    CR2::modify(CR2::DMA::set);
+
+    // The update event restarts the trigger period and its TRGO
+    // starts the next scan
+    //
+    Timer::EGR::write(Timer::EGR::UG::set);
+  }
+
+
+  template <ADC_config::Instance instance, std::size_t channel_count, std::size_t scans_per_block, ADC_config::Trigger trigger>
+  void ADC_scan<instance, channel_count, scans_per_block, trigger>::configure_sample_clock()
+  {
+    // Smallest PCLK2 divider within the maximum ADC clock
+    //
+    const std::uint32_t pclk2 { SystemClock_PCLK2() };
+    std::uint32_t prescaler { 0 };
+    while (prescaler < 3 && (pclk2 / (2 * (prescaler + 1))) > ADC_config::max_clock) {
+      ++prescaler;
+    }
+    ADC_config::CCR::modify(ADC_config::CCR::ADCPRE::value(prescaler));
+
+    bool internal { false };
+    bool vbat { false };
+    for (const auto& channel : channels) {
+      internal = internal || (channel.number == 16) || (channel.number == 17);
+      vbat     = vbat || (channel.number == 18);
+    }
+    if (internal) ADC_config::CCR::modify(ADC_config::CCR::TSVREFE::set);
+    if (vbat)     ADC_config::CCR::modify(ADC_config::CCR::VBATE::set);
+  }
+
+
+  template <ADC_config::Instance instance, std::size_t channel_count, std::size_t scans_per_block, ADC_config::Trigger trigger>
+  void ADC_scan<instance, channel_count, scans_per_block, trigger>::configure_adc()
+  {
+    using CR1 = typename Registers::CR1;
+    using CR2 = typename Registers::CR2;
+
+    // Sequence and sample times
+    //
+    std::uint32_t sequence[3] { };                      // SQR3, SQR2, SQR1
+    std::uint32_t sample_times[2] { };                  // SMPR2, SMPR1
+    for (std::size_t i = 0; i < channel_count; ++i) {
+      const unsigned number { channels[i].number };
+      assert(number <= ADC_config::max_channel && "ADC channels are 0 to 18");
+      sequence[i / 6] |= (number & 0x1Fu) << (5 * (i % 6));
+      sample_times[number / 10] |= std::uint32_t(channels[i].sample_time) << (3 * (number % 10));
+    }
+    sequence[2] |= Registers::SQR1::L::value(channel_count - 1).bits;
+
+    Registers::CR2::write(0);
+    Registers::SQR3::write(sequence[0]);
+    Registers::SQR2::write(sequence[1]);
+    Registers::SQR1::write(sequence[2]);
+    Registers::SMPR2::write(sample_times[0]);
+    Registers::SMPR1::write(sample_times[1]);
+
+    // 12-bit, right-aligned scans of the sequence on each trigger,
+    // with a DMA request per conversion and an interrupt on overrun
+    //
+    CR1::write(CR1::SCAN::set | CR1::OVRIE::set | CR1::RES::template value<0>());
+    CR2::write(
+      CR2::EXTEN::template value<CR2::rising_edge>()                    |
+      CR2::EXTSEL::value(ADC_config::trigger_info(trigger).extsel)      |
+      CR2::DMA::set                                                     |
+      CR2::DDS::set
+    );
+    Registers::SR::write(0);
+  }
+
+} // namespace STM32F407
+
+#endif // ADC_H_
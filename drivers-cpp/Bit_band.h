@@ -0,0 +1,172 @@
+// Bit_band.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef BIT_BAND_H
+#define BIT_BAND_H
+
+#include <cstdint>
+#include "Memory_map.h"
+#include "Register.h"
+
+// -------------------------------------------------------------------------------------
+// Cortex-M4 bit-band access.
+//
+// The first 1MB of the SRAM and peripheral regions is mirrored by a
+// 32MB alias region in which each word maps onto a single bit. A
+// store to the alias word is performed by the bus as one atomic
+// read-modify-write, so setting or clearing a bit cannot corrupt
+// bits changed concurrently by a task or ISR, without disabling
+// interrupts.
+//
+//   Bit_band::set<USART3::CR1::RXNEIE>();     // register field
+//   Bit_band::set(RCC_base + 0x30, GPIO_D);   // register address, bit
+//
+//   Bit_band::Flags events { };               // SRAM flag word
+//   events.set(3);
+//
+// Bit-band only covers 0x20000000-0x200FFFFF and 0x40000000-0x400FFFFF;
+// CCM RAM (0x10000000) is not bit-banded so Flags objects must not be
+// placed there.
+//
+// Host builds (FEABHAS_HOST_PERIPHERALS) have no alias region:
+// peripheral bits fall back to a read-modify-write of the simulated
+// register and Flags use the compiler's atomic operations.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  namespace Bit_band
+  {
+    constexpr uintptr_t region_size           { 0x00100000 };
+    constexpr uintptr_t SRAM_alias_base       { 0x22000000 };
+    constexpr uintptr_t Peripheral_alias_base { 0x42000000 };
+
+    constexpr bool in_region(uintptr_t address)
+    {
+      return (address >= SRAM_base && address < SRAM_base + region_size) ||
+             (address >= Peripheral_base && address < Peripheral_base + region_size);
+    }
+
+    // Alias word for bit 'bit' of the word at 'address'
+    // (bit-band region only)
+    //
+    constexpr uintptr_t alias(uintptr_t address, unsigned bit)
+    {
+      return (address & 0xF0000000) + 0x02000000 + ((address & 0x000FFFFF) * 32) + (bit * 4);
+    }
+
+    static_assert(alias(SRAM_base, 0)       == SRAM_alias_base,       "SRAM alias");
+    static_assert(alias(Peripheral_base, 0) == Peripheral_alias_base, "Peripheral alias");
+    static_assert(alias(RCC_base + 0x30, 3) == 0x42470000 + 0x30 * 32 + 3 * 4, "RCC alias");
+
+
+    // Single peripheral register bits
+    //
+    inline void set(uintptr_t address, unsigned bit)
+    {
+#if defined(FEABHAS_HOST_PERIPHERALS)
+      peripheral(address) = peripheral(address) | (0x1u << bit);
+#else
+      peripheral(alias(address, bit)) = 1;
+#endif
+    }
+
+    inline void clear(uintptr_t address, unsigned bit)
+    {
+#if defined(FEABHAS_HOST_PERIPHERALS)
+      peripheral(address) = peripheral(address) & ~(0x1u << bit);
+#else
+      peripheral(alias(address, bit)) = 0;
+#endif
+    }
+
+    inline bool is_set(uintptr_t address, unsigned bit)
+    {
+#if defined(FEABHAS_HOST_PERIPHERALS)
+      return (peripheral(address) & (0x1u << bit)) != 0;
+#else
+      return peripheral(alias(address, bit)) != 0;
+#endif
+    }
+
+
+    // Single-bit fields of a Register<> type
+    //
+    template <typename Field_Ty>
+    inline void set()
+    {
+      static_assert(Field_Ty::size == 1, "Bit-band access is for single-bit fields");
+      static_assert(in_region(Field_Ty::Register_type::address), "Register is not bit-banded");
+      set(Field_Ty::Register_type::address, Field_Ty::position);
+    }
+
+    template <typename Field_Ty>
+    inline void clear()
+    {
+      static_assert(Field_Ty::size == 1, "Bit-band access is for single-bit fields");
+      static_assert(in_region(Field_Ty::Register_type::address), "Register is not bit-banded");
+      clear(Field_Ty::Register_type::address, Field_Ty::position);
+    }
+
+    template <typename Field_Ty>
+    inline bool is_set()
+    {
+      static_assert(Field_Ty::size == 1, "Bit-band access is for single-bit fields");
+      static_assert(in_region(Field_Ty::Register_type::address), "Register is not bit-banded");
+      return is_set(Field_Ty::Register_type::address, Field_Ty::position);
+    }
+
+
+    // A word of flags in SRAM that tasks and ISRs can set and
+    // clear individually without locking.
+    //
+    class Flags
+    {
+    public:
+      constexpr Flags() = default;
+      constexpr explicit Flags(std::uint32_t init) : word { init } { }
+
+      void set(unsigned bit)
+      {
+#if defined(FEABHAS_HOST_PERIPHERALS)
+        __atomic_fetch_or(&word, 0x1u << bit, __ATOMIC_SEQ_CST);
+#else
+        *alias_of(bit) = 1;
+#endif
+      }
+
+      void clear(unsigned bit)
+      {
+#if defined(FEABHAS_HOST_PERIPHERALS)
+        __atomic_fetch_and(&word, ~(0x1u << bit), __ATOMIC_SEQ_CST);
+#else
+        *alias_of(bit) = 0;
+#endif
+      }
+
+      bool is_set(unsigned bit) const
+      {
+        return (word & (0x1u << bit)) != 0;
+      }
+
+      std::uint32_t value() const { return word; }
+
+    private:
+#if !defined(FEABHAS_HOST_PERIPHERALS)
+      volatile std::uint32_t* alias_of(unsigned bit)
+      {
+        return reinterpret_cast<volatile std::uint32_t*>(
+          alias(reinterpret_cast<uintptr_t>(&word), bit));
+      }
+#endif
+
+      volatile std::uint32_t word { };
+    };
+
+  } // namespace Bit_band
+
+} // namespace STM32F407
+
+#endif // BIT_BAND_H_
@@ -0,0 +1,188 @@
+// DMA.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef DMA_H
+#define DMA_H
+
+#include <cassert>
+#include <cstdint>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "NVIC.h"
+#include "DMA_registers.h"
+
+// -------------------------------------------------------------------------------------
+// DMA stream access for the peripheral drivers.
+//
+// DMA::Stream<controller, stream> resolves the registers, flags and
+// interrupt of one stream at compile time. start() programs a
+// complete transfer; the driver that owns the stream calls
+// interrupt_flags() from the stream's IRQ handler.
+//
+// The DMA controllers cannot access the CCM RAM at 0x10000000, so
+// DMA buffers must be in SRAM. Objects marked FEABHAS_CCM_* (see
+// memory_sections.h) are in CCM RAM, and with the CCMRAM build option
+// so are the main stack and the RTOS idle and timer task stacks: none
+// of these can hold a DMA buffer. The heap, and so feabhOS task
+// stacks, stays in SRAM. start() asserts that the buffer is not in
+// CCM RAM.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  namespace DMA
+  {
+    enum class Direction : std::uint32_t { peripheral_to_memory = 0x0, memory_to_peripheral = 0x1, memory_to_memory = 0x2 };
+
+    enum class Size : std::uint32_t { byte = 0x0, half_word = 0x1, word = 0x2 };
+
+    enum class Priority : std::uint32_t { low = 0x0, medium = 0x1, high = 0x2, very_high = 0x3 };
+
+    // Transfer description; item size is the same at both ends
+    // (direct mode, no FIFO packing)
+    //
+    struct Transfer
+    {
+      std::uint32_t         channel;            // Request channel (0-7)
+      Direction             direction;
+      uintptr_t             peripheral;         // Peripheral data register
+      const volatile void*  memory;             // First memory buffer
+      std::uint16_t         count;              // Items to transfer
+      Size                  size;
+      Priority              priority      { Priority::medium };
+      bool                  memory_increment { true };
+      bool                  circular      { false };
+      bool                  half_transfer_interrupt { false };
+      bool                  complete_interrupt      { true };
+    };
+
+
+    template <unsigned controller, unsigned stream_>
+    class Stream
+    {
+    public:
+      static_assert(controller == 1 || controller == 2, "DMA controllers are 1 and 2");
+
+      static constexpr unsigned stream { stream_ };
+
+      using Registers = DMA_config::Registers<(controller == 1) ? DMA1_base : DMA2_base>;
+      using CR        = typename Registers::template Stream<stream_>::CR;
+      using NDTR      = typename Registers::template Stream<stream_>::NDTR;
+      using PAR       = typename Registers::template Stream<stream_>::PAR;
+      using M0AR      = typename Registers::template Stream<stream_>::M0AR;
+      using M1AR      = typename Registers::template Stream<stream_>::M1AR;
+      using FCR       = typename Registers::template Stream<stream_>::FCR;
+
+      static constexpr IRQ_number irq {
+        (controller == 1) ? ((stream_ < 7) ? IRQ_number(DMA1_Stream0_IRQ + stream_) : DMA1_Stream7_IRQ)
+                          : ((stream_ < 5) ? IRQ_number(DMA2_Stream0_IRQ + stream_)
+                                           : IRQ_number(DMA2_Stream5_IRQ + (stream_ - 5)))
+      };
+
+      static void enable_clock()
+      {
+        STM32F407::enable((controller == 1) ? DMA_1 : DMA_2);
+      }
+
+      // Disable the stream; any transfer in progress completes
+      // its current item first
+      //
+      static void stop()
+      {
+        CR::modify(CR::EN::clear);
+        while (CR::EN::is_set())
+        {
+          ; // Wait...
+        }
+      }
+
+      static void start(const Transfer& transfer)
+      {
+        assert(!in_ccmram(transfer.memory) && "DMA cannot access CCM RAM");
+
+        stop();
+        clear(DMA_config::Flags::all);
+
+        PAR::write(static_cast<std::uint32_t>(transfer.peripheral));
+        M0AR::write(static_cast<std::uint32_t>(reinterpret_cast<uintptr_t>(transfer.memory)));
+        NDTR::write(transfer.count);
+        FCR::write(FCR::DMDIS::clear);
+
+        CR::write(
+          CR::CHSEL::value(transfer.channel)                          |
+          CR::PL::value(std::uint32_t(transfer.priority))             |
+          CR::MSIZE::value(std::uint32_t(transfer.size))              |
+          CR::PSIZE::value(std::uint32_t(transfer.size))              |
+          CR::MINC::value(transfer.memory_increment)                  |
+          CR::CIRC::value(transfer.circular)                          |
+          CR::DIR::value(std::uint32_t(transfer.direction))           |
+          CR::HTIE::value(transfer.half_transfer_interrupt)           |
+          CR::TCIE::value(transfer.complete_interrupt)                |
+          CR::TEIE::set
+        );
+        CR::modify(CR::EN::set);
+      }
+
+      // Re-arm a stream that start() configured: transfer 'count'
+      // items from the start of the memory buffer again
+      //
+      static void restart(std::uint16_t count)
+      {
+        stop();
+        clear(DMA_config::Flags::all);
+        NDTR::write(count);
+        CR::modify(CR::EN::set);
+      }
+
+      // Items left to transfer
+      //
+      static std::uint16_t remaining()
+      {
+        return static_cast<std::uint16_t>(NDTR::read());
+      }
+
+      // The stream's DMA_config::Flags that are set
+      //
+      static std::uint32_t flags()
+      {
+        const std::uint32_t status { (stream_ < 4) ? Registers::LISR::read() : Registers::HISR::read() };
+        return (status >> DMA_config::Flags::offset(stream_)) & DMA_config::Flags::all;
+      }
+
+      static void clear(std::uint32_t flags_to_clear)
+      {
+        const std::uint32_t bits { (flags_to_clear & DMA_config::Flags::all) << DMA_config::Flags::offset(stream_) };
+        if constexpr (stream_ < 4) {
+          Registers::LIFCR::write(bits);
+        }
+        else {
+          Registers::HIFCR::write(bits);
+        }
+      }
+
+      // For the IRQ handler: return the flags that are set
+      // and clear them
+      //
+      static std::uint32_t interrupt_flags()
+      {
+        const std::uint32_t set { flags() };
+        clear(set);
+        return set;
+      }
+
+    private:
+      static bool in_ccmram(const volatile void* memory)
+      {
+        const uintptr_t address { reinterpret_cast<uintptr_t>(memory) };
+        return (address >= CCMRAM_base) && (address < (CCMRAM_base + CCMRAM_size));
+      }
+    };
+
+  } // namespace DMA
+
+} // namespace STM32F407
+
+#endif // DMA_H_
@@ -0,0 +1,133 @@
+// DMA_registers.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef DMA_REGISTERS_H
+#define DMA_REGISTERS_H
+
+#include <cstdint>
+#include "Memory_map.h"
+#include "Register.h"
+
+namespace STM32F407
+{
+  namespace DMA_config
+  {
+    // ---------------------------------------------------------------------
+    // DMA controller register definitions (RM0090 section 10.5)
+    //
+    template <uintptr_t base>
+    struct Registers
+    {
+      // Interrupt status for streams 0-3 (LISR) and 4-7 (HISR), and
+      // the matching write-1-to-clear registers. Each stream has a
+      // group of flags at Flags::offset(stream)
+      //
+      struct LISR  : Register<LISR,  base + 0x00, Access::read_only>  { };
+      struct HISR  : Register<HISR,  base + 0x04, Access::read_only>  { };
+      struct LIFCR : Register<LIFCR, base + 0x08, Access::write_only> { };
+      struct HIFCR : Register<HIFCR, base + 0x0C, Access::write_only> { };
+
+      // Per-stream registers, stream 0-7
+      //
+      template <unsigned stream>
+      struct Stream
+      {
+        static_assert(stream < 8, "DMA streams are numbered 0-7");
+
+        static constexpr uintptr_t stream_base { base + 0x10 + (0x18 * stream) };
+
+        // Configuration
+        //
+        struct CR : Register<CR, stream_base + 0x00>
+        {
+          using EN     = Field<CR, 0, 1>;     // Stream enable
+          using DMEIE  = Field<CR, 1, 1>;     // Direct mode error interrupt enable
+          using TEIE   = Field<CR, 2, 1>;     // Transfer error interrupt enable
+          using HTIE   = Field<CR, 3, 1>;     // Half transfer interrupt enable
+          using TCIE   = Field<CR, 4, 1>;     // Transfer complete interrupt enable
+          using PFCTRL = Field<CR, 5, 1>;     // Peripheral flow controller
+          using DIR    = Field<CR, 6, 2>;     // Data transfer direction
+          using CIRC   = Field<CR, 8, 1>;     // Circular mode
+          using PINC   = Field<CR, 9, 1>;     // Peripheral increment
+          using MINC   = Field<CR, 10, 1>;    // Memory increment
+          using PSIZE  = Field<CR, 11, 2>;    // Peripheral data size
+          using MSIZE  = Field<CR, 13, 2>;    // Memory data size
+          using PINCOS = Field<CR, 15, 1>;    // Peripheral increment offset size
+          using PL     = Field<CR, 16, 2>;    // Priority level
+          using DBM    = Field<CR, 18, 1>;    // Double buffer mode
+          using CT     = Field<CR, 19, 1>;    // Current target (double buffer)
+          using PBURST = Field<CR, 21, 2>;    // Peripheral burst
+          using MBURST = Field<CR, 23, 2>;    // Memory burst
+          using CHSEL  = Field<CR, 25, 3>;    // Request channel
+
+          static constexpr std::uint32_t peripheral_to_memory { 0x0 };
+          static constexpr std::uint32_t memory_to_peripheral { 0x1 };
+          static constexpr std::uint32_t memory_to_memory     { 0x2 };
+
+          static constexpr std::uint32_t byte      { 0x0 };
+          static constexpr std::uint32_t half_word { 0x1 };
+          static constexpr std::uint32_t word      { 0x2 };
+        };
+
+        // Number of data items left to transfer
+        //
+        struct NDTR : Register<NDTR, stream_base + 0x04>
+        {
+          using NDT = Field<NDTR, 0, 16>;
+        };
+
+        // Peripheral and memory addresses
+        //
+        struct PAR  : Register<PAR,  stream_base + 0x08> { };
+        struct M0AR : Register<M0AR, stream_base + 0x0C> { };
+        struct M1AR : Register<M1AR, stream_base + 0x10> { };
+
+        // FIFO control
+        //
+        struct FCR : Register<FCR, stream_base + 0x14>
+        {
+          using FTH   = Field<FCR, 0, 2>;     // FIFO threshold
+          using DMDIS = Field<FCR, 2, 1>;     // Direct mode disable
+          using FS    = Field<FCR, 3, 3>;     // FIFO status
+          using FEIE  = Field<FCR, 7, 1>;     // FIFO error interrupt enable
+        };
+      };
+    };
+
+
+    // A stream and the request channel a peripheral uses on it
+    //
+    struct Stream_id
+    {
+      unsigned controller;    // 1 or 2
+      unsigned stream;        // 0-7
+      unsigned channel;       // 0-7
+    };
+
+
+    // Stream interrupt flags, as a group; shift by offset(stream)
+    // for their position in LISR/HISR and LIFCR/HIFCR
+    //
+    namespace Flags
+    {
+      constexpr std::uint32_t FEIF  { 0x1u << 0 };   // FIFO error
+      constexpr std::uint32_t DMEIF { 0x1u << 2 };   // Direct mode error
+      constexpr std::uint32_t TEIF  { 0x1u << 3 };   // Transfer error
+      constexpr std::uint32_t HTIF  { 0x1u << 4 };   // Half transfer
+      constexpr std::uint32_t TCIF  { 0x1u << 5 };   // Transfer complete
+      constexpr std::uint32_t all   { FEIF | DMEIF | TEIF | HTIF | TCIF };
+
+      constexpr unsigned offset(unsigned stream)
+      {
+        constexpr unsigned offsets[] { 0, 6, 16, 22 };
+        return offsets[stream % 4];
+      }
+    }
+
+  } // namespace DMA_config
+
+} // namespace STM32F407
+
+#endif // DMA_REGISTERS_H_
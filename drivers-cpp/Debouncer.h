@@ -0,0 +1,126 @@
+// Debouncer.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef DEBOUNCER_H
+#define DEBOUNCER_H
+
+#include <cstdint>
+
+// -------------------------------------------------------------------------------------
+// Switch debouncing for a whole input port at once.
+//
+// Each input has a 2-bit counter of consecutive samples that differ
+// from its debounced state. Rather than one counter per input, bit n
+// of 'count_0' and 'count_1' together form input n's counter (a
+// vertical counter), so every input is counted in parallel with a few
+// bitwise operations and no branches:
+//
+//   changed  = sample ^ state      inputs differing from their state
+//   count_1  = (count_1 ^ count_0) & changed
+//   count_0  = ~count_0 & changed  counters of unchanged inputs reset
+//   toggle   = changed & ~(count_0 | count_1)
+//
+// An input's state therefore changes after four consecutive samples
+// at the new level; a shorter glitch resets its counter. The debounce
+// time is four sample periods: Debounced_inputs samples every 5ms by
+// default, giving 20ms.
+//
+// sample() returns the inputs that changed on that sample as rising
+// (now set) and falling (now clear) edge masks.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  template <typename Word_Ty = std::uint16_t>
+  struct Edges
+  {
+    Word_Ty rising;
+    Word_Ty falling;
+
+    bool any() const { return (rising | falling) != 0; }
+  };
+
+
+  template <typename Word_Ty = std::uint16_t>
+  class Debouncer
+  {
+  public:
+    constexpr Debouncer() = default;
+    constexpr explicit Debouncer(Word_Ty initial) : debounced { initial } { }
+
+    Edges<Word_Ty> sample(Word_Ty input)
+    {
+      const Word_Ty changed = static_cast<Word_Ty>(input ^ debounced);
+      count_1 = static_cast<Word_Ty>((count_1 ^ count_0) & changed);
+      count_0 = static_cast<Word_Ty>(~count_0 & changed);
+
+      const Word_Ty toggle = static_cast<Word_Ty>(changed & ~(count_0 | count_1));
+      debounced = static_cast<Word_Ty>(debounced ^ toggle);
+
+      return Edges<Word_Ty> {
+        static_cast<Word_Ty>(toggle & debounced),
+        static_cast<Word_Ty>(toggle & ~debounced)
+      };
+    }
+
+    Word_Ty state() const { return debounced; }
+
+  private:
+    Word_Ty debounced { };
+    Word_Ty count_0   { };
+    Word_Ty count_1   { };
+  };
+
+
+  // -----------------------------------------------------------------------------------
+  // Debounced inputs read from a GPIO Port or Pin_group (any type
+  // with a static read()), sampled on every 'ticks_per_sample'th
+  // call of tick() from a timer tick (see set_tick_handler() in
+  // Timer.h, which ticks every 1ms). Edges are passed to 'handler'
+  // in the tick's interrupt context; the handler should only post
+  // them on, for example set feabhOS event flags or notify a task.
+  //
+  //   Debounced_inputs<WMS::Buttons> buttons { on_buttons };
+  //   void tick() { buttons.tick(); }
+  //   set_tick_handler(tick);
+  //
+  template <typename Inputs_Ty, unsigned ticks_per_sample = 5>
+  class Debounced_inputs
+  {
+  public:
+    static_assert(ticks_per_sample >= 1, "Inputs are sampled at most once per tick");
+
+    using Handler = void (*)(Edges<std::uint16_t> edges, void* context);
+
+    explicit Debounced_inputs(Handler callback, void* callback_context = nullptr) :
+      debouncer { static_cast<std::uint16_t>(Inputs_Ty::read()) },
+      handler   { callback },
+      context   { callback_context }
+    {
+    }
+
+    void tick()
+    {
+      if (++ticks < ticks_per_sample) return;
+      ticks = 0;
+
+      const auto edges = debouncer.sample(static_cast<std::uint16_t>(Inputs_Ty::read()));
+      if (edges.any() && handler != nullptr) {
+        handler(edges, context);
+      }
+    }
+
+    std::uint16_t state() const { return debouncer.state(); }
+
+  private:
+    Debouncer<std::uint16_t> debouncer;
+    Handler                  handler;
+    void*                    context;
+    unsigned                 ticks { };
+  };
+
+} // namespace STM32F407
+
+#endif // DEBOUNCER_H_
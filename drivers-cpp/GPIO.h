@@ -0,0 +1,252 @@
+// GPIO.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <cstdint>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "GPIO_registers.h"
+
+// -------------------------------------------------------------------------------------
+// GPIO port driver.
+//
+// Port<GPIO_D> accesses a whole port; Pin_group<GPIO_D, 8, 11> a run
+// of adjacent pins treated as one value, with pin 'first' as bit 0;
+// Pin<GPIO_D, 12> a single pin. Pin is also how the peripheral
+// drivers (USART, SPI, PWM, ...) are given their pins:
+//
+//   using Display = GPIO::Pin_group<GPIO_D, 8, 11>;
+//   Display::make_output();
+//   Display::write(7);                    // pins 8-10 high, 11 low
+//   auto keys = GPIO::Port<GPIO_D>::read();
+//   GPIO::Pin<GPIO_B, 10>::set_alternate<7, GPIO::Pull::up>();
+//
+// Outputs are changed through BSRR, so writing a group, or any set of
+// pins on a port, is a single store that atomically sets and clears
+// the pins given without a read-modify-write of ODR; other pins on
+// the port, possibly driven by other tasks or ISRs, are unaffected.
+// Inputs are read from IDR in one load.
+//
+// Mode, speed, pull and alternate function configuration is a
+// read-modify-write of each configuration register covering every
+// pin in the group. The port clock must be enabled first.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  namespace GPIO
+  {
+    // Configuration values are the MODER, PUPDR and OSPEEDR
+    // field encodings (GPIO_registers.h), which are the same
+    // for every port
+    //
+    using Encoding = GPIO_config::Registers<device_base_address(GPIO_A)>;
+
+    enum class Mode : std::uint32_t {
+      input     = Encoding::MODER::input,
+      output    = Encoding::MODER::output,
+      alternate = Encoding::MODER::alternate,
+      analog    = Encoding::MODER::analog
+    };
+
+    enum class Pull : std::uint32_t {
+      none = Encoding::PUPDR::none,
+      up   = Encoding::PUPDR::pull_up,
+      down = Encoding::PUPDR::pull_down
+    };
+
+    enum class Speed : std::uint32_t {
+      low    = Encoding::OSPEEDR::low,
+      medium = Encoding::OSPEEDR::medium,
+      fast   = Encoding::OSPEEDR::fast,
+      high   = Encoding::OSPEEDR::high
+    };
+
+    // Replicate a configuration value into the 'width'-bit field of
+    // each pin in 'pins'; 2-bit MODER/OSPEEDR/PUPDR fields, or
+    // 4-bit AFRL fields (pins 0-7)
+    //
+    constexpr std::uint32_t spread(std::uint32_t pins, std::uint32_t value, unsigned width = 2)
+    {
+      std::uint32_t result { };
+      for (unsigned pin = 0; pin < (32 / width); ++pin) {
+        if ((pins & (0x1u << pin)) != 0) result |= (value << (width * pin));
+      }
+      return result;
+    }
+
+
+    template <AHB1_Device port_>
+    class Port
+    {
+    public:
+      static constexpr AHB1_Device port { port_ };
+
+      using Registers = GPIO_config::Registers<device_base_address(port_)>;
+
+      static void enable_clock()  { STM32F407::enable(port_); }
+      static void disable_clock() { STM32F407::disable(port_); }
+
+      // Configure the pins in 'pins' (bit n is pin n)
+      //
+      static void set_mode(std::uint16_t pins, Mode mode)
+      {
+        using MODER = typename Registers::MODER;
+        MODER::modify(Field_values<MODER> { spread(pins, 0x3), spread(pins, std::uint32_t(mode)) });
+      }
+
+      static void set_pull(std::uint16_t pins, Pull pull)
+      {
+        using PUPDR = typename Registers::PUPDR;
+        PUPDR::modify(Field_values<PUPDR> { spread(pins, 0x3), spread(pins, std::uint32_t(pull)) });
+      }
+
+      static void set_speed(std::uint16_t pins, Speed speed)
+      {
+        using OSPEEDR = typename Registers::OSPEEDR;
+        OSPEEDR::modify(Field_values<OSPEEDR> { spread(pins, 0x3), spread(pins, std::uint32_t(speed)) });
+      }
+
+      static void set_open_drain(std::uint16_t pins)
+      {
+        Registers::OTYPER::modify(Field_values<typename Registers::OTYPER> { pins, pins });
+      }
+
+      // Select peripheral alternate function 'function' (AF0-AF15);
+      // AFRL holds pins 0-7 and AFRH pins 8-15
+      //
+      static void set_function(std::uint16_t pins, std::uint32_t function)
+      {
+        using AFRL = typename Registers::AFRL;
+        using AFRH = typename Registers::AFRH;
+        const std::uint32_t low  { pins & 0xFFu };
+        const std::uint32_t high { std::uint32_t(pins) >> 8 };
+
+        if (low != 0)  AFRL::modify(Field_values<AFRL> { spread(low, 0xF, 4),  spread(low, function, 4) });
+        if (high != 0) AFRH::modify(Field_values<AFRH> { spread(high, 0xF, 4), spread(high, function, 4) });
+      }
+
+      // Input and output levels, bit n is pin n
+      //
+      static std::uint16_t read()
+      {
+        return static_cast<std::uint16_t>(Registers::IDR::read());
+      }
+
+      static std::uint16_t read_output()
+      {
+        return static_cast<std::uint16_t>(Registers::ODR::read());
+      }
+
+      // Set the pins in 'pins' to the matching bits of 'value',
+      // leaving the others unchanged; one BSRR store
+      //
+      static void write(std::uint16_t pins, std::uint16_t value)
+      {
+        const std::uint32_t high { std::uint32_t(pins) & value };
+        const std::uint32_t low  { std::uint32_t(pins) & ~std::uint32_t(value) };
+        Registers::BSRR::write(high | (low << 16));
+      }
+
+      static void set(std::uint16_t pins)   { Registers::BSRR::write(pins); }
+      static void clear(std::uint16_t pins) { Registers::BSRR::write(std::uint32_t(pins) << 16); }
+
+      // Invert the pins in 'pins'. ODR is read, so concurrent
+      // changes to the same pins may be lost; other pins are safe
+      //
+      static void toggle(std::uint16_t pins)
+      {
+        write(pins, static_cast<std::uint16_t>(~read_output()));
+      }
+    };
+
+
+    template <AHB1_Device port_, unsigned first_, unsigned last_ = first_>
+    class Pin_group
+    {
+    public:
+      static_assert(first_ <= last_ && last_ < 16, "Pins must be 0-15, first <= last");
+
+      using Port = GPIO::Port<port_>;
+
+      static constexpr AHB1_Device   port  { port_ };
+      static constexpr unsigned      first { first_ };
+      static constexpr unsigned      width { last_ - first_ + 1 };
+      static constexpr std::uint32_t max   { (0x1u << width) - 1 };
+      static constexpr std::uint16_t mask  { static_cast<std::uint16_t>(max << first_) };
+
+      static void make_output(Speed speed = Speed::low)
+      {
+        Port::set_speed(mask, speed);
+        Port::set_mode(mask, Mode::output);
+      }
+
+      static void make_input(Pull pull = Pull::none)
+      {
+        Port::set_mode(mask, Mode::input);
+        Port::set_pull(mask, pull);
+      }
+
+      // Connect the pins to peripheral alternate function
+      // 'function' (AF0-AF15), high speed
+      //
+      template <std::uint32_t function, Pull pull = Pull::none>
+      static void set_alternate()
+      {
+        static_assert(function < 16, "Alternate functions are AF0-AF15");
+
+        Port::set_function(mask, function);
+        Port::set_mode(mask, Mode::alternate);
+        Port::set_speed(mask, Speed::high);
+        Port::set_pull(mask, pull);
+      }
+
+      static void set_open_drain() { Port::set_open_drain(mask); }
+
+      // The group's value, pin 'first' is bit 0
+      //
+      static std::uint32_t read()
+      {
+        return (std::uint32_t(Port::read()) & mask) >> first_;
+      }
+
+      static std::uint32_t read_output()
+      {
+        return (std::uint32_t(Port::read_output()) & mask) >> first_;
+      }
+
+      // Drive every pin in the group in one BSRR store;
+      // bits of 'value' beyond the group are ignored
+      //
+      static void write(std::uint32_t value)
+      {
+        const std::uint32_t high { (value << first_) & mask };
+        const std::uint32_t low  { ~(value << first_) & mask };
+        Port::Registers::BSRR::write(high | (low << 16));
+      }
+
+      static void set()    { Port::set(mask); }
+      static void clear()  { Port::clear(mask); }
+      static void toggle() { Port::toggle(mask); }
+
+      static bool is_set() { return read() != 0; }
+    };
+
+    // A single pin
+    //
+    template <AHB1_Device port_, unsigned number_>
+    struct Pin : Pin_group<port_, number_, number_>
+    {
+      static constexpr unsigned number { number_ };
+    };
+
+  } // namespace GPIO
+
+} // namespace STM32F407
+
+#endif // GPIO_H_
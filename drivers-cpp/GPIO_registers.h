@@ -0,0 +1,105 @@
+// GPIO_registers.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef GPIO_REGISTERS_H
+#define GPIO_REGISTERS_H
+
+#include <cstdint>
+#include "Memory_map.h"
+#include "Register.h"
+
+namespace STM32F407
+{
+  namespace GPIO_config
+  {
+    // ---------------------------------------------------------------------
+    // GPIO register definitions (RM0090 section 8.4)
+    // Per-pin fields are indexed by pin number, for example
+    // MODER::MODE<10>
+    //
+    template <uintptr_t base>
+    struct Registers
+    {
+      // Pin modes
+      //
+      struct MODER : Register<MODER, base + 0x00>
+      {
+        template <unsigned pin> using MODE = Field<MODER, 2 * pin, 2>;
+
+        static constexpr std::uint32_t input     { 0x0 };
+        static constexpr std::uint32_t output    { 0x1 };
+        static constexpr std::uint32_t alternate { 0x2 };
+        static constexpr std::uint32_t analog    { 0x3 };
+      };
+
+      // Output type; push-pull (0) or open drain (1)
+      //
+      struct OTYPER : Register<OTYPER, base + 0x04>
+      {
+        template <unsigned pin> using OT = Field<OTYPER, pin, 1>;
+      };
+
+      // Output speed
+      //
+      struct OSPEEDR : Register<OSPEEDR, base + 0x08>
+      {
+        template <unsigned pin> using OSPEED = Field<OSPEEDR, 2 * pin, 2>;
+
+        static constexpr std::uint32_t low       { 0x0 };
+        static constexpr std::uint32_t medium    { 0x1 };
+        static constexpr std::uint32_t fast      { 0x2 };
+        static constexpr std::uint32_t high      { 0x3 };
+      };
+
+      // Pull-up / pull-down
+      //
+      struct PUPDR : Register<PUPDR, base + 0x0C>
+      {
+        template <unsigned pin> using PUPD = Field<PUPDR, 2 * pin, 2>;
+
+        static constexpr std::uint32_t none      { 0x0 };
+        static constexpr std::uint32_t pull_up   { 0x1 };
+        static constexpr std::uint32_t pull_down { 0x2 };
+      };
+
+      // Input and output data
+      //
+      struct IDR : Register<IDR, base + 0x10, Access::read_only>
+      {
+        template <unsigned pin> using ID = Field<IDR, pin, 1>;
+      };
+
+      struct ODR : Register<ODR, base + 0x14>
+      {
+        template <unsigned pin> using OD = Field<ODR, pin, 1>;
+      };
+
+      // Bit set (low half) / reset (high half); a single write
+      // atomically changes any combination of output pins
+      //
+      struct BSRR : Register<BSRR, base + 0x18, Access::write_only>
+      {
+        template <unsigned pin> using BS = Field<BSRR, pin, 1>;
+        template <unsigned pin> using BR = Field<BSRR, pin + 16, 1>;
+      };
+
+      // Alternate function selection; pins 0-7 (AFRL) and 8-15 (AFRH)
+      //
+      struct AFRL : Register<AFRL, base + 0x20>
+      {
+        template <unsigned pin> using AFSEL = Field<AFRL, 4 * pin, 4>;
+      };
+
+      struct AFRH : Register<AFRH, base + 0x24>
+      {
+        template <unsigned pin> using AFSEL = Field<AFRH, 4 * (pin - 8), 4>;
+      };
+    };
+
+  } // namespace GPIO_config
+
+} // namespace STM32F407
+
+#endif // GPIO_REGISTERS_H_
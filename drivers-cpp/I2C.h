@@ -0,0 +1,781 @@
+// I2C.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef I2C_H
+#define I2C_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "NVIC.h"
+#include "DMA.h"
+#include "GPIO.h"
+#include "Transaction_queue.h"
+#include "system_clock.h"
+
+#if defined(RTOS)
+#include "feabhOS_signal.h"
+#endif
+
+namespace STM32F407
+{
+  namespace I2C_config
+  {
+    // ---------------------------------------------------------------------
+    // I2C register definitions (RM0090 section 27.6)
+    //
+    template <uintptr_t base>
+    struct Registers
+    {
+      struct CR1 : Register<CR1, base + 0x00>
+      {
+        using PE    = Field<CR1, 0, 1>;     // Peripheral enable
+        using START = Field<CR1, 8, 1>;     // Start generation
+        using STOP  = Field<CR1, 9, 1>;     // Stop generation
+        using ACK   = Field<CR1, 10, 1>;    // Acknowledge received bytes
+        using POS   = Field<CR1, 11, 1>;
+        using SWRST = Field<CR1, 15, 1>;    // Software reset
+      };
+
+      struct CR2 : Register<CR2, base + 0x04>
+      {
+        using FREQ    = Field<CR2, 0, 6>;   // PCLK1 in MHz
+        using ITERREN = Field<CR2, 8, 1>;   // Error interrupt enable
+        using ITEVTEN = Field<CR2, 9, 1>;   // Event interrupt enable
+        using ITBUFEN = Field<CR2, 10, 1>;  // Buffer (RXNE / TXE) interrupt enable
+        using DMAEN   = Field<CR2, 11, 1>;  // DMA requests
+        using LAST    = Field<CR2, 12, 1>;  // NACK the last byte of the DMA transfer
+      };
+
+      struct DR : Register<DR, base + 0x10> { };
+
+      // Error flags are cleared by writing 0
+      //
+      struct SR1 : Register<SR1, base + 0x14>
+      {
+        using SB      = Field<SR1, 0, 1>;   // Start condition sent
+        using ADDR    = Field<SR1, 1, 1>;   // Address acknowledged
+        using BTF     = Field<SR1, 2, 1>;   // Byte transfer finished
+        using RXNE    = Field<SR1, 6, 1>;
+        using TXE     = Field<SR1, 7, 1>;
+        using BERR    = Field<SR1, 8, 1>;   // Bus error
+        using ARLO    = Field<SR1, 9, 1>;   // Arbitration lost
+        using AF      = Field<SR1, 10, 1>;  // Acknowledge failure
+        using OVR     = Field<SR1, 11, 1>;  // Overrun / underrun
+        using TIMEOUT = Field<SR1, 14, 1>;
+      };
+
+      struct SR2 : Register<SR2, base + 0x18, Access::read_only>
+      {
+        using MSL  = Field<SR2, 0, 1>;      // Master
+        using BUSY = Field<SR2, 1, 1>;      // Bus busy
+        using TRA  = Field<SR2, 2, 1>;      // Transmitter
+      };
+
+      struct CCR : Register<CCR, base + 0x1C>
+      {
+        using CCR_ = Field<CCR, 0, 12>;     // SCL clock control
+        using DUTY = Field<CCR, 14, 1>;     // Fast mode duty cycle (16/9)
+        using FS   = Field<CCR, 15, 1>;     // Fast mode
+      };
+
+      struct TRISE : Register<TRISE, base + 0x20> { };
+    };
+
+    // ---------------------------------------------------------------------
+    // I2C instances (RM0090 table 42, DS8626 table 9). All three are on
+    // APB1 and use AF4.
+    //
+    // A DMA stream serves one peripheral at a time: I2C1 shares DMA1
+    // stream 5 with USART2 Rx and SPI3 Tx (SPI.h) and stream 6 with
+    // USART2 Tx; I2C2 shares stream 7 with UART5 Tx; I2C3 shares stream
+    // 2 with I2C2 Rx and UART4 Rx, and stream 4 with SPI2 Tx.
+    //
+    enum class Instance { i2c_1, i2c_2, i2c_3 };
+
+    struct Pin_id
+    {
+      AHB1_Device port;
+      unsigned    number;
+    };
+
+    // Unused entries in the pin lists
+    //
+    constexpr Pin_id no_pin { GPIO_A, 16 };
+
+    using DMA_stream = DMA_config::Stream_id;
+
+    struct Instance_info
+    {
+      uintptr_t     base;
+      APB1_Device   clock;
+      IRQ_number    event_irq;
+      IRQ_number    error_irq;
+      DMA_stream    rx_dma;
+      DMA_stream    tx_dma;
+      Pin_id        scl_pins[2];    // Valid pins; the first is the default
+      Pin_id        sda_pins[2];
+    };
+
+    constexpr std::uint32_t alt_function { 4 };
+
+    // Indexed by Instance
+    //
+    inline constexpr Instance_info instances[] {
+      { device_base_address(I2C_1), I2C_1, I2C1_EV_IRQ, I2C1_ER_IRQ, { 1, 5, 1 }, { 1, 6, 1 },
+        { { GPIO_B, 6 },  { GPIO_B, 8 } },  { { GPIO_B, 7 },  { GPIO_B, 9 } } },
+      { device_base_address(I2C_2), I2C_2, I2C2_EV_IRQ, I2C2_ER_IRQ, { 1, 2, 7 }, { 1, 7, 7 },
+        { { GPIO_B, 10 }, { GPIO_F, 1 } },  { { GPIO_B, 11 }, { GPIO_F, 0 } } },
+      { device_base_address(I2C_3), I2C_3, I2C3_EV_IRQ, I2C3_ER_IRQ, { 1, 2, 3 }, { 1, 4, 3 },
+        { { GPIO_A, 8 },  no_pin },         { { GPIO_C, 9 },  no_pin } },
+    };
+
+    constexpr const Instance_info& info(Instance instance)
+    {
+      return instances[static_cast<unsigned>(instance)];
+    }
+
+    constexpr bool pin_in(const Pin_id (&pins)[2], AHB1_Device port, unsigned number)
+    {
+      for (const auto& pin : pins) {
+        if (pin.port == port && pin.number == number) return true;
+      }
+      return false;
+    }
+
+    template <Instance instance>
+    using Default_scl_pin = GPIO::Pin<info(instance).scl_pins[0].port, info(instance).scl_pins[0].number>;
+
+    template <Instance instance>
+    using Default_sda_pin = GPIO::Pin<info(instance).sda_pins[0].port, info(instance).sda_pins[0].number>;
+
+    // ---------------------------------------------------------------------
+    // Bus timing (RM0090 section 27.6.8, 27.6.9).
+    //
+    // Standard mode (up to 100kHz) has equal SCL high and low times of
+    // CCR PCLK1 periods; fast mode (up to 400kHz) a low time of twice the
+    // high time, 3 x CCR periods in all. CCR is rounded up, so the
+    // clock is never faster than requested. TRISE is the maximum SCL
+    // rise time (1000ns, 300ns) in PCLK1 periods, plus one.
+    //
+    // PCLK1 must be a whole number of MHz, 2-42MHz (4MHz or more
+    // for fast mode)
+    //
+    struct Timing
+    {
+      std::uint32_t freq;
+      std::uint32_t ccr;
+      std::uint32_t trise;
+      bool          fast;
+      bool          valid;
+    };
+
+    constexpr Timing timing(std::uint32_t pclk1, std::uint32_t speed)
+    {
+      const std::uint32_t freq { pclk1 / 1000000 };
+      if (speed == 0 || speed > 400000 || freq < 2 || freq > 50) return Timing { };
+
+      if (speed <= 100000) {
+        std::uint32_t ccr { (pclk1 + (2 * speed) - 1) / (2 * speed) };
+        if (ccr < 4) ccr = 4;
+        if (ccr > 0xFFF) return Timing { };
+        return Timing { freq, ccr, freq + 1, false, true };
+      }
+
+      if (freq < 4) return Timing { };
+      std::uint32_t ccr { (pclk1 + (3 * speed) - 1) / (3 * speed) };
+      if (ccr < 1) ccr = 1;
+      return Timing { freq, ccr, ((freq * 300) / 1000) + 1, true, true };
+    }
+
+    static_assert(timing(42000000, 100000).ccr   == 210, "100kHz at PCLK1 42MHz");
+    static_assert(timing(42000000, 100000).trise == 43,  "1000ns rise time at 42MHz");
+    static_assert(timing(42000000, 400000).ccr   == 35,  "400kHz at PCLK1 42MHz");
+    static_assert(timing(42000000, 400000).trise == 13,  "300ns rise time at 42MHz");
+    static_assert(!timing(42000000, 1000000).valid,      "Fast mode plus is not supported");
+
+    // ---------------------------------------------------------------------
+    // Transactions.
+    //
+    // A transaction is a series of segments with one slave. Consecutive
+    // segments in the same direction are one message, so a register
+    // address and its data can be written from separate buffers; a
+    // change of direction is a repeated start with the slave address,
+    // so a register read is a write segment followed by a read
+    // segment. The transaction ends with a stop.
+    //
+    // Read segments must not be empty. An empty write segment on its
+    // own addresses the slave without data, to probe for it.
+    //
+    enum class Direction { write, read };
+
+    struct Segment
+    {
+      Direction     direction;
+      std::uint8_t* data;
+      std::uint16_t length;
+    };
+
+    constexpr Segment write(const std::uint8_t* data, std::uint16_t length)
+    {
+      return Segment { Direction::write, const_cast<std::uint8_t*>(data), length };
+    }
+
+    constexpr Segment read(std::uint8_t* data, std::uint16_t length)
+    {
+      return Segment { Direction::read, data, length };
+    }
+
+    struct Transaction;
+
+    // Called in interrupt context when the transaction has
+    // completed or failed (no acknowledge, bus error or lost
+    // arbitration)
+    //
+    using Handler = void (*)(Transaction& transaction, void* context);
+
+    struct Transaction
+    {
+      std::uint8_t   address;           // 7-bit slave address
+      const Segment* segments;
+      std::size_t    count;
+      Handler        handler  { };
+      void*          context  { };
+
+      volatile Transaction_status status { Transaction_status::idle };
+      Transaction*   next     { };      // Owned by the driver's queue
+    };
+
+#if defined(RTOS)
+    // Handler for tasks waiting on a feabhOS signal;
+    // pass the signal as the context
+    //
+    inline void notify_signal(Transaction&, void* signal)
+    {
+      feabhOS_signal_notify_one_ISR(static_cast<feabhOS_SIGNAL*>(signal));
+    }
+#endif
+
+  } // namespace I2C_config
+
+
+  // -----------------------------------------------------------------------------------
+  // I2C master with a queue of DMA transactions.
+  //
+  // submit() queues a transaction and returns at once. The event
+  // interrupt sequences the start, address and repeated start
+  // conditions; the data of each segment is moved by DMA, with the
+  // hardware NACKing the last byte of a read (CR2 LAST). Single-byte
+  // reads, which DMA cannot end correctly, are read in the event
+  // interrupt. A transaction that is queued when the previous one
+  // ends follows it with a repeated start instead of a stop, so
+  // sensors on one bus are read back to back without a task polling:
+  //
+  //   I2C<I2C_config::Instance::i2c_1> bus { 5, 400'000 };   // NVIC priority, SCL Hz
+  //
+  //   extern "C" void I2C1_EV_IRQHandler()     { bus.event_interrupt(); }
+  //   extern "C" void I2C1_ER_IRQHandler()     { bus.error_interrupt(); }
+  //   extern "C" void DMA1_Stream5_IRQHandler() { bus.dma_interrupt(); }
+  //   extern "C" void DMA1_Stream6_IRQHandler() { bus.dma_interrupt(); }
+  //   void tick() { bus.tick(); }
+  //   set_tick_handler(tick);
+  //
+  //   static const std::uint8_t reg { 0x3B };
+  //   static std::uint8_t sample[14];
+  //   const I2C_config::Segment read_sample[] { I2C_config::write(&reg, 1), I2C_config::read(sample, 14) };
+  //   I2C_config::Transaction transaction { 0x68, read_sample, 2, handler, context };
+  //   bus.submit(transaction);
+  //
+  // The master has no stop-detect interrupt and CR1 must not be
+  // written until a stop has been generated, so a transaction
+  // submitted to a bus that is still stopping (for about one SCL
+  // period, as when a handler resubmits its own transaction) is
+  // started by tick(), from the 1ms timer tick, once CR1.STOP
+  // clears. Queue transactions before the one on the bus ends
+  // to avoid that wait.
+  //
+  // The pins are open-drain with the weak internal pull-ups; a bus
+  // at 400kHz needs external pull-ups. Buffers must be in SRAM
+  // (see DMA.h).
+  //
+  template <I2C_config::Instance instance,
+            typename Scl_pin = I2C_config::Default_scl_pin<instance>,
+            typename Sda_pin = I2C_config::Default_sda_pin<instance>>
+  class I2C
+  {
+  public:
+    static constexpr const I2C_config::Instance_info& config { I2C_config::info(instance) };
+
+    using Registers = I2C_config::Registers<config.base>;
+    using Rx_stream = DMA::Stream<config.rx_dma.controller, config.rx_dma.stream>;
+    using Tx_stream = DMA::Stream<config.tx_dma.controller, config.tx_dma.stream>;
+
+    static_assert(I2C_config::pin_in(config.scl_pins, Scl_pin::port, Scl_pin::number),
+                  "SCL pin cannot be used with this I2C");
+    static_assert(I2C_config::pin_in(config.sda_pins, Sda_pin::port, Sda_pin::number),
+                  "SDA pin cannot be used with this I2C");
+
+    // 'priority' is the NVIC priority of the I2C and DMA stream
+    // interrupts, in which the handlers are called. 'speed' must
+    // be one that set_speed() accepts
+    //
+    I2C(unsigned priority, std::uint32_t speed = 100'000);
+    ~I2C();
+
+    I2C(const I2C&)            = delete;
+    I2C& operator=(const I2C&) = delete;
+
+    // Set the SCL frequency, only while idle. Returns false,
+    // leaving the speed unchanged, if PCLK1 cannot generate it
+    //
+    bool set_speed(std::uint32_t speed);
+
+    // Queue a transaction. From a task or an interrupt handler,
+    // including a transaction's own handler. Returns false,
+    // without queuing it or calling its handler, if the
+    // transaction has no segments
+    //
+    bool submit(I2C_config::Transaction& transaction);
+
+    bool idle() const { return queue.empty(); }
+
+    // Call from the I2C event and error IRQ handlers
+    // and both DMA streams' IRQ handlers
+    //
+    void event_interrupt();
+    void error_interrupt();
+    void dma_interrupt();
+
+    // Call from a periodic interrupt, such as the timer tick
+    // (see set_tick_handler() in Timer.h), to start a transaction
+    // that was submitted while the bus was stopping
+    //
+    void tick();
+
+  private:
+    using CR1 = typename Registers::CR1;
+    using CR2 = typename Registers::CR2;
+    using SR1 = typename Registers::SR1;
+
+    void start(I2C_config::Transaction& transaction);
+    void generate_start();
+    void start_data(bool addressed);
+    void start_dma(const I2C_config::Segment& current);
+    void write_complete(bool bus_idle);
+    void end_message();
+    void next_segment();
+    void abort(Transaction_status result);
+    void finish(Transaction_status result);
+
+    const I2C_config::Segment& current() const { return queue.front()->segments[segment]; }
+
+    // The current segment is the last of its message
+    //
+    bool last_in_message() const
+    {
+      const I2C_config::Transaction& transaction { *queue.front() };
+      return (segment + 1 == transaction.count) ||
+             (transaction.segments[segment + 1].direction != transaction.segments[segment].direction);
+    }
+
+    static void clear_address() { (void)Registers::SR2::read(); }
+
+    Transaction_queue<I2C_config::Transaction> queue { };
+    std::size_t   segment       { };
+    bool          data_sent     { };   // Bytes written since the (repeated) start
+    bool          awaiting_btf  { };   // Last byte of a write message in progress
+    bool          chained       { };   // Repeated start requested for the next transaction
+    volatile bool start_pending { };   // START waits for the previous stop (tick)
+  };
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  I2C<instance, Scl_pin, Sda_pin>::I2C(unsigned priority, std::uint32_t speed)
+  {
+    STM32F407::enable(config.clock);
+    Rx_stream::enable_clock();
+    Tx_stream::enable_clock();
+
+    // Open-drain before the pins are connected
+    //
+    STM32F407::enable(Scl_pin::port);
+    STM32F407::enable(Sda_pin::port);
+    Scl_pin::set_open_drain();
+    Sda_pin::set_open_drain();
+    Scl_pin::template set_alternate<I2C_config::alt_function, GPIO::Pull::up>();
+    Sda_pin::template set_alternate<I2C_config::alt_function, GPIO::Pull::up>();
+
+    CR1::write(CR1::SWRST::set);
+    CR1::write(0);
+    CR2::write(CR2::ITEVTEN::set | CR2::ITERREN::set | CR2::DMAEN::set);
+
+    // An invalid speed leaves the peripheral disabled
+    //
+    [[maybe_unused]] const bool enabled { set_speed(speed) };
+    assert(enabled && "I2C speed cannot be generated from PCLK1");
+
+    constexpr IRQ_number irqs[] { config.event_irq, config.error_irq, Rx_stream::irq, Tx_stream::irq };
+    for (IRQ_number irq : irqs) {
+      NVIC::set_priority(irq, priority);
+      NVIC::enable(irq);
+    }
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  I2C<instance, Scl_pin, Sda_pin>::~I2C()
+  {
+    constexpr IRQ_number irqs[] { config.event_irq, config.error_irq, Rx_stream::irq, Tx_stream::irq };
+    for (IRQ_number irq : irqs) {
+      NVIC::disable(irq);
+    }
+    Tx_stream::stop();
+    Rx_stream::stop();
+    CR2::write(0);
+    CR1::write(0);
+    STM32F407::disable(config.clock);
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  bool I2C<instance, Scl_pin, Sda_pin>::set_speed(std::uint32_t speed)
+  {
+    using CCR = typename Registers::CCR;
+
+    const I2C_config::Timing timing { I2C_config::timing(SystemClock_PCLK1(), speed) };
+    if (!timing.valid) return false;
+
+    // Timing can only be changed while the peripheral is disabled
+    //
+    CR1::modify(CR1::PE::clear);
+    CR2::modify(CR2::FREQ::value(timing.freq));
+    CCR::write(CCR::CCR_::value(timing.ccr) | CCR::FS::value(timing.fast));
+    Registers::TRISE::write(timing.trise);
+    CR1::modify(CR1::PE::set);
+    return true;
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  bool I2C<instance, Scl_pin, Sda_pin>::submit(I2C_config::Transaction& transaction)
+  {
+    // A transaction with no segments would never use the bus,
+    // so could only complete in the caller's context
+    //
+    if (transaction.count == 0) return false;
+
+    if (queue.push(transaction)) {
+      start(transaction);
+    }
+    return true;
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::start(I2C_config::Transaction& transaction)
+  {
+    transaction.status = Transaction_status::active;
+    segment      = 0;
+    awaiting_btf = false;
+
+    // The previous transaction ended with a repeated start
+    // for this one (end_message)
+    //
+    if (chained) {
+      chained = false;
+      return;
+    }
+    generate_start();
+  }
+
+
+  // CR1 must not be written while a stop is being generated
+  // (RM0090 27.6.1) and there is no interrupt when it has been, so
+  // until CR1.STOP clears the start is left to tick(). Interrupts
+  // are masked so tick() cannot request a second start
+  //
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::generate_start()
+  {
+    Interrupt_lock lock { };
+    start_pending = CR1::STOP::is_set();
+    if (!start_pending) {
+      CR1::modify(CR1::START::set);
+    }
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::tick()
+  {
+    if (start_pending) generate_start();
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::event_interrupt()
+  {
+    if (queue.empty()) return;
+
+    // Reading SR1 is the first half of clearing SB and ADDR
+    //
+    const std::uint32_t status { SR1::read() };
+
+    // Single-byte read. Checked before SB: the byte is received
+    // before the repeated start that follows it, which may be
+    // for the next transaction
+    //
+    if ((status & SR1::RXNE::mask) != 0 && CR2::ITBUFEN::is_set()) {
+      current().data[0] = static_cast<std::uint8_t>(Registers::DR::read());
+      CR2::modify(CR2::ITBUFEN::clear);
+      next_segment();
+      return;
+    }
+
+    if ((status & SR1::SB::mask) != 0) {
+      const bool reading { current().direction == I2C_config::Direction::read };
+      Registers::DR::write((std::uint32_t { queue.front()->address } << 1) | (reading ? 0x1u : 0x0u));
+      data_sent = false;
+      return;
+    }
+
+    if ((status & SR1::ADDR::mask) != 0) {
+      start_data(true);
+      return;
+    }
+
+    // The end of a write message. BTF can be seen before the
+    // Tx stream's interrupt if that has a lower priority
+    //
+    if ((status & SR1::BTF::mask) != 0) {
+      if (!awaiting_btf) dma_interrupt();
+      if (awaiting_btf) {
+        awaiting_btf = false;
+        end_message();
+        next_segment();
+      }
+    }
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::error_interrupt()
+  {
+    constexpr std::uint32_t errors {
+      SR1::BERR::mask | SR1::ARLO::mask | SR1::AF::mask | SR1::OVR::mask | SR1::TIMEOUT::mask
+    };
+
+    const std::uint32_t status { SR1::read() };
+    SR1::write(~errors & 0xFFFFu);
+    if (queue.empty()) return;
+
+    // After a NACK or bus error the master still holds the bus;
+    // after lost arbitration it has already released it
+    //
+    if ((status & (SR1::AF::mask | SR1::BERR::mask)) != 0) {
+      CR1::modify(CR1::STOP::set);
+    }
+    abort(Transaction_status::failed);
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::dma_interrupt()
+  {
+    constexpr std::uint32_t errors { DMA_config::Flags::TEIF | DMA_config::Flags::DMEIF };
+
+    const std::uint32_t rx_flags { Rx_stream::interrupt_flags() };
+    const std::uint32_t tx_flags { Tx_stream::interrupt_flags() };
+    if (queue.empty()) return;
+
+    if (((rx_flags | tx_flags) & errors) != 0) {
+      CR1::modify(CR1::STOP::set);
+      abort(Transaction_status::failed);
+      return;
+    }
+
+    if ((tx_flags & DMA_config::Flags::TCIF) != 0) {
+      write_complete(false);
+    }
+
+    // The hardware has NACKed the last byte of a message;
+    // the stop or repeated start follows it
+    //
+    if ((rx_flags & DMA_config::Flags::TCIF) != 0) {
+      if (last_in_message()) end_message();
+      next_segment();
+    }
+  }
+
+
+  // Program the current segment's data transfer. 'addressed' is true
+  // in the ADDR event, which is cleared here once the transfer is
+  // set up; otherwise the segment continues the message
+  //
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::start_data(bool addressed)
+  {
+    const I2C_config::Segment& data { current() };
+    const bool last { last_in_message() };
+
+    if (data.direction == I2C_config::Direction::write) {
+      if (data.length != 0) {
+        start_dma(data);
+        data_sent = true;
+        if (addressed) clear_address();
+      }
+      else {
+        if (addressed) clear_address();
+        write_complete(!data_sent);
+      }
+      return;
+    }
+
+    if (data.length == 0) {
+      if (addressed) clear_address();
+      CR1::modify(CR1::STOP::set);
+      abort(Transaction_status::failed);
+      return;
+    }
+
+    // A single byte is NACKed by clearing ACK before the address
+    // is cleared, and the stop or repeated start is requested at once
+    // (RM0090 27.3.3, figure 242)
+    //
+    if (data.length == 1) {
+      CR1::modify(CR1::ACK::value(!last));
+      CR2::modify(CR2::LAST::clear | CR2::ITBUFEN::set);
+      if (addressed) clear_address();
+      if (last) end_message();
+      return;
+    }
+
+    CR1::modify(CR1::ACK::set);
+    CR2::modify(CR2::LAST::value(last));
+    start_dma(data);
+    if (addressed) clear_address();
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::start_dma(const I2C_config::Segment& data)
+  {
+    const bool reading { data.direction == I2C_config::Direction::read };
+
+    DMA::Transfer transfer { };
+    transfer.channel    = reading ? config.rx_dma.channel : config.tx_dma.channel;
+    transfer.direction  = reading ? DMA::Direction::peripheral_to_memory : DMA::Direction::memory_to_peripheral;
+    transfer.peripheral = Registers::DR::address;
+    transfer.memory     = data.data;
+    transfer.count      = data.length;
+    transfer.size       = DMA::Size::byte;
+
+    if (reading) {
+      Rx_stream::start(transfer);
+    }
+    else {
+      Tx_stream::start(transfer);
+    }
+  }
+
+
+  // All of a write segment's bytes have been written to DR. The last
+  // segment of a message waits for the final byte to leave the shift
+  // register (BTF) before the stop or repeated start, unless nothing
+  // has been sent since the address
+  //
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::write_complete(bool bus_idle)
+  {
+    if (!last_in_message()) {
+      next_segment();
+    }
+    else if (bus_idle) {
+      end_message();
+      next_segment();
+    }
+    else {
+      awaiting_btf = true;
+    }
+  }
+
+
+  // The end of a message: a repeated start for the next message,
+  // or at the end of the transaction a stop, or a repeated start
+  // if another transaction is queued. The queue is locked so a
+  // transaction cannot be queued between the check and the request
+  //
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::end_message()
+  {
+    if (segment + 1 == queue.front()->count) {
+      Interrupt_lock lock { };
+      chained = (queue.front()->next != nullptr);
+      CR1::modify(chained ? CR1::START::set : CR1::STOP::set);
+    }
+    else {
+      CR1::modify(CR1::START::set);
+    }
+  }
+
+
+  // Move to the next segment: the end of the transaction, more data
+  // in the same message, or a new message after the repeated start
+  // requested by end_message() (SB event)
+  //
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::next_segment()
+  {
+    const I2C_config::Transaction& transaction { *queue.front() };
+
+    ++segment;
+    if (segment == transaction.count) {
+      finish(Transaction_status::complete);
+    }
+    else if (transaction.segments[segment].direction == transaction.segments[segment - 1].direction) {
+      start_data(false);
+    }
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::abort(Transaction_status result)
+  {
+    Tx_stream::stop();
+    Rx_stream::stop();
+    CR2::modify(CR2::ITBUFEN::clear | CR2::LAST::clear);
+
+    // The next transaction waits for any stop
+    // requested with the error
+    //
+    chained = false;
+    finish(result);
+  }
+
+
+  template <I2C_config::Instance instance, typename Scl_pin, typename Sda_pin>
+  void I2C<instance, Scl_pin, Sda_pin>::finish(Transaction_status result)
+  {
+    I2C_config::Transaction& done { *queue.front() };
+
+    // Start the next transaction before calling the handler,
+    // which may queue another on this bus
+    //
+    awaiting_btf = false;
+    done.status  = result;
+    I2C_config::Transaction* const next { queue.pop() };
+    if (next != nullptr) start(*next);
+
+    if (done.handler != nullptr) {
+      done.handler(done, done.context);
+    }
+  }
+
+} // namespace STM32F407
+
+#endif // I2C_H_
@@ -9,12 +9,18 @@
 #include <cstdint>
 #include "Peripherals.h"
 
+#if defined(FEABHAS_HOST_PERIPHERALS)
+#include "Peripheral_model.h"
+#endif
+
 namespace STM32F407
 {
   // Base address for devices on the STM32F10x
   //
   constexpr uintptr_t Flash_base      { 0x08000000 };            // FLASH base address
   constexpr uintptr_t SRAM_base       { 0x20000000 };            // SRAM base address in the alias region
+  constexpr uintptr_t CCMRAM_base     { 0x10000000 };            // Core coupled memory (64K), CPU only
+  constexpr uintptr_t CCMRAM_size     { 0x00010000 };
   constexpr uintptr_t Peripheral_base { 0x40000000 };            // Peripheral base address in the alias region
 
   // Peripheral memory map
@@ -23,6 +29,17 @@ namespace STM32F407
   constexpr uintptr_t APB2_base   { Peripheral_base + 0x10000 }; // Advanced Peripheral Bus 2
   constexpr uintptr_t AHB1_base   { Peripheral_base + 0x20000 }; // Advanced High-performance Bus 1
 
+  constexpr uintptr_t RCC_base    { AHB1_base + 0x3800 };        // Reset and clock control
+  constexpr uintptr_t DMA1_base   { AHB1_base + 0x6000 };        // DMA controllers
+  constexpr uintptr_t DMA2_base   { AHB1_base + 0x6400 };
+  constexpr uintptr_t ADC1_base   { APB2_base + 0x2000 };        // ADCs, 0x100 apart, and
+  constexpr uintptr_t ADC_common_base { APB2_base + 0x2300 };    // their common registers
+
+  // Cortex-M4 core peripherals
+  //
+  constexpr uintptr_t SCS_base    { 0xE000E000 };                // System control space
+  constexpr uintptr_t NVIC_base   { SCS_base + 0x100 };          // Interrupt controller
+
   constexpr uintptr_t device_base_address(STM32F407::AHB1_Device device) {
     return STM32F407::AHB1_base + (0x400 * device);
   }
@@ -35,6 +52,21 @@ namespace STM32F407
     return STM32F407::APB2_base + (0x400 * device);
   }
 
+  // Drivers access registers through peripheral() rather than
+  // casting addresses directly. On the target this is a cast; host
+  // builds (FEABHAS_HOST_PERIPHERALS) map the address onto the
+  // simulated register blocks of the peripheral model instead.
+  //
+  template <typename Register_Ty = std::uint32_t>
+  inline volatile Register_Ty& peripheral(uintptr_t address)
+  {
+#if defined(FEABHAS_HOST_PERIPHERALS)
+    return *reinterpret_cast<volatile Register_Ty*>(Host::map(address));
+#else
+    return *reinterpret_cast<volatile Register_Ty*>(address);
+#endif
+  }
+
 } // namespace STM32F407
 
 #endif // MEMORY_MAP_H_
@@ -0,0 +1,168 @@
+// Motor_control.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef MOTOR_CONTROL_H
+#define MOTOR_CONTROL_H
+
+#include <cstdint>
+
+// -------------------------------------------------------------------------------------
+// Closed-loop motor speed control in the PWM timer's update interrupt.
+//
+// Speed_loop runs one step of a PI controller per update event: it
+// polls the Tachometer for the measured speed and sets the next PWM
+// duty cycle. The loop rate is set by the PWM timer, not the
+// scheduler, so it has no task jitter; at 20kHz PWM with an update
+// divider of 2 it runs at 10kHz:
+//
+//   using Drive = PWM<Timer_config::Instance::tim_1, 1, ...>;
+//   using Tacho = Tachometer<Timer_config::Instance::tim_5, 1, ...>;
+//   Drive drive { };
+//   Tacho tacho { };
+//   Speed_loop<Drive, Tacho> motor { drive, tacho, { 0x0400, 0x0010 } };
+//
+//   extern "C" void TIM1_UP_TIM10_IRQHandler() { motor.update_interrupt(); }
+//
+//   tacho.start();
+//   drive.start(20'000, 500, 2);
+//   motor.start(5);                  // NVIC priority
+//   motor.set_speed(50 << 8);        // 50 sensor edges per second
+//
+// Speeds are Tachometer::frequency() units, edges per second in Q24.8.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  // Fixed-point PI controller with anti-windup: while the output is
+  // at a limit the integral only changes in the direction that
+  // brings it back into range.
+  //
+  // Gains are Q16.16; the integral gain is per step, so it includes
+  // the loop period (Ki x T). Errors and outputs are integers in the
+  // caller's units.
+  //
+  class PI_controller
+  {
+  public:
+    struct Gains
+    {
+      std::int32_t kp;
+      std::int32_t ki;
+    };
+
+    constexpr PI_controller(Gains pi_gains, std::int32_t output_min, std::int32_t output_max) :
+      gains   { pi_gains },
+      minimum { output_min },
+      maximum { output_max }
+    {
+    }
+
+    std::int32_t step(std::int32_t error)
+    {
+      const std::int64_t candidate { integral + std::int64_t { gains.ki } * error };
+      std::int64_t output { (std::int64_t { gains.kp } * error + candidate) >> 16 };
+
+      if (output > maximum) {
+        output = maximum;
+        if (error < 0) integral = candidate;
+      }
+      else if (output < minimum) {
+        output = minimum;
+        if (error > 0) integral = candidate;
+      }
+      else {
+        integral = candidate;
+      }
+      return static_cast<std::int32_t>(output);
+    }
+
+    // Restart from 'output', for a bumpless change of setpoint
+    // or after the loop has been stopped
+    //
+    void reset(std::int32_t output = 0)
+    {
+      integral = std::int64_t { output } * 65536;
+    }
+
+    void set_gains(Gains pi_gains) { gains = pi_gains; }
+
+  private:
+    Gains        gains;
+    std::int32_t minimum;
+    std::int32_t maximum;
+    std::int64_t integral { };      // Q16.16, output units
+  };
+
+
+  template <typename PWM_Ty, typename Tachometer_Ty>
+  class Speed_loop
+  {
+  public:
+    Speed_loop(PWM_Ty& drive, Tachometer_Ty& sensor, PI_controller::Gains gains) :
+      pwm        { drive },
+      tachometer { sensor },
+      controller { gains, 0, static_cast<std::int32_t>(PWM_Ty::full_scale) }
+    {
+    }
+
+    Speed_loop(const Speed_loop&)            = delete;
+    Speed_loop& operator=(const Speed_loop&) = delete;
+
+    // Enable the PWM timer's update interrupt. The PWM and the
+    // tachometer must already be started
+    //
+    void start(unsigned priority)
+    {
+      pwm.enable_update_interrupt(priority);
+    }
+
+    void stop()
+    {
+      pwm.disable_update_interrupt();
+      pwm.set_duty(0);
+      controller.reset();
+    }
+
+    // Zero stops the motor (0% duty) and resets the controller
+    //
+    void set_speed(std::uint32_t speed) { target = speed; }
+
+    std::uint32_t speed()  const { return measured; }
+    std::uint32_t duty()   const { return output; }
+
+    // Call from the PWM timer's update IRQ handler
+    //
+    void update_interrupt()
+    {
+      if (!PWM_Ty::update_interrupt()) return;
+
+      tachometer.update();
+      measured = tachometer.frequency();
+
+      const std::uint32_t setpoint { target };
+      if (setpoint == 0) {
+        controller.reset();
+        output = 0;
+      }
+      else {
+        const std::int32_t error { static_cast<std::int32_t>(setpoint) - static_cast<std::int32_t>(measured) };
+        output = static_cast<std::uint32_t>(controller.step(error));
+      }
+      pwm.set_duty(output);
+    }
+
+  private:
+    PWM_Ty&        pwm;
+    Tachometer_Ty& tachometer;
+    PI_controller  controller;
+
+    volatile std::uint32_t target   { };
+    volatile std::uint32_t measured { };
+    volatile std::uint32_t output   { };
+  };
+
+} // namespace STM32F407
+
+#endif // MOTOR_CONTROL_H_
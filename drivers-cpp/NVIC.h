@@ -0,0 +1,89 @@
+// NVIC.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef NVIC_H
+#define NVIC_H
+
+#include <cstdint>
+#include "Memory_map.h"
+
+namespace STM32F407
+{
+  // Interrupt numbers (vector table position - 16)
+  // for the peripherals with drivers
+  //
+  enum IRQ_number
+  {
+    DMA1_Stream0_IRQ  = 11,
+    DMA1_Stream1_IRQ  = 12,
+    DMA1_Stream2_IRQ  = 13,
+    DMA1_Stream3_IRQ  = 14,
+    DMA1_Stream4_IRQ  = 15,
+    DMA1_Stream5_IRQ  = 16,
+    DMA1_Stream6_IRQ  = 17,
+    ADC_IRQ           = 18,
+    TIM1_UP_TIM10_IRQ = 25,
+    TIM2_IRQ          = 28,
+    TIM3_IRQ          = 29,
+    TIM4_IRQ          = 30,
+    I2C1_EV_IRQ       = 31,
+    I2C1_ER_IRQ       = 32,
+    I2C2_EV_IRQ       = 33,
+    I2C2_ER_IRQ       = 34,
+    USART1_IRQ        = 37,
+    USART2_IRQ        = 38,
+    USART3_IRQ        = 39,
+    TIM8_UP_TIM13_IRQ = 44,
+    DMA1_Stream7_IRQ  = 47,
+    TIM5_IRQ          = 50,
+    UART4_IRQ         = 52,
+    UART5_IRQ         = 53,
+    DMA2_Stream0_IRQ  = 56,
+    DMA2_Stream1_IRQ  = 57,
+    DMA2_Stream2_IRQ  = 58,
+    DMA2_Stream3_IRQ  = 59,
+    DMA2_Stream4_IRQ  = 60,
+    DMA2_Stream5_IRQ  = 68,
+    DMA2_Stream6_IRQ  = 69,
+    DMA2_Stream7_IRQ  = 70,
+    USART6_IRQ        = 71,
+    I2C3_EV_IRQ       = 72,
+    I2C3_ER_IRQ       = 73,
+  };
+
+  // Interrupt controller access through the memory map,
+  // equivalent to the CMSIS NVIC_ functions.
+  //
+  namespace NVIC
+  {
+    constexpr uintptr_t set_enable_base   { NVIC_base + 0x000 };
+    constexpr uintptr_t clear_enable_base { NVIC_base + 0x080 };
+    constexpr uintptr_t priority_base     { NVIC_base + 0x300 };
+
+    // The STM32F4 implements the top 4 bits of each priority
+    //
+    constexpr unsigned priority_bits { 4 };
+
+    inline void enable(IRQ_number irq)
+    {
+      peripheral(set_enable_base + 4 * (unsigned(irq) / 32)) = (0x1u << (unsigned(irq) % 32));
+    }
+
+    inline void disable(IRQ_number irq)
+    {
+      peripheral(clear_enable_base + 4 * (unsigned(irq) / 32)) = (0x1u << (unsigned(irq) % 32));
+    }
+
+    inline void set_priority(IRQ_number irq, unsigned priority)
+    {
+      peripheral<std::uint8_t>(priority_base + unsigned(irq)) =
+        static_cast<std::uint8_t>(priority << (8 - priority_bits));
+    }
+
+  } // namespace NVIC
+
+} // namespace STM32F407
+
+#endif // NVIC_H_
@@ -0,0 +1,213 @@
+// PWM.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef PWM_H
+#define PWM_H
+
+#include <cstdint>
+#include <type_traits>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "NVIC.h"
+#include "GPIO.h"
+#include "Timer_registers.h"
+
+// -------------------------------------------------------------------------------------
+// Edge-aligned PWM on one timer channel.
+//
+// The output is active while the counter is below the compare value,
+// so the duty cycle is CCR / (ARR + 1). Compare and reload values are
+// preloaded: a new duty cycle takes effect at the next update event,
+// never part way through a period.
+//
+// On the advanced-control timers (TIM1, TIM8) channels 1-3 can also
+// drive a complementary output for the low side of a half-bridge, with
+// a dead-time inserted at each edge, and the repetition counter divides
+// the update event so that a control loop can run at a submultiple of
+// the PWM frequency:
+//
+//   using Phase = PWM<Timer_config::Instance::tim_1, 1,
+//                     GPIO::Pin<GPIO_E, 9>, GPIO::Pin<GPIO_E, 8>>;
+//   Phase phase { };
+//   phase.start(20'000, 500, 2);     // 20kHz, 500ns dead-time, 10kHz updates
+//   phase.set_duty(Phase::full_scale / 4);
+//
+// Duty cycles are unsigned Q15 fractions: full_scale (0x8000) is 100%.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  template <Timer_config::Instance instance, unsigned channel, typename Out_pin, typename Complementary_pin = void>
+  class PWM
+  {
+  public:
+    static constexpr const Timer_config::Instance_info& config { Timer_config::info(instance) };
+    static constexpr IRQ_number irq { config.update_irq };
+
+    static constexpr std::uint32_t full_scale { 0x8000 };
+
+    static constexpr bool complementary { !std::is_void_v<Complementary_pin> };
+
+    static_assert(channel >= 1 && channel <= 4, "Timer channels are 1-4");
+    static_assert(!complementary || (config.advanced && channel <= 3),
+                  "Complementary outputs are TIM1 and TIM8 channels 1-3");
+
+    using Registers = Timer_config::Registers<config.base>;
+    using CCMR      = std::conditional_t<(channel <= 2), typename Registers::CCMR1, typename Registers::CCMR2>;
+    using CCR       = typename Registers::template CCR<channel>;
+
+    PWM() = default;
+    ~PWM() { stop(); }
+
+    PWM(const PWM&)            = delete;
+    PWM& operator=(const PWM&) = delete;
+
+    // Start with the output inactive (0% duty). 'update_divider'
+    // PWM periods per update event needs the repetition counter
+    // (TIM1, TIM8) if it is not 1. Returns false, leaving the
+    // timer unchanged, if the timer cannot generate the settings
+    //
+    bool start(std::uint32_t frequency, std::uint32_t dead_time_ns = 0, std::uint32_t update_divider = 1);
+    void stop();
+
+    void set_duty(std::uint32_t duty)
+    {
+      const std::uint32_t counts { Registers::ARR::read() + 1 };
+      CCR::write((duty >= full_scale) ? counts
+                                      : static_cast<std::uint32_t>((std::uint64_t { duty } * counts) >> 15));
+    }
+
+    // Timer clocks per PWM period, the duty cycle resolution
+    //
+    std::uint32_t period() const { return Registers::ARR::read() + 1; }
+
+    // Interrupt on each update event, at the start of a period
+    //
+    void enable_update_interrupt(unsigned priority)
+    {
+      Registers::DIER::modify(Registers::DIER::UIE::set);
+      NVIC::set_priority(irq, priority);
+      NVIC::enable(irq);
+    }
+
+    void disable_update_interrupt()
+    {
+      NVIC::disable(irq);
+      Registers::DIER::modify(Registers::DIER::UIE::clear);
+    }
+
+    // For the update IRQ handler: true if an update caused the
+    // interrupt, clearing the flag. SR flags are cleared by
+    // writing 0; other flags are written as 1, unchanged
+    //
+    static bool update_interrupt()
+    {
+      if (!Registers::SR::UIF::is_set()) return false;
+      Registers::SR::write(~Registers::SR::UIF::mask);
+      return true;
+    }
+  };
+
+
+  template <Timer_config::Instance instance, unsigned channel, typename Out_pin, typename Complementary_pin>
+  bool PWM<instance, channel, Out_pin, Complementary_pin>::start(std::uint32_t frequency,
+                                                                std::uint32_t dead_time_ns,
+                                                                std::uint32_t update_divider)
+  {
+    using CR1  = typename Registers::CR1;
+    using CCER = typename Registers::CCER;
+    using BDTR = typename Registers::BDTR;
+
+    const std::uint32_t clock { Timer_config::clock(instance) };
+    if (frequency == 0 || frequency > clock / 2) return false;
+
+    // Period in timer clocks, split into a prescaler and
+    // the counter's reload value
+    //
+    const std::uint32_t clocks    { clock / frequency };
+    const std::uint32_t prescaler { (config.counter_bits == 32) ? 0 : (clocks - 1) / 0x10000 };
+    if (prescaler > 0xFFFF) return false;
+    const std::uint32_t reload    { (clocks / (prescaler + 1)) - 1 };
+
+    if (update_divider == 0 || update_divider > (config.advanced ? 256u : 1u)) return false;
+
+    Timer_config::Dead_time dead_time { };
+    if (dead_time_ns != 0) {
+      if (!complementary) return false;
+      dead_time = Timer_config::dead_time(clock, dead_time_ns);
+      if (!dead_time.valid) return false;
+    }
+
+    Timer_config::enable_clock(instance);
+
+    // Counter stopped, preloaded reload value; update events
+    // (and interrupts) only from the counter, not from UG
+    //
+    CR1::write(CR1::ARPE::set | CR1::URS::set);
+    Registers::PSC::write(prescaler);
+    Registers::ARR::write(reload);
+    CCR::write(0);
+
+    CCMR::modify(
+      CCMR::template CCS<channel>::template value<CCMR::output>()       |
+      CCMR::template OCM<channel>::template value<CCMR::pwm_mode_1>()   |
+      CCMR::template OCPE<channel>::set
+    );
+
+    if constexpr (complementary) {
+      CCER::modify(CCER::template CCE<channel>::set | CCER::template CCNE<channel>::set);
+    }
+    else {
+      CCER::modify(CCER::template CCE<channel>::set);
+    }
+
+    // Advanced-control timer outputs are also gated by MOE. Off-state
+    // selection keeps the outputs driven inactive (not floating) while
+    // the channel is disabled
+    //
+    if constexpr (config.advanced) {
+      Registers::RCR::write(update_divider - 1);
+      BDTR::write(
+        BDTR::DTG::value(dead_time.dtg) |
+        BDTR::OSSR::set                 |
+        BDTR::OSSI::set                 |
+        BDTR::MOE::set
+      );
+    }
+
+    // Load the prescaler, reload and repetition values and the
+    // compare preload, then configure the pins so they are
+    // only connected once the outputs are inactive
+    //
+    Registers::EGR::write(Registers::EGR::UG::set);
+
+    STM32F407::enable(Out_pin::port);
+    Out_pin::template set_alternate<config.alt_function>();
+    if constexpr (complementary) {
+      STM32F407::enable(Complementary_pin::port);
+      Complementary_pin::template set_alternate<config.alt_function>();
+    }
+
+    CR1::modify(CR1::CEN::set);
+    return true;
+  }
+
+
+  template <Timer_config::Instance instance, unsigned channel, typename Out_pin, typename Complementary_pin>
+  void PWM<instance, channel, Out_pin, Complementary_pin>::stop()
+  {
+    disable_update_interrupt();
+
+    if constexpr (config.advanced) {
+      Registers::BDTR::modify(Registers::BDTR::MOE::clear);
+    }
+    CCR::write(0);
+    Registers::CR1::modify(Registers::CR1::CEN::clear);
+  }
+
+} // namespace STM32F407
+
+#endif // PWM_H_
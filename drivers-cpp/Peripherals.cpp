@@ -4,66 +4,69 @@
 
 #include "Peripherals.h"
 #include "Memory_map.h"
+#include "Register.h"
+#include "Bit_band.h"
 #include <cstdint>
 
 using std::uint32_t;
 
+namespace STM32F407
+{
+    // RCC peripheral clock enable registers; one bit per
+    // device, numbered as the device enums. Bits are changed
+    // through the bit-band alias so tasks and ISRs can enable
+    // devices concurrently.
+    //
+    struct RCC_AHB1_enable : Register<RCC_AHB1_enable, RCC_base + 0x30> { };
+    struct RCC_APB1_enable : Register<RCC_APB1_enable, RCC_base + 0x40> { };
+    struct RCC_APB2_enable : Register<RCC_APB2_enable, RCC_base + 0x44> { };
+}
+
 namespace
 {
-    inline void enable_device(volatile uint32_t *const  rcc, unsigned device)
+    template <typename RCC_register>
+    inline void enable_device(unsigned device)
     {
-      uint32_t port = *rcc;
-      port |= (0x1u << device);
-      *rcc = port;
+      STM32F407::Bit_band::set(RCC_register::address, device);
     }
 
-    inline void disable_device(volatile uint32_t *const  rcc, unsigned device)
+    template <typename RCC_register>
+    inline void disable_device(unsigned device)
     {
-      uint32_t port = *rcc;
-      port &= ~(0x1u << device);
-      *rcc = port;
+      STM32F407::Bit_band::clear(RCC_register::address, device);
     }
 }
 
 namespace STM32F407
 {
-    // Use static consts to give the compiler
-    // the best opportunity to optimise
-    //
-    constexpr uintptr_t RCC_base { AHB1_base + 0x3800 };
-
-    static volatile uint32_t* RCC_AHB1_enable  { reinterpret_cast<uint32_t*>(RCC_base + 0x30) };
-    static volatile uint32_t* RCC_APB1_enable  { reinterpret_cast<uint32_t*>(RCC_base + 0x40) };
-    static volatile uint32_t* RCC_APB2_enable  { reinterpret_cast<uint32_t*>(RCC_base + 0x44) };
-
     void enable(AHB1_Device device)
     {
-      enable_device(RCC_AHB1_enable, unsigned(device));
+      enable_device<RCC_AHB1_enable>(unsigned(device));
     }
 
     void enable(APB1_Device device)
     {
-      enable_device(RCC_APB1_enable, unsigned(device));
+      enable_device<RCC_APB1_enable>(unsigned(device));
     }
 
     void enable(APB2_Device device)
     {
-      enable_device(RCC_APB2_enable, unsigned(device));
+      enable_device<RCC_APB2_enable>(unsigned(device));
     }
 
     void disable(AHB1_Device device)
     {
-      disable_device(RCC_AHB1_enable, unsigned(device));
+      disable_device<RCC_AHB1_enable>(unsigned(device));
     }
 
     void disable(APB1_Device device)
     {
-      disable_device(RCC_APB1_enable, unsigned(device));
+      disable_device<RCC_APB1_enable>(unsigned(device));
     }
 
     void disable(APB2_Device device)
     {
-      disable_device(RCC_APB2_enable, unsigned(device));
+      disable_device<RCC_APB2_enable>(unsigned(device));
     }
 
 } // namespace STM32F407
@@ -19,6 +19,8 @@ namespace STM32F407
       GPIO_G    = 6,
       // GPIO_H    = 7,   // conflict with header include guards
       // GPIO_I    = 8
+      DMA_1     = 21,   // Base addresses are not 0x400 apart,
+      DMA_2     = 22,   // see DMA1_base, DMA2_base
     };
 
     enum APB1_Device
@@ -52,6 +54,7 @@ namespace STM32F407
       ADC_1     = 8,
       ADC_2     = 9,
       ADC_3     = 10,
+      SPI_1     = 12,
       TIMER_9   = 16,
       TIMER_10  = 17,
       TIMER_11  = 18,
@@ -0,0 +1,138 @@
+// Register.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef REGISTER_H
+#define REGISTER_H
+
+#include <cstdint>
+#include "Memory_map.h"
+
+// -------------------------------------------------------------------------------------
+// Typed access to memory-mapped registers.
+//
+// A register is a type deriving from Register<> with its address and
+// access; its fields are nested types deriving from Field<>:
+//
+//   struct CR1 : Register<CR1, USART3_base + 0x0C> {
+//     using UE = Field<CR1, 13, 1>;
+//     using TE = Field<CR1, 3, 1>;
+//     using M  = Field<CR1, 12, 1>;
+//   };
+//
+//   CR1::modify(CR1::UE::set | CR1::TE::set | CR1::M::clear);
+//
+// Field values are combined with | into a single mask and value, so
+// modify() is one read and one write of the register however many
+// fields change; with constant values the masks fold at compile time.
+// The following do not compile:
+// - combining fields of different registers
+// - a constant value too wide for its field: Field::value<N>()
+// - writing a read-only register or reading a write-only one
+//
+// Values only known at run time use Field::value(n), which discards
+// any bits outside the field.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  enum class Access { read_only, write_only, read_write };
+
+  // A set of field values for one register
+  //
+  template <typename Register_Ty>
+  struct Field_values
+  {
+    std::uint32_t mask;
+    std::uint32_t bits;
+
+    constexpr Field_values operator|(Field_values other) const
+    {
+      return Field_values { mask | other.mask, bits | other.bits };
+    }
+  };
+
+
+  template <typename Register_Ty, uintptr_t addr, Access access = Access::read_write>
+  struct Register
+  {
+    using Values = Field_values<Register_Ty>;
+
+    static constexpr uintptr_t address { addr };
+
+    static std::uint32_t read()
+    {
+      static_assert(access != Access::write_only, "Register is write-only");
+      return peripheral(addr);
+    }
+
+    static void write(std::uint32_t value)
+    {
+      static_assert(access != Access::read_only, "Register is read-only");
+      peripheral(addr) = value;
+    }
+
+    // Fields not given are written as zero
+    //
+    static void write(Values values)
+    {
+      write(values.bits);
+    }
+
+    // Fields not given are unchanged
+    //
+    static void modify(Values values)
+    {
+      static_assert(access == Access::read_write, "Register is not read-write");
+      std::uint32_t value = peripheral(addr);
+      value &= ~values.mask;
+      value |= values.bits;
+      peripheral(addr) = value;
+    }
+  };
+
+
+  template <typename Register_Ty, unsigned offset, unsigned width>
+  struct Field
+  {
+    static_assert(width > 0 && offset + width <= 32, "Field outside register");
+
+    using Values        = Field_values<Register_Ty>;
+    using Register_type = Register_Ty;
+
+    static constexpr unsigned position { offset };
+    static constexpr unsigned size     { width };
+
+    static constexpr std::uint32_t max   { (width == 32) ? 0xFFFFFFFFu : ((0x1u << width) - 1) };
+    static constexpr std::uint32_t mask  { max << offset };
+
+    static constexpr Values set   { mask, mask };
+    static constexpr Values clear { mask, 0 };
+
+    template <std::uint32_t value_>
+    static constexpr Values value()
+    {
+      static_assert(value_ <= max, "Value too wide for field");
+      return Values { mask, value_ << offset };
+    }
+
+    static constexpr Values value(std::uint32_t value_)
+    {
+      return Values { mask, (value_ << offset) & mask };
+    }
+
+    static std::uint32_t read()
+    {
+      return (Register_Ty::read() & mask) >> offset;
+    }
+
+    static bool is_set()
+    {
+      return (Register_Ty::read() & mask) != 0;
+    }
+  };
+
+} // namespace STM32F407
+
+#endif // REGISTER_H_
@@ -0,0 +1,529 @@
+// SPI.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef SPI_H
+#define SPI_H
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "NVIC.h"
+#include "DMA.h"
+#include "GPIO.h"
+#include "Transaction_queue.h"
+#include "system_clock.h"
+
+#if defined(RTOS)
+#include "feabhOS_signal.h"
+#endif
+
+namespace STM32F407
+{
+  namespace SPI_config
+  {
+    // ---------------------------------------------------------------------
+    // SPI register definitions (RM0090 section 28.5)
+    //
+    template <uintptr_t base>
+    struct Registers
+    {
+      struct CR1 : Register<CR1, base + 0x00>
+      {
+        using CPHA     = Field<CR1, 0, 1>;  // Clock phase
+        using CPOL     = Field<CR1, 1, 1>;  // Clock polarity
+        using MSTR     = Field<CR1, 2, 1>;  // Master
+        using BR       = Field<CR1, 3, 3>;  // Baud rate, PCLK / 2^(BR + 1)
+        using SPE      = Field<CR1, 6, 1>;  // SPI enable
+        using LSBFIRST = Field<CR1, 7, 1>;
+        using SSI      = Field<CR1, 8, 1>;  // Internal slave select
+        using SSM      = Field<CR1, 9, 1>;  // Software slave management
+        using RXONLY   = Field<CR1, 10, 1>;
+        using DFF      = Field<CR1, 11, 1>; // 16-bit frames
+      };
+
+      struct CR2 : Register<CR2, base + 0x04>
+      {
+        using RXDMAEN = Field<CR2, 0, 1>;   // Rx buffer DMA enable
+        using TXDMAEN = Field<CR2, 1, 1>;   // Tx buffer DMA enable
+        using SSOE    = Field<CR2, 2, 1>;   // SS output enable
+        using ERRIE   = Field<CR2, 5, 1>;
+        using RXNEIE  = Field<CR2, 6, 1>;
+        using TXEIE   = Field<CR2, 7, 1>;
+      };
+
+      struct SR : Register<SR, base + 0x08>
+      {
+        using RXNE = Field<SR, 0, 1>;       // Receive buffer not empty
+        using TXE  = Field<SR, 1, 1>;       // Transmit buffer empty
+        using MODF = Field<SR, 5, 1>;       // Mode fault
+        using OVR  = Field<SR, 6, 1>;       // Overrun
+        using BSY  = Field<SR, 7, 1>;       // Busy
+      };
+
+      struct DR : Register<DR, base + 0x0C> { };
+    };
+
+    // ---------------------------------------------------------------------
+    // SPI instances (RM0090 table 42, DS8626 table 9).
+    //
+    // A DMA stream serves one peripheral at a time. The streams below
+    // leave SPI2 and the I2C1 defaults (I2C.h) free to run together;
+    // SPI1 shares DMA2 stream 2 with USART1 Rx and ADC2 (ADC.h), and
+    // SPI3 shares DMA1 stream 5 with USART2 Rx and I2C1 Rx.
+    //
+    enum class Instance { spi_1, spi_2, spi_3 };
+
+    enum class Bus { APB1, APB2 };
+
+    struct Pin_id
+    {
+      AHB1_Device port;
+      unsigned    number;
+    };
+
+    using DMA_stream = DMA_config::Stream_id;
+
+    struct Instance_info
+    {
+      uintptr_t     base;
+      Bus           bus;
+      unsigned      clock_enable;   // RCC enable bit on the bus
+      std::uint32_t alt_function;   // GPIO AF number for the SCK / MISO / MOSI pins
+      DMA_stream    rx_dma;
+      DMA_stream    tx_dma;
+      Pin_id        sck_pins[2];    // Valid pins; the first is the default
+      Pin_id        miso_pins[2];
+      Pin_id        mosi_pins[2];
+    };
+
+    // Indexed by Instance
+    //
+    inline constexpr Instance_info instances[] {
+      { device_base_address(SPI_1), Bus::APB2, SPI_1, 5, { 2, 2, 3 }, { 2, 3, 3 },
+        { { GPIO_A, 5 },  { GPIO_B, 3 } },  { { GPIO_A, 6 },  { GPIO_B, 4 } },  { { GPIO_A, 7 },  { GPIO_B, 5 } } },
+      { device_base_address(SPI_2), Bus::APB1, SPI_2, 5, { 1, 3, 0 }, { 1, 4, 0 },
+        { { GPIO_B, 13 }, { GPIO_B, 10 } }, { { GPIO_B, 14 }, { GPIO_C, 2 } },  { { GPIO_B, 15 }, { GPIO_C, 3 } } },
+      { device_base_address(SPI_3), Bus::APB1, SPI_3, 6, { 1, 0, 0 }, { 1, 5, 0 },
+        { { GPIO_C, 10 }, { GPIO_B, 3 } },  { { GPIO_C, 11 }, { GPIO_B, 4 } },  { { GPIO_C, 12 }, { GPIO_B, 5 } } },
+    };
+
+    constexpr const Instance_info& info(Instance instance)
+    {
+      return instances[static_cast<unsigned>(instance)];
+    }
+
+    constexpr bool pin_in(const Pin_id (&pins)[2], AHB1_Device port, unsigned number)
+    {
+      for (const auto& pin : pins) {
+        if (pin.port == port && pin.number == number) return true;
+      }
+      return false;
+    }
+
+    template <Instance instance>
+    using Default_sck_pin  = GPIO::Pin<info(instance).sck_pins[0].port,  info(instance).sck_pins[0].number>;
+
+    template <Instance instance>
+    using Default_miso_pin = GPIO::Pin<info(instance).miso_pins[0].port, info(instance).miso_pins[0].number>;
+
+    template <Instance instance>
+    using Default_mosi_pin = GPIO::Pin<info(instance).mosi_pins[0].port, info(instance).mosi_pins[0].number>;
+
+    // ---------------------------------------------------------------------
+    // Baud rate: the SPI clock is the bus clock divided by 2^(BR + 1).
+    // clock_divider() gives the smallest divider that does not exceed
+    // 'max_clock', or the largest (256) if none does
+    //
+    constexpr std::uint32_t clock_divider(std::uint32_t bus_clock, std::uint32_t max_clock)
+    {
+      std::uint32_t br { 0 };
+      while (br < 7 && (bus_clock >> (br + 1)) > max_clock) {
+        ++br;
+      }
+      return br;
+    }
+
+    static_assert(clock_divider(84000000, 20000000) == 2, "SPI1 at 10.5MHz");
+    static_assert(clock_divider(42000000, 21000000) == 0, "SPI2/3 at 21MHz");
+    static_assert(clock_divider(42000000, 100000)   == 7, "Slowest is PCLK / 256");
+
+    // ---------------------------------------------------------------------
+    // Devices and transactions.
+    //
+    // A Device describes one slave on the bus: its chip select and
+    // its clock settings, which are applied at the start of each of
+    // its transactions so devices with different modes and speeds
+    // can share the bus.
+    //
+    // Mode is CPOL << 1 | CPHA
+    //
+    enum class Mode : std::uint32_t { mode_0, mode_1, mode_2, mode_3 };
+
+    struct Device
+    {
+      void          (*select)(bool active);     // Drive the chip select; nullptr if none
+      std::uint32_t max_clock;                  // Hz
+      Mode          mode { Mode::mode_0 };
+    };
+
+    // Active-low chip select on a GPIO::Pin, for Device::select. The
+    // pin must be configured as an output, high, before it is used
+    //
+    template <typename Pin_Ty>
+    void chip_select(bool active)
+    {
+      if (active) Pin_Ty::clear(); else Pin_Ty::set();
+    }
+
+    // One buffer of a scatter / gather transfer. 'length' bytes are
+    // sent from 'tx' while 'length' bytes are received into 'rx'. A
+    // null 'tx' sends 0xFF; a null 'rx' discards the received bytes
+    //
+    struct Segment
+    {
+      const std::uint8_t* tx;
+      std::uint8_t*       rx;
+      std::uint16_t       length;
+    };
+
+    struct Transaction;
+
+    // Called in interrupt context when the transaction has
+    // completed or failed
+    //
+    using Handler = void (*)(Transaction& transaction, void* context);
+
+    // The chip select is held active across all the segments
+    //
+    struct Transaction
+    {
+      const Device*  device;
+      const Segment* segments;
+      std::size_t    count;
+      Handler        handler  { };
+      void*          context  { };
+
+      volatile Transaction_status status { Transaction_status::idle };
+      Transaction*   next     { };      // Owned by the driver's queue
+    };
+
+#if defined(RTOS)
+    // Handler for tasks waiting on a feabhOS signal;
+    // pass the signal as the context
+    //
+    inline void notify_signal(Transaction&, void* signal)
+    {
+      feabhOS_signal_notify_one_ISR(static_cast<feabhOS_SIGNAL*>(signal));
+    }
+#endif
+
+  } // namespace SPI_config
+
+
+  // -----------------------------------------------------------------------------------
+  // SPI master with a queue of DMA transactions.
+  //
+  // submit() queues a transaction and returns at once. Each
+  // transaction selects its device, runs its segments back to back
+  // with the Rx and Tx DMA streams (no CPU time per byte), deselects
+  // the device and calls its handler. The next queued transaction is
+  // started from the same interrupt, so devices queued by different
+  // tasks share the bus without any of them polling:
+  //
+  //   SPI<SPI_config::Instance::spi_2> bus { 5 };        // NVIC priority
+  //
+  //   extern "C" void DMA1_Stream3_IRQHandler() { bus.dma_interrupt(); }
+  //   extern "C" void DMA1_Stream4_IRQHandler() { bus.dma_interrupt(); }
+  //
+  //   const SPI_config::Device flash { SPI_config::chip_select<GPIO::Pin<GPIO_B, 12>>, 21'000'000 };
+  //   std::uint8_t command[4] { 0x03, ... };
+  //   const SPI_config::Segment read[] { { command, nullptr, 4 }, { nullptr, page, 256 } };
+  //   SPI_config::Transaction transaction { &flash, read, 2, handler, context };
+  //   bus.submit(transaction);
+  //
+  // The Rx stream's transfer-complete is the end of a segment, as the
+  // last byte is received after the last is sent; the Tx stream only
+  // interrupts on an error.
+  // Buffers must be in SRAM (see DMA.h). The pins are checked at
+  // compile time as for USART.
+  //
+  template <SPI_config::Instance instance,
+            typename Sck_pin  = SPI_config::Default_sck_pin<instance>,
+            typename Miso_pin = SPI_config::Default_miso_pin<instance>,
+            typename Mosi_pin = SPI_config::Default_mosi_pin<instance>>
+  class SPI
+  {
+  public:
+    static constexpr const SPI_config::Instance_info& config { SPI_config::info(instance) };
+
+    using Registers = SPI_config::Registers<config.base>;
+    using Rx_stream = DMA::Stream<config.rx_dma.controller, config.rx_dma.stream>;
+    using Tx_stream = DMA::Stream<config.tx_dma.controller, config.tx_dma.stream>;
+
+    static constexpr IRQ_number rx_irq { Rx_stream::irq };
+    static constexpr IRQ_number tx_irq { Tx_stream::irq };
+
+    static_assert(SPI_config::pin_in(config.sck_pins, Sck_pin::port, Sck_pin::number),
+                  "SCK pin cannot be used with this SPI");
+    static_assert(SPI_config::pin_in(config.miso_pins, Miso_pin::port, Miso_pin::number),
+                  "MISO pin cannot be used with this SPI");
+    static_assert(SPI_config::pin_in(config.mosi_pins, Mosi_pin::port, Mosi_pin::number),
+                  "MOSI pin cannot be used with this SPI");
+
+    // 'priority' is the NVIC priority of the DMA stream
+    // interrupts, in which the handlers are called
+    //
+    explicit SPI(unsigned priority);
+    ~SPI();
+
+    SPI(const SPI&)            = delete;
+    SPI& operator=(const SPI&) = delete;
+
+    // Queue a transaction. From a task or an interrupt handler,
+    // including a transaction's own handler. Returns false,
+    // without queuing it or calling its handler, if none of the
+    // transaction's segments has any data
+    //
+    bool submit(SPI_config::Transaction& transaction);
+
+    bool idle() const { return queue.empty(); }
+
+    // Call from both DMA streams' IRQ handlers (rx_irq, tx_irq)
+    //
+    void dma_interrupt();
+
+  private:
+    using CR1 = typename Registers::CR1;
+    using CR2 = typename Registers::CR2;
+
+    void start(SPI_config::Transaction& transaction);
+    bool start_segment();
+    void finish(Transaction_status result);
+    static std::uint32_t bus_clock();
+
+    Transaction_queue<SPI_config::Transaction> queue { };
+    std::size_t segment { };
+
+    // DMA source and sink for segments without a buffer
+    //
+    static inline const std::uint8_t filler { 0xFF };
+    static inline std::uint8_t       discard { };
+  };
+
+
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::SPI(unsigned priority)
+  {
+    if constexpr (config.bus == SPI_config::Bus::APB2) {
+      STM32F407::enable(static_cast<APB2_Device>(config.clock_enable));
+    }
+    else {
+      STM32F407::enable(static_cast<APB1_Device>(config.clock_enable));
+    }
+    Rx_stream::enable_clock();
+    Tx_stream::enable_clock();
+
+    // Master with software slave select; the chip selects
+    // are GPIO outputs driven per transaction
+    //
+    CR2::write(0);
+    CR1::write(CR1::MSTR::set | CR1::SSM::set | CR1::SSI::set);
+
+    STM32F407::enable(Sck_pin::port);
+    STM32F407::enable(Miso_pin::port);
+    STM32F407::enable(Mosi_pin::port);
+    Sck_pin::template set_alternate<config.alt_function>();
+    Miso_pin::template set_alternate<config.alt_function>();
+    Mosi_pin::template set_alternate<config.alt_function>();
+
+    NVIC::set_priority(rx_irq, priority);
+    NVIC::set_priority(tx_irq, priority);
+    NVIC::enable(rx_irq);
+    NVIC::enable(tx_irq);
+  }
+
+
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::~SPI()
+  {
+    NVIC::disable(rx_irq);
+    NVIC::disable(tx_irq);
+    Tx_stream::stop();
+    Rx_stream::stop();
+    CR2::write(0);
+    CR1::modify(CR1::SPE::clear);
+
+    if constexpr (config.bus == SPI_config::Bus::APB2) {
+      STM32F407::disable(static_cast<APB2_Device>(config.clock_enable));
+    }
+    else {
+      STM32F407::disable(static_cast<APB1_Device>(config.clock_enable));
+    }
+  }
+
+
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  bool SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::submit(SPI_config::Transaction& transaction)
+  {
+    // A transaction without data would complete as soon as it
+    // started, in the caller's context rather than an interrupt
+    //
+    bool has_data { false };
+    for (std::size_t i = 0; i < transaction.count; ++i) {
+      has_data = has_data || (transaction.segments[i].length != 0);
+    }
+    if (!has_data) return false;
+
+    if (queue.push(transaction)) {
+      start(transaction);
+    }
+    return true;
+  }
+
+
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  void SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::start(SPI_config::Transaction& transaction)
+  {
+    const SPI_config::Device& device { *transaction.device };
+    const std::uint32_t mode { static_cast<std::uint32_t>(device.mode) };
+
+    // Clock settings can only change while the SPI is disabled;
+    // it is idle between transactions
+    //
+    CR1::write(CR1::MSTR::set | CR1::SSM::set | CR1::SSI::set);
+    CR1::write(
+      CR1::MSTR::set                                                        |
+      CR1::SSM::set                                                         |
+      CR1::SSI::set                                                         |
+      CR1::BR::value(SPI_config::clock_divider(bus_clock(), device.max_clock)) |
+      CR1::CPOL::value(mode >> 1)                                           |
+      CR1::CPHA::value(mode & 0x1u)                                         |
+      CR1::SPE::set
+    );
+
+    transaction.status = Transaction_status::active;
+    if (device.select != nullptr) device.select(true);
+
+    // submit() only queues transactions with data
+    //
+    segment = 0;
+    [[maybe_unused]] const bool started { start_segment() };
+    assert(started);
+  }
+
+
+  // Start the DMA transfers for the first segment from 'segment'
+  // that has data; false if there are none left
+  //
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  bool SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::start_segment()
+  {
+    const SPI_config::Transaction& transaction { *queue.front() };
+
+    while (segment < transaction.count && transaction.segments[segment].length == 0) {
+      ++segment;
+    }
+    if (segment == transaction.count) return false;
+
+    const SPI_config::Segment& current { transaction.segments[segment] };
+
+    DMA::Transfer rx { };
+    rx.channel          = config.rx_dma.channel;
+    rx.direction        = DMA::Direction::peripheral_to_memory;
+    rx.peripheral       = Registers::DR::address;
+    rx.memory           = (current.rx != nullptr) ? current.rx : &discard;
+    rx.memory_increment = (current.rx != nullptr);
+    rx.count            = current.length;
+    rx.size             = DMA::Size::byte;
+    rx.priority         = DMA::Priority::high;
+
+    DMA::Transfer tx { };
+    tx.channel            = config.tx_dma.channel;
+    tx.direction          = DMA::Direction::memory_to_peripheral;
+    tx.peripheral         = Registers::DR::address;
+    tx.memory             = (current.tx != nullptr) ? current.tx : &filler;
+    tx.memory_increment   = (current.tx != nullptr);
+    tx.count              = current.length;
+    tx.size               = DMA::Size::byte;
+    tx.complete_interrupt = false;
+
+    // Rx requests enabled before the Tx stream starts
+    // the clock (RM0090 28.3.9)
+    //
+    CR2::write(CR2::RXDMAEN::set);
+    Rx_stream::start(rx);
+    Tx_stream::start(tx);
+    CR2::modify(CR2::TXDMAEN::set);
+    return true;
+  }
+
+
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  void SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::finish(Transaction_status result)
+  {
+    SPI_config::Transaction& done { *queue.front() };
+
+    CR2::write(0);
+    while (Registers::SR::BSY::is_set())
+    {
+      ; // Wait for the last bit...
+    }
+    if (done.device->select != nullptr) done.device->select(false);
+
+    // Start the next transaction before calling the handler,
+    // which may queue another on this bus
+    //
+    done.status = result;
+    SPI_config::Transaction* const next { queue.pop() };
+    if (next != nullptr) start(*next);
+
+    if (done.handler != nullptr) {
+      done.handler(done, done.context);
+    }
+  }
+
+
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  void SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::dma_interrupt()
+  {
+    constexpr std::uint32_t errors { DMA_config::Flags::TEIF | DMA_config::Flags::DMEIF };
+
+    const std::uint32_t rx_flags { Rx_stream::interrupt_flags() };
+    const std::uint32_t tx_flags { Tx_stream::interrupt_flags() };
+    if (queue.empty()) return;
+
+    if (((rx_flags | tx_flags) & errors) != 0) {
+      Tx_stream::stop();
+      Rx_stream::stop();
+      finish(Transaction_status::failed);
+      return;
+    }
+
+    if ((rx_flags & DMA_config::Flags::TCIF) != 0) {
+      ++segment;
+      if (!start_segment()) {
+        finish(Transaction_status::complete);
+      }
+    }
+  }
+
+
+  template <SPI_config::Instance instance, typename Sck_pin, typename Miso_pin, typename Mosi_pin>
+  inline std::uint32_t SPI<instance, Sck_pin, Miso_pin, Mosi_pin>::bus_clock()
+  {
+    if constexpr (config.bus == SPI_config::Bus::APB2) {
+      return SystemClock_PCLK2();
+    }
+    else {
+      return SystemClock_PCLK1();
+    }
+  }
+
+} // namespace STM32F407
+
+#endif // SPI_H_
@@ -0,0 +1,198 @@
+// Tachometer.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef TACHOMETER_H
+#define TACHOMETER_H
+
+#include <cstdint>
+#include <type_traits>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "GPIO.h"
+#include "Timer_registers.h"
+
+// -------------------------------------------------------------------------------------
+// Speed measurement from a rotation sensor with timer input capture.
+//
+// The timer counts at 1MHz and latches the count on each rising edge
+// of the sensor (or every 2nd, 4th or 8th edge), so the period between
+// captures is measured by the hardware to 1us whatever the interrupt
+// latency. update() is polled, typically from a control loop's
+// periodic interrupt, and picks up the latest capture:
+//
+//   Tachometer<Timer_config::Instance::tim_5, 1, GPIO::Pin<GPIO_A, 0>> tacho { };
+//   tacho.start();
+//   ...
+//   tacho.update();
+//   auto hz = tacho.frequency() >> 8;
+//
+// If more than one capture occurs between polls the periods in between
+// are lost (the overcapture flag) and the next capture restarts the
+// measurement. If there is no capture for 'stall_time' the speed is
+// reported as zero. The 32-bit timers (TIM2, TIM5) measure periods of
+// any length; with a 16-bit timer the stall time must be under 32ms.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  template <Timer_config::Instance instance, unsigned channel, typename In_pin>
+  class Tachometer
+  {
+  public:
+    static constexpr const Timer_config::Instance_info& config { Timer_config::info(instance) };
+
+    static constexpr std::uint32_t tick_rate { 1'000'000 };
+
+    static_assert(channel >= 1 && channel <= 4, "Timer channels are 1-4");
+
+    using Registers = Timer_config::Registers<config.base>;
+    using CCMR      = std::conditional_t<(channel <= 2), typename Registers::CCMR1, typename Registers::CCMR2>;
+    using CCR       = typename Registers::template CCR<channel>;
+
+    // Sensor edges per capture (the input capture prescaler)
+    //
+    enum class Edges : std::uint32_t { every = 0x0, every_2nd = 0x1, every_4th = 0x2, every_8th = 0x3 };
+
+    Tachometer() = default;
+
+    Tachometer(const Tachometer&)            = delete;
+    Tachometer& operator=(const Tachometer&) = delete;
+
+    // 'filter' is the CCMR ICF digital filter setting for a
+    // noisy sensor. Returns false if the stall time cannot be
+    // measured by the counter
+    //
+    bool start(Edges edges = Edges::every, std::uint32_t stall_time_us = 100'000, std::uint32_t filter = 0);
+    void stop();
+
+    // Poll for a new capture; true if the period was updated
+    //
+    bool update();
+
+    // Latest period between captures in microseconds, or
+    // 0 if the sensor has stalled or no period has been measured
+    //
+    std::uint32_t period() const { return period_ticks; }
+
+    // Sensor edges per second in Q24.8 fixed point (256 is 1Hz),
+    // or 0 if stalled
+    //
+    std::uint32_t frequency() const
+    {
+      return (period_ticks == 0) ? 0 : (tick_rate * 256 * edges_per_capture) / period_ticks;
+    }
+
+  private:
+    static constexpr std::uint32_t counter_mask {
+      (config.counter_bits == 32) ? 0xFFFFFFFFu : ((0x1u << config.counter_bits) - 1)
+    };
+
+    std::uint32_t last_capture      { };
+    bool          have_capture      { false };
+    std::uint32_t period_ticks      { };
+    std::uint32_t stall_ticks       { };
+    std::uint32_t edges_per_capture { 1 };
+  };
+
+
+  template <Timer_config::Instance instance, unsigned channel, typename In_pin>
+  bool Tachometer<instance, channel, In_pin>::start(Edges edges, std::uint32_t stall_time_us, std::uint32_t filter)
+  {
+    using CR1  = typename Registers::CR1;
+    using CCER = typename Registers::CCER;
+
+    const std::uint32_t clock { Timer_config::clock(instance) };
+    if (stall_time_us == 0 || stall_time_us > (counter_mask / 2) || (clock % tick_rate) != 0) return false;
+
+    stop();
+
+    stall_ticks       = stall_time_us;
+    edges_per_capture = 0x1u << static_cast<std::uint32_t>(edges);
+    have_capture      = false;
+    period_ticks      = 0;
+
+    Timer_config::enable_clock(instance);
+
+    // Free-running 1MHz up-counter over its full range
+    //
+    CR1::write(CR1::URS::set);
+    Registers::PSC::write((clock / tick_rate) - 1);
+    Registers::ARR::write(counter_mask);
+
+    // Capture the channel's own input on rising edges
+    //
+    CCER::modify(CCER::template CCE<channel>::clear);
+    CCMR::modify(
+      CCMR::template CCS<channel>::template value<CCMR::input_TI>()   |
+      CCMR::template ICPSC<channel>::value(static_cast<std::uint32_t>(edges)) |
+      CCMR::template ICF<channel>::value(filter)
+    );
+    CCER::modify(
+      CCER::template CCP<channel>::clear  |
+      CCER::template CCNP<channel>::clear |
+      CCER::template CCE<channel>::set
+    );
+
+    STM32F407::enable(In_pin::port);
+    In_pin::template set_alternate<config.alt_function>();
+
+    Registers::EGR::write(Registers::EGR::UG::set);
+    Registers::SR::write(0);
+    CR1::modify(CR1::CEN::set);
+    return true;
+  }
+
+
+  template <Timer_config::Instance instance, unsigned channel, typename In_pin>
+  void Tachometer<instance, channel, In_pin>::stop()
+  {
+    Registers::CCER::modify(Registers::CCER::template CCE<channel>::clear);
+    Registers::CR1::modify(Registers::CR1::CEN::clear);
+    period_ticks = 0;
+  }
+
+
+  template <Timer_config::Instance instance, unsigned channel, typename In_pin>
+  bool Tachometer<instance, channel, In_pin>::update()
+  {
+    using SR   = typename Registers::SR;
+    using CCIF = typename SR::template CCIF<channel>;
+    using CCOF = typename SR::template CCOF<channel>;
+
+    const std::uint32_t status { SR::read() };
+
+    if ((status & CCIF::mask) != 0) {
+      // Reading CCR clears the capture flag
+      //
+      const std::uint32_t capture { CCR::read() };
+      bool measured { false };
+
+      if ((status & CCOF::mask) != 0) {
+        SR::write(~CCOF::mask);
+      }
+      else if (have_capture) {
+        period_ticks = (capture - last_capture) & counter_mask;
+        measured     = true;
+      }
+
+      last_capture = capture;
+      have_capture = true;
+      return measured;
+    }
+
+    // No capture: stalled if the time since the last
+    // one is over the limit
+    //
+    if (have_capture && ((Registers::CNT::read() - last_capture) & counter_mask) > stall_ticks) {
+      period_ticks = 0;
+      have_capture = false;
+    }
+    return false;
+  }
+
+} // namespace STM32F407
+
+#endif // TACHOMETER_H_
@@ -6,10 +6,22 @@
 
 #ifdef RTOS
 
+namespace {
+  volatile Tick_handler tick_handler {};
+}
+
+void set_tick_handler(Tick_handler handler)
+{
+  tick_handler = handler;
+}
+
 extern "C"
 void vApplicationTickHook(void)
 {
-  // only required for C++ timer
+  Tick_handler handler = tick_handler;
+  if(handler != nullptr){
+    handler();
+  }
 }
 
 // Timer functions for non-RTOS operation ---------------------------------------
@@ -17,6 +29,7 @@ void vApplicationTickHook(void)
 #else
 
 #include "cmsis_device.h"
+#include "memory_sections.h"
 
 #define TIMER_FREQUENCY_HZ (1000u)
 
@@ -27,6 +40,7 @@ namespace {
 //
   std::atomic<uint32_t> timer_counter {};
   bool timer_started{};
+  volatile Tick_handler tick_handler {};
 
   void start_timer()
   {
@@ -36,6 +50,15 @@ namespace {
 
 }
 
+void set_tick_handler(Tick_handler handler)
+{
+  tick_handler = handler;
+
+  if(!timer_started) {
+    start_timer();
+  }
+}
+
 void sleep(duration_mSec period)
 {
   sleep(std::chrono::milliseconds(period));
@@ -56,11 +79,18 @@ void sleep(std::chrono::milliseconds period)
 }
 
 
+extern "C" void SysTick_Handler (void) FEABHAS_RAMFUNC;
+
 extern "C" void SysTick_Handler (void)
 {
   if(timer_counter != 0){
     --timer_counter;
   }
+
+  Tick_handler handler = tick_handler;
+  if(handler != nullptr){
+    handler();
+  }
 }
 
 #endif
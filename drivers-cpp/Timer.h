@@ -21,4 +21,11 @@ void sleep(duration_mSec period);
 
 #endif
 
+// Call 'handler' on every 1ms timer tick, in interrupt
+// context: the SysTick interrupt, or the RTOS tick hook.
+// There is one handler; nullptr removes it.
+//
+using Tick_handler = void (*)();
+void set_tick_handler(Tick_handler handler);
+
 #endif // TIMER_H_
@@ -0,0 +1,294 @@
+// Timer_registers.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef TIMER_REGISTERS_H
+#define TIMER_REGISTERS_H
+
+#include <cstdint>
+#include "Memory_map.h"
+#include "Peripherals.h"
+#include "Register.h"
+#include "NVIC.h"
+#include "system_clock.h"
+
+namespace STM32F407
+{
+  namespace Timer_config
+  {
+    // ---------------------------------------------------------------------
+    // Timer register definitions (RM0090 sections 17.4 and 18.4).
+    // The advanced-control timers (TIM1, TIM8) have every register;
+    // the general-purpose timers implement a subset, and the
+    // registers and fields they lack read as zero.
+    //
+    template <uintptr_t base>
+    struct Registers
+    {
+      struct CR1 : Register<CR1, base + 0x00>
+      {
+        using CEN  = Field<CR1, 0, 1>;      // Counter enable
+        using UDIS = Field<CR1, 1, 1>;      // Update disable
+        using URS  = Field<CR1, 2, 1>;      // Update request source
+        using OPM  = Field<CR1, 3, 1>;      // One-pulse mode
+        using DIR  = Field<CR1, 4, 1>;      // Direction (down)
+        using CMS  = Field<CR1, 5, 2>;      // Centre-aligned mode
+        using ARPE = Field<CR1, 7, 1>;      // Auto-reload preload enable
+        using CKD  = Field<CR1, 8, 2>;      // Clock division (dead-time, filters)
+      };
+
+      struct CR2 : Register<CR2, base + 0x04>
+      {
+        using CCPC = Field<CR2, 0, 1>;      // Capture/compare preloaded control
+        using CCUS = Field<CR2, 2, 1>;      // Capture/compare control update selection
+        using CCDS = Field<CR2, 3, 1>;      // Capture/compare DMA selection
+        using MMS  = Field<CR2, 4, 3>;      // Master mode (TRGO) selection
+        using TI1S = Field<CR2, 7, 1>;      // TI1 selection
+
+        static constexpr std::uint32_t trgo_reset  { 0x0 };
+        static constexpr std::uint32_t trgo_enable { 0x1 };
+        static constexpr std::uint32_t trgo_update { 0x2 };
+      };
+
+      struct SMCR : Register<SMCR, base + 0x08>
+      {
+        using SMS  = Field<SMCR, 0, 3>;     // Slave mode selection
+        using TS   = Field<SMCR, 4, 3>;     // Trigger selection
+        using MSM  = Field<SMCR, 7, 1>;     // Master/slave mode
+        using ETF  = Field<SMCR, 8, 4>;     // External trigger filter
+        using ETPS = Field<SMCR, 12, 2>;    // External trigger prescaler
+        using ECE  = Field<SMCR, 14, 1>;    // External clock enable
+        using ETP  = Field<SMCR, 15, 1>;    // External trigger polarity
+      };
+
+      struct DIER : Register<DIER, base + 0x0C>
+      {
+        using UIE   = Field<DIER, 0, 1>;    // Update interrupt enable
+        using CC1IE = Field<DIER, 1, 1>;    // Capture/compare 1-4 interrupt enable
+        using CC2IE = Field<DIER, 2, 1>;
+        using CC3IE = Field<DIER, 3, 1>;
+        using CC4IE = Field<DIER, 4, 1>;
+        using COMIE = Field<DIER, 5, 1>;    // COM interrupt enable
+        using TIE   = Field<DIER, 6, 1>;    // Trigger interrupt enable
+        using BIE   = Field<DIER, 7, 1>;    // Break interrupt enable
+        using UDE   = Field<DIER, 8, 1>;    // Update DMA request enable
+
+        template <unsigned channel> using CCIE = Field<DIER, channel, 1>;
+      };
+
+      // Status; flags are cleared by writing 0, bits written as 1
+      // are unchanged
+      //
+      struct SR : Register<SR, base + 0x10>
+      {
+        using UIF   = Field<SR, 0, 1>;      // Update
+        using CC1IF = Field<SR, 1, 1>;      // Capture/compare 1-4
+        using CC2IF = Field<SR, 2, 1>;
+        using CC3IF = Field<SR, 3, 1>;
+        using CC4IF = Field<SR, 4, 1>;
+        using COMIF = Field<SR, 5, 1>;      // COM
+        using TIF   = Field<SR, 6, 1>;      // Trigger
+        using BIF   = Field<SR, 7, 1>;      // Break
+        using CC1OF = Field<SR, 9, 1>;      // Capture/compare 1-4 overcapture
+        using CC2OF = Field<SR, 10, 1>;
+        using CC3OF = Field<SR, 11, 1>;
+        using CC4OF = Field<SR, 12, 1>;
+
+        template <unsigned channel> using CCIF = Field<SR, channel, 1>;
+        template <unsigned channel> using CCOF = Field<SR, channel + 8, 1>;
+      };
+
+      struct EGR : Register<EGR, base + 0x14, Access::write_only>
+      {
+        using UG   = Field<EGR, 0, 1>;      // Update generation
+        using COMG = Field<EGR, 5, 1>;      // Capture/compare control update generation
+        using TG   = Field<EGR, 6, 1>;      // Trigger generation
+        using BG   = Field<EGR, 7, 1>;      // Break generation
+      };
+
+      // Capture/compare mode, channels 1 and 2 (CCMR1) and 3 and 4
+      // (CCMR2). Each channel has 8 bits, laid out differently for
+      // output compare and input capture
+      //
+      struct CCMR1 : Register<CCMR1, base + 0x18>
+      {
+        template <unsigned channel> using CCS   = Field<CCMR1, 8 * (channel - 1), 2>;      // Selection
+        template <unsigned channel> using OCPE  = Field<CCMR1, 8 * (channel - 1) + 3, 1>;  // Output compare preload
+        template <unsigned channel> using OCM   = Field<CCMR1, 8 * (channel - 1) + 4, 3>;  // Output compare mode
+        template <unsigned channel> using ICPSC = Field<CCMR1, 8 * (channel - 1) + 2, 2>;  // Input capture prescaler
+        template <unsigned channel> using ICF   = Field<CCMR1, 8 * (channel - 1) + 4, 4>;  // Input capture filter
+
+        static constexpr std::uint32_t output     { 0x0 };    // CCS
+        static constexpr std::uint32_t input_TI   { 0x1 };    // Capture from the channel's own input
+        static constexpr std::uint32_t pwm_mode_1 { 0x6 };    // OCM: active while CNT < CCR
+        static constexpr std::uint32_t pwm_mode_2 { 0x7 };    // OCM: inactive while CNT < CCR
+      };
+
+      struct CCMR2 : Register<CCMR2, base + 0x1C>
+      {
+        template <unsigned channel> using CCS   = Field<CCMR2, 8 * (channel - 3), 2>;
+        template <unsigned channel> using OCPE  = Field<CCMR2, 8 * (channel - 3) + 3, 1>;
+        template <unsigned channel> using OCM   = Field<CCMR2, 8 * (channel - 3) + 4, 3>;
+        template <unsigned channel> using ICPSC = Field<CCMR2, 8 * (channel - 3) + 2, 2>;
+        template <unsigned channel> using ICF   = Field<CCMR2, 8 * (channel - 3) + 4, 4>;
+
+        static constexpr std::uint32_t output     { 0x0 };
+        static constexpr std::uint32_t input_TI   { 0x1 };
+        static constexpr std::uint32_t pwm_mode_1 { 0x6 };
+        static constexpr std::uint32_t pwm_mode_2 { 0x7 };
+      };
+
+      // Capture/compare enable and polarity
+      //
+      struct CCER : Register<CCER, base + 0x20>
+      {
+        template <unsigned channel> using CCE  = Field<CCER, 4 * (channel - 1), 1>;      // Output / capture enable
+        template <unsigned channel> using CCP  = Field<CCER, 4 * (channel - 1) + 1, 1>;  // Polarity
+        template <unsigned channel> using CCNE = Field<CCER, 4 * (channel - 1) + 2, 1>;  // Complementary output enable
+        template <unsigned channel> using CCNP = Field<CCER, 4 * (channel - 1) + 3, 1>;  // Complementary polarity
+      };
+
+      struct CNT : Register<CNT, base + 0x24> { };
+      struct PSC : Register<PSC, base + 0x28> { };
+      struct ARR : Register<ARR, base + 0x2C> { };
+      struct RCR : Register<RCR, base + 0x30> { };
+
+      template <unsigned channel>
+      struct CCR : Register<CCR<channel>, base + 0x34 + 4 * (channel - 1)> { };
+
+      // Break and dead-time (advanced-control timers)
+      //
+      struct BDTR : Register<BDTR, base + 0x44>
+      {
+        using DTG  = Field<BDTR, 0, 8>;     // Dead-time generator
+        using LOCK = Field<BDTR, 8, 2>;     // Lock configuration
+        using OSSI = Field<BDTR, 10, 1>;    // Off-state selection, idle
+        using OSSR = Field<BDTR, 11, 1>;    // Off-state selection, run
+        using BKE  = Field<BDTR, 12, 1>;    // Break enable
+        using BKP  = Field<BDTR, 13, 1>;    // Break polarity
+        using AOE  = Field<BDTR, 14, 1>;    // Automatic output enable
+        using MOE  = Field<BDTR, 15, 1>;    // Main output enable
+      };
+    };
+
+
+    // Timer kernel clock. The timers run at the bus clock when
+    // the bus prescaler is 1, and at twice the bus clock otherwise
+    //
+    inline std::uint32_t APB1_timer_clock()
+    {
+      const std::uint32_t pclk { SystemClock_PCLK1() };
+      return (pclk == SystemClock_HCLK()) ? pclk : 2 * pclk;
+    }
+
+    inline std::uint32_t APB2_timer_clock()
+    {
+      const std::uint32_t pclk { SystemClock_PCLK2() };
+      return (pclk == SystemClock_HCLK()) ? pclk : 2 * pclk;
+    }
+
+
+    // ---------------------------------------------------------------------
+    // Timer instances with PWM and capture drivers (RM0090 section 2.3,
+    // DS8626 table 9). TIM1 and TIM8 are the advanced-control timers,
+    // with complementary outputs, dead-time and a repetition counter.
+    //
+    enum class Instance { tim_1, tim_2, tim_3, tim_4, tim_5, tim_8 };
+
+    enum class Bus { APB1, APB2 };
+
+    struct Instance_info
+    {
+      uintptr_t     base;
+      Bus           bus;
+      unsigned      clock_enable;   // RCC enable bit on the bus
+      IRQ_number    update_irq;     // Update (TIM1/TIM8) or global interrupt
+      std::uint32_t alt_function;   // GPIO AF number for the channel pins
+      bool          advanced;
+      unsigned      counter_bits;
+    };
+
+    // Indexed by Instance
+    //
+    inline constexpr Instance_info instances[] {
+      { device_base_address(TIMER_1), Bus::APB2, TIMER_1, TIM1_UP_TIM10_IRQ, 1, true,  16 },
+      { device_base_address(TIMER_2), Bus::APB1, TIMER_2, TIM2_IRQ,          1, false, 32 },
+      { device_base_address(TIMER_3), Bus::APB1, TIMER_3, TIM3_IRQ,          2, false, 16 },
+      { device_base_address(TIMER_4), Bus::APB1, TIMER_4, TIM4_IRQ,          2, false, 16 },
+      { device_base_address(TIMER_5), Bus::APB1, TIMER_5, TIM5_IRQ,          2, false, 32 },
+      { device_base_address(TIMER_8), Bus::APB2, TIMER_8, TIM8_UP_TIM13_IRQ, 3, true,  16 },
+    };
+
+    constexpr const Instance_info& info(Instance instance)
+    {
+      return instances[static_cast<unsigned>(instance)];
+    }
+
+    inline void enable_clock(Instance instance)
+    {
+      const Instance_info& timer { info(instance) };
+      if (timer.bus == Bus::APB2) {
+        STM32F407::enable(static_cast<APB2_Device>(timer.clock_enable));
+      }
+      else {
+        STM32F407::enable(static_cast<APB1_Device>(timer.clock_enable));
+      }
+    }
+
+    inline std::uint32_t clock(Instance instance)
+    {
+      return (info(instance).bus == Bus::APB2) ? APB2_timer_clock() : APB1_timer_clock();
+    }
+
+    // ---------------------------------------------------------------------
+    // Dead-time generator setting (BDTR DTG, RM0090 section 17.4.18)
+    // for a delay in nanoseconds, with tDTS the timer clock (CR1 CKD
+    // 0). DTG has four ranges of decreasing resolution:
+    //
+    //   0xxxxxxx   DTG x tDTS                   0-127 clocks
+    //   10xxxxxx   (64 + DTG[5:0]) x 2 tDTS     128-254
+    //   110xxxxx   (32 + DTG[4:0]) x 8 tDTS     256-504
+    //   111xxxxx   (32 + DTG[4:0]) x 16 tDTS    512-1008
+    //
+    // The delay is rounded up, never down, to a setting.
+    //
+    struct Dead_time
+    {
+      std::uint32_t dtg;          // BDTR DTG value
+      std::uint32_t clocks;       // Achieved dead-time in timer clocks
+      bool          valid;        // Delay is within the generator's range
+    };
+
+    constexpr Dead_time dead_time(std::uint32_t timer_clock, std::uint32_t nanoseconds)
+    {
+      const std::uint64_t clocks { (std::uint64_t { timer_clock } * nanoseconds + 999'999'999) / 1'000'000'000 };
+
+      if (clocks <= 127) {
+        return Dead_time { static_cast<std::uint32_t>(clocks), static_cast<std::uint32_t>(clocks), true };
+      }
+      if (clocks <= 254) {
+        const std::uint32_t steps { static_cast<std::uint32_t>((clocks + 1) / 2) };
+        return Dead_time { 0x80 | (steps - 64), 2 * steps, true };
+      }
+      if (clocks <= 504) {
+        const std::uint32_t steps { static_cast<std::uint32_t>((clocks + 7) / 8) };
+        return Dead_time { 0xC0 | (steps - 32), 8 * steps, true };
+      }
+      if (clocks <= 1008) {
+        const std::uint32_t steps { static_cast<std::uint32_t>((clocks + 15) / 16) };
+        return Dead_time { 0xE0 | (steps - 32), 16 * steps, true };
+      }
+      return Dead_time { 0, 0, false };
+    }
+
+    static_assert(dead_time(168'000'000, 500).dtg == 0x54, "168MHz 500ns");
+    static_assert(dead_time(168'000'000, 1'000).dtg == 0x94, "168MHz 1us");
+    static_assert(dead_time(168'000'000, 5'000).clocks == 848, "168MHz 5us");
+    static_assert(!dead_time(168'000'000, 10'000).valid, "168MHz 10us");
+
+  } // namespace Timer_config
+
+} // namespace STM32F407
+
+#endif // TIMER_REGISTERS_H_
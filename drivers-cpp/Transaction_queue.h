@@ -0,0 +1,132 @@
+// Transaction_queue.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef TRANSACTION_QUEUE_H
+#define TRANSACTION_QUEUE_H
+
+#include <cstdint>
+
+// -------------------------------------------------------------------------------------
+// Queues of bus transactions shared between tasks and a driver's
+// interrupt handlers.
+//
+// A transaction is owned by the caller and linked into the queue
+// through its 'next' member, so queuing never allocates or copies and
+// the queue has no fixed size. The transaction at the head is the one
+// on the bus; it stays in the queue until the driver completes it.
+// A transaction must not be changed, or go out of scope, from the
+// time it is queued until its status is complete or failed.
+//
+// Queue updates mask interrupts for a few instructions so that tasks
+// and interrupt handlers can queue transactions on the same bus.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  enum class Transaction_status : std::uint32_t { idle, queued, active, complete, failed };
+
+  // Interrupts are masked (PRIMASK) for the lifetime of the object.
+  // Nested locks restore the mask in force when they were taken.
+  // Host builds have no interrupts; a spin lock keeps the queues
+  // consistent between threads instead
+  //
+  class Interrupt_lock
+  {
+  public:
+#if defined(FEABHAS_HOST_PERIPHERALS)
+    Interrupt_lock()
+    {
+      while (__atomic_test_and_set(&locked, __ATOMIC_ACQUIRE))
+      {
+        ; // Wait...
+      }
+    }
+
+    ~Interrupt_lock() { __atomic_clear(&locked, __ATOMIC_RELEASE); }
+#else
+    // The CMSIS __get_PRIMASK / __disable_irq / __set_PRIMASK; the
+    // CMSIS headers are not included as they define NVIC as a macro
+    //
+    Interrupt_lock()
+    {
+      __asm volatile ("mrs %0, primask" : "=r" (primask));
+      __asm volatile ("cpsid i" : : : "memory");
+    }
+
+    ~Interrupt_lock() { __asm volatile ("msr primask, %0" : : "r" (primask) : "memory"); }
+#endif
+
+    Interrupt_lock(const Interrupt_lock&)            = delete;
+    Interrupt_lock& operator=(const Interrupt_lock&) = delete;
+
+  private:
+#if defined(FEABHAS_HOST_PERIPHERALS)
+    static inline bool locked { false };
+#else
+    std::uint32_t primask { };
+#endif
+  };
+
+
+  // Transaction_Ty has members 'Transaction_Ty* next' and
+  // 'volatile Transaction_status status'
+  //
+  template <typename Transaction_Ty>
+  class Transaction_queue
+  {
+  public:
+    Transaction_queue() = default;
+
+    Transaction_queue(const Transaction_queue&)            = delete;
+    Transaction_queue& operator=(const Transaction_queue&) = delete;
+
+    // Append a transaction. Returns true if the queue was empty:
+    // the caller must then start the transaction, which is now
+    // the head
+    //
+    bool push(Transaction_Ty& transaction)
+    {
+      transaction.next   = nullptr;
+      transaction.status = Transaction_status::queued;
+
+      Interrupt_lock lock { };
+      const bool was_empty { head == nullptr };
+      if (was_empty) {
+        head = &transaction;
+      }
+      else {
+        tail->next = &transaction;
+      }
+      tail = &transaction;
+      return was_empty;
+    }
+
+    // The transaction on the bus, or nullptr if idle
+    //
+    Transaction_Ty* front() const { return head; }
+
+    // Remove the head; returns the next transaction, which the
+    // caller must start, or nullptr if the queue is now empty
+    //
+    Transaction_Ty* pop()
+    {
+      Interrupt_lock lock { };
+      if (head != nullptr) {
+        head = head->next;
+        if (head == nullptr) tail = nullptr;
+      }
+      return head;
+    }
+
+    bool empty() const { return head == nullptr; }
+
+  private:
+    Transaction_Ty* volatile head { };
+    Transaction_Ty*          tail { };
+  };
+
+} // namespace STM32F407
+
+#endif // TRANSACTION_QUEUE_H_
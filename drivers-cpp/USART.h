@@ -6,18 +6,77 @@
 #ifndef USART_H
 #define USART_H
 
+#include <cstdint>
+#include "Peripherals.h"
+#include "Memory_map.h"
+#include "Register.h"
+#include "Bit_band.h"
+#include "GPIO.h"
+#include "USART_utils.h"
+#include "system_clock.h"
+
 namespace STM32F407
 {
+  namespace USART_config
+  {
+    // Default Tx / Rx pins for an instance
+    //
+    template <Instance instance>
+    using Default_tx_pin = GPIO::Pin<info(instance).tx_pins[0].port, info(instance).tx_pins[0].number>;
+
+    template <Instance instance>
+    using Default_rx_pin = GPIO::Pin<info(instance).rx_pins[0].port, info(instance).rx_pins[0].number>;
+  }
+
+  // -----------------------------------------------------------------------------
+  // Polled USART driver, 8 data bits, no parity, 1 stop bit.
+  //
+  // The instance and its Tx / Rx pins are template parameters; the
+  // register addresses, clock, interrupt, DMA streams and alternate
+  // function are resolved at compile time from USART_config::instances
+  // so register access is inlined and several USARTs can run at once:
+  //
+  //   USART<>                                          console;  // USART 3, PB10 / PB11
+  //   USART<USART_config::Instance::usart_6>           sensor;   // PC6 / PC7
+  //   USART<USART_config::Instance::usart_2,
+  //         GPIO::Pin<GPIO_D, 5>,
+  //         GPIO::Pin<GPIO_D, 6>>                      logger;
+  //
+  // A pin that cannot carry the instance's Tx or Rx fails to compile.
+  //
+  // The baud rate divider is calculated from the instance's bus clock
+  // (see USART_config::baud_divider); set_baud_rate() returns the
+  // rate achieved and its error, or valid == false, leaving the rate
+  // unchanged, if the clock cannot generate it.
+  //
+  template <USART_config::Instance instance = USART_config::Instance::usart_3,
+            typename Tx_pin = USART_config::Default_tx_pin<instance>,
+            typename Rx_pin = USART_config::Default_rx_pin<instance>>
   class USART
   {
   public:
-    USART();
-    virtual ~USART();
+    static constexpr const USART_config::Instance_info& config { USART_config::info(instance) };
+    static constexpr IRQ_number irq { config.irq };
+
+    using Registers = USART_config::Registers<config.base>;
+
+    static_assert(USART_config::valid_tx_pin(instance, Tx_pin::port, Tx_pin::number),
+                  "Tx pin cannot be used with this USART");
+    static_assert(USART_config::valid_rx_pin(instance, Rx_pin::port, Rx_pin::number),
+                  "Rx pin cannot be used with this USART");
+
+    explicit USART(std::uint32_t baud = 115200);
+    ~USART();
+
+    USART(const USART&)            = delete;
+    USART& operator=(const USART&) = delete;
 
     void send(char c);
     void send(const char* str);
     char get_char();
-    virtual bool try_get(char& chr);
+    bool try_get(char& chr);
+
+    USART_config::Baud_divider set_baud_rate(std::uint32_t baud);
 
   protected:
     void enable();
@@ -30,12 +89,229 @@ namespace STM32F407
     void write(char chr);
 
   private:
+    using SR  = typename Registers::SR;
+    using DR  = typename Registers::DR;
+    using BRR = typename Registers::BRR;
+    using CR1 = typename Registers::CR1;
+    using CR2 = typename Registers::CR2;
+
+    static void enable_clock();
+    static void disable_clock();
+    static std::uint32_t bus_clock();
     void enable_usart_IO();
+  };
+
 
-    // UART configuration registers
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  USART<instance, Tx_pin, Rx_pin>::USART(std::uint32_t baud)
+  {
+    // Enable the USART clock.
     //
-    volatile struct USART_registers* usart;
-  };
+    enable_clock();
+
+    // Stop the USART before configuring
+    //
+    disable();
+
+    // Reset STOP bits
+    //
+    CR2::modify(CR2::STOP::template value<0>());
+
+    // Setup 8,N,1
+    //
+    CR1::modify(CR1::RE::set | CR1::TE::set);
+
+    set_baud_rate(baud);
+
+    // Configure the Tx / Rx pins for the device
+    //
+    enable_usart_IO();
+
+    enable();
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  USART<instance, Tx_pin, Rx_pin>::~USART()
+  {
+    disable();
+    disable_clock();
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::enable()
+  {
+    CR1::modify(CR1::UE::set);
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::disable()
+  {
+    CR1::modify(CR1::UE::clear);
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::enable_rx_interrupt()
+  {
+    Bit_band::set<typename CR1::RXNEIE>();
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::enable_tx_interrupt()
+  {
+    Bit_band::set<typename CR1::TXEIE>();
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::disable_rx_interrupt()
+  {
+    Bit_band::clear<typename CR1::RXNEIE>();
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::disable_tx_interrupt()
+  {
+    Bit_band::clear<typename CR1::TXEIE>();
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline char USART<instance, Tx_pin, Rx_pin>::read()
+  {
+    return static_cast<char>(DR::read());
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::write(char chr)
+  {
+    DR::write(static_cast<std::uint8_t>(chr));
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::send(char c)
+  {
+    while (!SR::TXE::is_set())
+    {
+      ; // Wait...
+    }
+    write(c);
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline bool USART<instance, Tx_pin, Rx_pin>::try_get(char& chr)
+  {
+    if(SR::RXNE::is_set())
+    {
+      chr = read();
+      return true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline char USART<instance, Tx_pin, Rx_pin>::get_char()
+  {
+    char chr;
+    while(!try_get(chr))
+    {
+      ; // Wait...
+    }
+    return chr;
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::send(const char* str)
+  {
+    while (*str != '\0')
+    {
+      send(*str++);
+    }
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  USART_config::Baud_divider USART<instance, Tx_pin, Rx_pin>::set_baud_rate(std::uint32_t baud)
+  {
+    const USART_config::Baud_divider divider { USART_config::baud_divider(bus_clock(), baud) };
+    if (!divider.valid) return divider;
+
+    // OVER8 can only be changed with the USART disabled
+    //
+    const bool enabled { CR1::UE::is_set() };
+    if (enabled) disable();
+
+    CR1::modify(CR1::OVER8::value(divider.over8));
+    BRR::write(divider.brr);
+
+    if (enabled) enable();
+    return divider;
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::enable_clock()
+  {
+    if constexpr (config.bus == USART_config::Bus::APB2) {
+      STM32F407::enable(static_cast<APB2_Device>(config.clock_enable));
+    }
+    else {
+      STM32F407::enable(static_cast<APB1_Device>(config.clock_enable));
+    }
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline void USART<instance, Tx_pin, Rx_pin>::disable_clock()
+  {
+    if constexpr (config.bus == USART_config::Bus::APB2) {
+      STM32F407::disable(static_cast<APB2_Device>(config.clock_enable));
+    }
+    else {
+      STM32F407::disable(static_cast<APB1_Device>(config.clock_enable));
+    }
+  }
+
+
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  inline std::uint32_t USART<instance, Tx_pin, Rx_pin>::bus_clock()
+  {
+    if constexpr (config.bus == USART_config::Bus::APB2) {
+      return SystemClock_PCLK2();
+    }
+    else {
+      return SystemClock_PCLK1();
+    }
+  }
+
+
+  // -----------------------------------------------------------------------------
+  // Each USART requires two GPIO pins to be reconfigured
+  // to act as the Tx and Rx pins: alternate function,
+  // high speed with pull-up.
+  //
+  template <USART_config::Instance instance, typename Tx_pin, typename Rx_pin>
+  void USART<instance, Tx_pin, Rx_pin>::enable_usart_IO()
+  {
+    STM32F407::enable(Tx_pin::port);
+    STM32F407::enable(Rx_pin::port);
+
+    Tx_pin::template set_alternate<config.alt_function, GPIO::Pull::up>();
+    Rx_pin::template set_alternate<config.alt_function, GPIO::Pull::up>();
+  }
 
 } // namespace STM32F407
 
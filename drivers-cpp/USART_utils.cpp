@@ -3,17 +3,23 @@
 // Feabhas Ltd
 
 #include <cstdint>
-#include "stm32f4xx.h"
+#include "system_clock.h"
 #include "USART_utils.h"
 #include "Peripherals.h"
 #include "Memory_map.h"
-
-using std::uint32_t;
+#include "NVIC.h"
+#include "GPIO.h"
+#include "Bit_band.h"
 
 namespace STM32F407 {
 
     namespace USART_config
     {
+        namespace
+        {
+            using USART3 = Registers<info(Instance::usart_3).base>;
+        }
+
         // USART3 GPIO Configuration
         // PortB:10     ------> USART3_TX
         // PortB:11     ------> USART3_RX
@@ -21,67 +27,42 @@ namespace STM32F407 {
         void usart_enable_IO(void)
         {
             // Enable GPIO B IO Port Clock
-            uint32_t ahb1enr = RCC->AHB1ENR;
-            ahb1enr |= (0x1u << 1);			// Bit1 : GPIOBEN
-            RCC->AHB1ENR = ahb1enr;
-
-            // if pinNum > 8 then use AFR[1]
-            // 4 bits per pin
-            // AF7 (0x07) sets the GPIO B (to USART3 AF functions)
+            STM32F407::enable(GPIO_B);
 
-            uint32_t afr1 = GPIOB->AFR[1];
-            afr1  |= (0x07 << ( 4 * (10 % 8)));	// USART 3 Alt fn
-            afr1  |= (0x07 << ( 4 * (11 % 8)));	//
-            GPIOB->AFR[1] = afr1;
+            // AF7 (USART 3), high speed with pull-up
+            //
+            using Tx = GPIO::Pin<GPIO_B, 10>;
+            using Rx = GPIO::Pin<GPIO_B, 11>;
 
-            uint32_t moder = GPIOB->MODER;
-            moder  |= (0x02 << (10 * 2));		      // Alt function mode
-            moder  |= (0x02 << (11 * 2));		      //
-            GPIOB->MODER= moder;
-
-            uint32_t ospeedr = GPIOB->OSPEEDR;
-            ospeedr |= (0x03 << (10 * 2));	         // High speed
-            ospeedr |= (0x03 << (11 * 2));	         //
-            GPIOB->OSPEEDR = ospeedr;
-
-            uint32_t pupdr = GPIOB->PUPDR;
-            pupdr  |= (0x01 << (10 * 2));		       // Pull-up
-            pupdr  |= (0x01 << (11 * 2));		       //
-            GPIOB->PUPDR = pupdr;
+            Tx::set_alternate<info(Instance::usart_3).alt_function, GPIO::Pull::up>();
+            Rx::set_alternate<info(Instance::usart_3).alt_function, GPIO::Pull::up>();
         }
 
         void usart_configure(void)
         {
-            NVIC_DisableIRQ(USART3_IRQn);
+            NVIC::disable(info(Instance::usart_3).irq);
             usart_enable_IO();
 
-            // Enable GPIO B IO Port Clock
-            uint32_t apb1enr = RCC->APB1ENR;
-            apb1enr |= (0x1u << 18);                // Bit 18 : USART3EN
-            RCC->APB1ENR = apb1enr;
-
-
-            uint32_t cr1 = USART3->CR1;
-            cr1 &= ~((0x1u << 12) | (0x1u << 10));  // no parity, 1 start, 8 data
-            USART3->CR1 =  cr1;
+            // Enable USART 3 Clock
+            STM32F407::enable(USART_3);
 
-            uint32_t cr2 = USART3->CR2;
-            cr2 &= ~(0x3u << 12);                   // 1 stop bit
-            USART3->CR2 = cr2;
+            // no parity, 8 data, 1 stop bit
+            USART3::CR1::modify(USART3::CR1::M::clear | USART3::CR1::PCE::clear);
+            USART3::CR2::modify(USART3::CR2::STOP::value<0>());
 
-            USART3->BRR = 0x008Bu;                  // Baud_rate::baud_115200
+            // 115.2kb from the APB1 clock
+            constexpr std::uint32_t baud { 115200 };
+            const Baud_divider divider { baud_divider(SystemClock_PCLK1(), baud) };
+            USART3::CR1::modify(USART3::CR1::OVER8::value(divider.over8));
+            USART3::BRR::write(divider.brr);
 
-            cr1 = USART3->CR1;
-            cr1 |= (0x1u << 13)  | (0x1u << 3) | (0x1u << 2);   // UE, TE, RE
-            USART3->CR1 = cr1;
+            USART3::CR1::modify(USART3::CR1::UE::set | USART3::CR1::TE::set | USART3::CR1::RE::set);
         }
 
         void usart_enable_rx_interrupts()
         {
-            NVIC_SetPriority(USART3_IRQn, 10);
-            uint32_t cr1 = USART3->CR1;
-            cr1 |= (0x1u << 5);                   // RXNEIE
-            USART3->CR1 =  cr1;
+            NVIC::set_priority(info(Instance::usart_3).irq, 10);
+            Bit_band::set<USART3::CR1::RXNEIE>();
         }
     } // namespace USART_config
 
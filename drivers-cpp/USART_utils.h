@@ -7,6 +7,10 @@
 #define USART_UTILS_H
 
 #include "Memory_map.h"
+#include "Peripherals.h"
+#include "NVIC.h"
+#include "Register.h"
+#include "DMA_registers.h"
 #include <cstdint>
 
 namespace STM32F407
@@ -17,103 +21,237 @@ namespace STM32F407
   namespace USART_config
   {
     // ---------------------------------------------------------------------
-    // USART register definitions
+    // USART register definitions (RM0090 section 30.6)
     //
-    // Status register.
-    // Bits in this register indicate
-    // the current operation of the USART
-    //
-    struct Status
+    template <uintptr_t base>
+    struct Registers
     {
-      std::uint32_t PE : 1;   // Parity error
-      std::uint32_t FE : 1;   // Framing error
-      std::uint32_t NF : 1;   // Noise detected
-      std::uint32_t ORE : 1;  // Overrun error
-      std::uint32_t IDLE : 1; // Idle line detected
-      std::uint32_t RXNE : 1; // Rx buffer not empty
-      std::uint32_t TC : 1;   // Transmission complete
-      std::uint32_t TXE : 1;  // Tx data register empty
-      std::uint32_t LBD : 1;  // Line break detected
-      std::uint32_t CTS : 1;  // Clear To Send
-      std::uint32_t : 0;      // Reserved
+      // Status register.
+      // Bits in this register indicate
+      // the current operation of the USART
+      //
+      struct SR : Register<SR, base + 0x00>
+      {
+        using PE   = Field<SR, 0, 1>;   // Parity error
+        using FE   = Field<SR, 1, 1>;   // Framing error
+        using NF   = Field<SR, 2, 1>;   // Noise detected
+        using ORE  = Field<SR, 3, 1>;   // Overrun error
+        using IDLE = Field<SR, 4, 1>;   // Idle line detected
+        using RXNE = Field<SR, 5, 1>;   // Rx buffer not empty
+        using TC   = Field<SR, 6, 1>;   // Transmission complete
+        using TXE  = Field<SR, 7, 1>;   // Tx data register empty
+        using LBD  = Field<SR, 8, 1>;   // Line break detected
+        using CTS  = Field<SR, 9, 1>;   // Clear To Send
+      };
+
+      // Data register.
+      // The Transmit and Receive buffers are at the
+      // same address in memory.
+      //
+      struct DR : Register<DR, base + 0x04>
+      {
+        using DATA = Field<DR, 0, 9>;
+      };
+
+      // Divisor.  The baud rate is based on the peripheral clock speed.
+      // This has to be scaled down.  This register holds the clock
+      // divisor for the required baud rate.
+      //
+      struct BRR : Register<BRR, base + 0x08>
+      {
+        using FRACTION = Field<BRR, 0, 4>;   // Baud rate clock divisor fractional part
+        using MANTISSA = Field<BRR, 4, 12>;  // Baud rate clock divisor mantissa
+      };
+
+      // Control Register 1.
+      // This register enables / disables core functions on the USART.
+      //
+      struct CR1 : Register<CR1, base + 0x0C>
+      {
+        using SBK    = Field<CR1, 0, 1>;    // Send break
+        using RWU    = Field<CR1, 1, 1>;    // Receiver wake-up
+        using RE     = Field<CR1, 2, 1>;    // Receiver enable
+        using TE     = Field<CR1, 3, 1>;    // Transmitter enable
+        using IDLEIE = Field<CR1, 4, 1>;    // Idle interrupt enable
+        using RXNEIE = Field<CR1, 5, 1>;    // Rx interrupt enable
+        using TCIE   = Field<CR1, 6, 1>;    // Tx complete interrupt enable
+        using TXEIE  = Field<CR1, 7, 1>;    // Tx buffer empty interrupt enable
+        using PEIE   = Field<CR1, 8, 1>;    // Parity error interrupt enable
+        using PS     = Field<CR1, 9, 1>;    // Parity select
+        using PCE    = Field<CR1, 10, 1>;   // Parity control enable
+        using WAKE   = Field<CR1, 11, 1>;   // Wake-up method
+        using M      = Field<CR1, 12, 1>;   // Word length
+        using UE     = Field<CR1, 13, 1>;   // USART enable
+        using OVER8  = Field<CR1, 15, 1>;   // Oversampling mode
+      };
+
+      // Control Register 2.
+      // This register focuses on data transmission properties
+      //
+      struct CR2 : Register<CR2, base + 0x10>
+      {
+        using ADD   = Field<CR2, 0, 4>;     // USART node address
+        using LBDL  = Field<CR2, 5, 1>;     // Line break detection
+        using LBDIE = Field<CR2, 6, 1>;     // Line break detection interrupt enable
+        using LBCL  = Field<CR2, 8, 1>;     // Last bit clock pulse
+        using CPHA  = Field<CR2, 9, 1>;     // Clock phase
+        using CPOL  = Field<CR2, 10, 1>;    // Clock polarity
+        using CLKEN = Field<CR2, 11, 1>;    // Clock enable
+        using STOP  = Field<CR2, 12, 2>;    // Number of stop bits
+        using LINEN = Field<CR2, 14, 1>;    // LIN mode enable
+      };
+
+      // Control Register 3.
+      // Error interrupt, DMA and flow control
+      //
+      struct CR3 : Register<CR3, base + 0x14>
+      {
+        using EIE    = Field<CR3, 0, 1>;    // Error interrupt enable
+        using HDSEL  = Field<CR3, 3, 1>;    // Half-duplex selection
+        using DMAR   = Field<CR3, 6, 1>;    // DMA enable receiver
+        using DMAT   = Field<CR3, 7, 1>;    // DMA enable transmitter
+        using RTSE   = Field<CR3, 8, 1>;    // RTS enable
+        using CTSE   = Field<CR3, 9, 1>;    // CTS enable
+        using ONEBIT = Field<CR3, 11, 1>;   // One sample bit method
+      };
+
+      // Guard time and prescaler register
+      //
+      struct GTPR : Register<GTPR, base + 0x18>
+      {
+        using PSC = Field<GTPR, 0, 8>;      // Prescaler
+        using GT  = Field<GTPR, 8, 8>;      // Guard time
+      };
     };
 
-    // Data register.
-    // The Transmit and Receive buffers are at the
-    // same address in memory (hence the union).
+    // ---------------------------------------------------------------------
+    // USART instances (RM0090 section 2.3, DS8626 tables 9 and 10)
     //
-    union Data
+    enum class Instance { usart_1, usart_2, usart_3, uart_4, uart_5, usart_6 };
+
+    enum class Bus { APB1, APB2 };
+
+    struct Pin_id
     {
-      std::uint32_t tx; // Transmit buffer (bits 0 - 8)
-      std::uint32_t rx; // Receive buffer  (bits 0 - 8)
+      AHB1_Device port;
+      unsigned    number;
     };
 
-    // Divisor.  The baud rate is based on the peripheral clock speed.
-    // This has to be scaled down.  This register holds the clock
-    // divisor for the required baud rate.
+    // Unused entries in the pin lists
     //
-    struct Divisor
+    constexpr Pin_id no_pin { GPIO_A, 16 };
+
+    // DMA controller, stream and request channel
+    // for a USART direction
+    //
+    using DMA_stream = DMA_config::Stream_id;
+
+    struct Instance_info
     {
-      std::uint32_t fraction : 4;  // Baud rate clock divisor fractional part
-      std::uint32_t mantissa : 12; // Baud rate clock divisor mantissa
+      uintptr_t     base;
+      Bus           bus;            // Bus (and therefore clock)
+      unsigned      clock_enable;   // RCC enable bit on the bus
+      IRQ_number    irq;
+      std::uint32_t alt_function;   // GPIO AF number for the Tx / Rx pins
+      DMA_stream    tx_dma;
+      DMA_stream    rx_dma;
+      Pin_id        tx_pins[3];     // Valid Tx pins; the first is the default
+      Pin_id        rx_pins[3];     // Valid Rx pins; the first is the default
     };
 
-    // Control Register 1.
-    // This register enables / disables core functions on the USART.
+    // Indexed by Instance
     //
-    struct Control_1
-    {
-      std::uint32_t SBK : 1;    // Send break
-      std::uint32_t RWU : 1;    // Receiver wake-up
-      std::uint32_t RE : 1;     // Receiver enable
-      std::uint32_t TE : 1;     // Transmitter enable
-      std::uint32_t IDLEIE : 1; // Idle interrupt enable
-      std::uint32_t RXEIE : 1;  // Rx interrupt enable
-      std::uint32_t TCIE : 1;   // Tx complete interrupt enable
-      std::uint32_t TXEIE : 1;  // Tx buffer empty interrupt enable
-      std::uint32_t PEIE : 1;   // Parity error interrupt enable
-      std::uint32_t PS : 1;     // Parity select
-      std::uint32_t PCE : 1;    // Parity control enable
-      std::uint32_t WAKE : 1;   // Wake-up method
-      std::uint32_t M : 1;      // Word length
-      std::uint32_t UE : 1;     // USART enable
-      std::uint32_t : 1;        // reserved
-      std::uint32_t OVER8 : 1;  // Oversampling mode
-      std::uint32_t : 16;       // Reserved
+    inline constexpr Instance_info instances[] {
+      { device_base_address(USART_1), Bus::APB2, USART_1, USART1_IRQ, 7, { 2, 7, 4 }, { 2, 2, 4 },
+        { { GPIO_A, 9 },  { GPIO_B, 6 },  no_pin },       { { GPIO_A, 10 }, { GPIO_B, 7 },  no_pin } },
+      { device_base_address(USART_2), Bus::APB1, USART_2, USART2_IRQ, 7, { 1, 6, 4 }, { 1, 5, 4 },
+        { { GPIO_A, 2 },  { GPIO_D, 5 },  no_pin },       { { GPIO_A, 3 },  { GPIO_D, 6 },  no_pin } },
+      { device_base_address(USART_3), Bus::APB1, USART_3, USART3_IRQ, 7, { 1, 3, 4 }, { 1, 1, 4 },
+        { { GPIO_B, 10 }, { GPIO_C, 10 }, { GPIO_D, 8 } }, { { GPIO_B, 11 }, { GPIO_C, 11 }, { GPIO_D, 9 } } },
+      { device_base_address(USART_4), Bus::APB1, USART_4, UART4_IRQ,  8, { 1, 4, 4 }, { 1, 2, 4 },
+        { { GPIO_A, 0 },  { GPIO_C, 10 }, no_pin },       { { GPIO_A, 1 },  { GPIO_C, 11 }, no_pin } },
+      { device_base_address(USART_5), Bus::APB1, USART_5, UART5_IRQ,  8, { 1, 7, 4 }, { 1, 0, 4 },
+        { { GPIO_C, 12 }, no_pin,         no_pin },       { { GPIO_D, 2 },  no_pin,         no_pin } },
+      { device_base_address(USART_6), Bus::APB2, USART_6, USART6_IRQ, 8, { 2, 6, 5 }, { 2, 1, 5 },
+        { { GPIO_C, 6 },  { GPIO_G, 14 }, no_pin },       { { GPIO_C, 7 },  { GPIO_G, 9 },  no_pin } },
     };
 
-    // Control Register 2.
-    // This register focuses on data transmission properties
+    constexpr const Instance_info& info(Instance instance)
+    {
+      return instances[static_cast<unsigned>(instance)];
+    }
+
+    constexpr bool pin_in(const Pin_id (&pins)[3], AHB1_Device port, unsigned number)
+    {
+      for (const auto& pin : pins) {
+        if (pin.port == port && pin.number == number) return true;
+      }
+      return false;
+    }
+
+    constexpr bool valid_tx_pin(Instance instance, AHB1_Device port, unsigned number)
+    {
+      return pin_in(info(instance).tx_pins, port, number);
+    }
+
+    constexpr bool valid_rx_pin(Instance instance, AHB1_Device port, unsigned number)
+    {
+      return pin_in(info(instance).rx_pins, port, number);
+    }
+
+    // ---------------------------------------------------------------------
+    // Baud rate divider (RM0090 section 30.3.4).
+    //
+    // BRR holds USARTDIV = PCLK / (8 x (2 - OVER8) x baud) with a 4-bit
+    // (16x oversampling) or 3-bit (8x oversampling) fraction. In both
+    // cases the divider counts PCLK / baud in units of one receiver
+    // sample, so the achievable rates, and hence the error, are the
+    // same; 8x oversampling is only used for rates above PCLK / 16,
+    // where 16x cannot reach. The highest rate is PCLK / 8:
+    // 10.5 Mbaud on APB2 (USART 1 and 6) at 84MHz.
     //
-    struct Control_2
+    // baud_divider() is constexpr so rates for a fixed clock can be
+    // checked at compile time:
+    //
+    //   static_assert(baud_divider(84'000'000, 2'000'000).error_ppm == 0);
+    //
+    struct Baud_divider
     {
-      std::uint32_t ADD : 4;   // USART node address
-      std::uint32_t : 1;       // Reserved
-      std::uint32_t LBDL : 1;  // Line break detection
-      std::uint32_t LBDIE : 1; // Line break detection interrupt enable
-      std::uint32_t : 1;       // Reserved
-      std::uint32_t LBCL : 1;  // Last bit clock pulse
-      std::uint32_t CPHA : 1;  // Clock phase
-      std::uint32_t CPOL : 1;  // Clock polarity
-      std::uint32_t CLKEN : 1; // Clock enable
-      std::uint32_t STOP : 2;  // Number of stop bits
-      std::uint32_t LINEN : 1; // LIN mode enable
-      std::uint32_t : 17;      // Reserved
+      std::uint32_t brr;          // BRR register value
+      bool          over8;        // 8x oversampling (CR1 OVER8)
+      std::uint32_t actual;       // Achieved baud rate
+      std::int32_t  error_ppm;    // (actual - requested) / requested, parts per million
+      bool          valid;        // Rate can be generated from this clock
     };
 
+    constexpr Baud_divider baud_divider(std::uint32_t pclk, std::uint32_t baud)
+    {
+      if (baud == 0) return Baud_divider { 0, false, 0, 0, false };
+
+      const std::uint64_t divider { (std::uint64_t { pclk } + baud / 2) / baud };
+      if (divider < 8 || divider > 0xFFFF) return Baud_divider { 0, false, 0, 0, false };
+
+      const bool over8 { divider < 16 };
+      const std::uint32_t brr {
+        over8 ? static_cast<std::uint32_t>(((divider >> 3) << 4) | (divider & 0x7))
+              : static_cast<std::uint32_t>(divider)
+      };
+      const std::uint32_t actual { static_cast<std::uint32_t>((pclk + divider / 2) / divider) };
+      const std::int64_t  error  { (std::int64_t { actual } - std::int64_t { baud }) * 1000000 / baud };
+
+      return Baud_divider { brr, over8, actual, static_cast<std::int32_t>(error), true };
+    }
+
+    static_assert(baud_divider(16'000'000, 115'200).brr == 0x008B, "16MHz 115.2kb");
+    static_assert(baud_divider(84'000'000, 10'500'000).over8, "84MHz 10.5Mb");
+    static_assert(!baud_divider(84'000'000, 12'000'000).valid, "84MHz 12Mb");
+
     // ---------------------------------------------------------------------
     // Transmission configuration properties.
     // These enums are defined so that they match the underlying hardware
     // values.  That is, these enum values can be written directly to the
     // appropriate registers
     //
-    enum class Baud_rate : std::uint32_t {
-      baud_2400   = 0x1A0B,
-      baud_9600   = 0x0683,
-      baud_57600  = 0x0116,
-      baud_115200 = 0x008B
-    };
-
     enum class Data_length { eight, nine };
 
     enum class Stop_bits { one, half, two, one_and_a_half };
@@ -122,19 +260,6 @@ namespace STM32F407
 
     enum class Parity { even, odd };
 
-    // ---------------------------------------------------------------------
-    // USART register address offsets
-    //
-    enum class Register : std::uint32_t {
-      status    = 0x00,
-      data      = 0x04,
-      divisor   = 0x08,
-      control1  = 0x0C,
-      control2  = 0x10,
-      control3  = 0x14,
-      prescaler = 0x18
-    };
-
     // ---------------------------------------------------------------------
     // Helper functions
     //
@@ -0,0 +1,83 @@
+// WMS_board.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef WMS_BOARD_H
+#define WMS_BOARD_H
+
+#include <cstdint>
+#include "Peripherals.h"
+#include "GPIO.h"
+#include "PWM.h"
+
+// -------------------------------------------------------------------------------------
+// Feabhas washing machine simulator (WMS) board, all on GPIO D
+// (see the pin_map and buttons in qemu_wms.py):
+//
+//   0     door (high is open)        8-11  seven-segment display (BCD)
+//   1-3   programme select PS1-PS3   12    motor on
+//   4     cancel                     13    motor direction
+//   5     accept                     14    PS key latch enable
+//   6     motor rotation sensor
+//
+// Each group of outputs is written with one BSRR store, and all the
+// inputs are read with one IDR load:
+//
+//   WMS::initialise();
+//   WMS::Seven_segment::write(5);
+//   if (WMS::Inputs::read() & WMS::accept) ...
+// -------------------------------------------------------------------------------------
+
+namespace WMS
+{
+  using STM32F407::GPIO_D;
+
+  using Board_port    = STM32F407::GPIO::Port<GPIO_D>;
+
+  using Inputs        = STM32F407::GPIO::Pin_group<GPIO_D, 0, 6>;
+  using Buttons       = STM32F407::GPIO::Pin_group<GPIO_D, 0, 5>;
+
+  using Seven_segment = STM32F407::GPIO::Pin_group<GPIO_D, 8, 11>;
+  using Motor         = STM32F407::GPIO::Pin<GPIO_D, 12>;
+  using Direction     = STM32F407::GPIO::Pin<GPIO_D, 13>;
+  using Latch         = STM32F407::GPIO::Pin<GPIO_D, 14>;
+  using Outputs       = STM32F407::GPIO::Pin_group<GPIO_D, 8, 14>;
+
+  // The motor-on pin is also TIM4 channel 1, so the motor can be
+  // driven with PWM (PWM.h) instead of on/off; Motor_pwm::start()
+  // takes the pin over from the GPIO output. TIM4 is a general-purpose
+  // timer: no dead-time or complementary output. The rotation sensor
+  // pin (6) is not a timer input, so closed-loop speed control
+  // (Motor_control.h) needs the sensor wired to a capture input
+  //
+  using Motor_pwm     = STM32F407::PWM<STM32F407::Timer_config::Instance::tim_4, 1,
+                                       Motor>;
+
+  // Input bits as returned by Inputs::read() and Board_port::read()
+  //
+  enum Input : std::uint16_t
+  {
+    door         = 0x1u << 0,
+    ps1          = 0x1u << 1,
+    ps2          = 0x1u << 2,
+    ps3          = 0x1u << 3,
+    cancel       = 0x1u << 4,
+    accept       = 0x1u << 5,
+    motor_sensor = 0x1u << 6,
+  };
+
+  // Enable the port and configure the pins, with all
+  // outputs low
+  //
+  inline void initialise()
+  {
+    Board_port::enable_clock();
+    Outputs::write(0);
+    Outputs::make_output();
+    Inputs::make_input();
+  }
+
+} // namespace WMS
+
+#endif // WMS_BOARD_H_
@@ -0,0 +1,176 @@
+// Peripheral_model.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include "Peripheral_model.h"
+#include "Memory_map.h"
+#include "system_clock.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using std::uint32_t;
+using std::uintptr_t;
+
+namespace
+{
+  // Simulated address regions
+  //
+  struct Region
+  {
+    uintptr_t     base;
+    std::size_t   size;
+    std::uint8_t* memory;
+  };
+
+  alignas(8) std::uint8_t peripheral_memory[0x80000];
+  alignas(8) std::uint8_t scs_memory[0x1000];
+
+  Region regions[] {
+    { STM32F407::Peripheral_base, sizeof peripheral_memory, peripheral_memory },
+    { STM32F407::SCS_base,        sizeof scs_memory,        scs_memory        },
+  };
+
+  // Registers with non-zero reset values (RM0090, PM0214)
+  //
+  struct Reset_value
+  {
+    uintptr_t address;
+    uint32_t  value;
+  };
+
+  constexpr uintptr_t usart_SR { 0x00 };
+  constexpr uintptr_t usart_DR { 0x04 };
+  constexpr uint32_t  usart_ORE  { 0x1u << 3 };
+  constexpr uint32_t  usart_RXNE { 0x1u << 5 };
+
+  const Reset_value reset_values[] {
+    { STM32F407::RCC_base + 0x00, 0x00000083 },    // CR: HSI on and ready
+    { STM32F407::RCC_base + 0x04, 0x24003010 },    // PLLCFGR
+    { STM32F407::RCC_base + 0x30, 0x00100000 },    // AHB1ENR: CCMRAM clock
+    { STM32F407::device_base_address(STM32F407::GPIO_A) + 0x00, 0xA8000000 },  // MODER (debug pins)
+    { STM32F407::device_base_address(STM32F407::GPIO_A) + 0x08, 0x0C000000 },  // OSPEEDR
+    { STM32F407::device_base_address(STM32F407::GPIO_A) + 0x0C, 0x64000000 },  // PUPDR
+    { STM32F407::device_base_address(STM32F407::GPIO_B) + 0x00, 0x00000280 },  // MODER
+    { STM32F407::device_base_address(STM32F407::GPIO_B) + 0x08, 0x000000C0 },  // OSPEEDR
+    { STM32F407::device_base_address(STM32F407::GPIO_B) + 0x0C, 0x00000100 },  // PUPDR
+    { STM32F407::device_base_address(STM32F407::USART_1) + usart_SR, 0x000000C0 }, // TXE, TC
+    { STM32F407::device_base_address(STM32F407::USART_2) + usart_SR, 0x000000C0 },
+    { STM32F407::device_base_address(STM32F407::USART_3) + usart_SR, 0x000000C0 },
+    { STM32F407::device_base_address(STM32F407::USART_4) + usart_SR, 0x000000C0 },
+    { STM32F407::device_base_address(STM32F407::USART_5) + usart_SR, 0x000000C0 },
+    { STM32F407::device_base_address(STM32F407::USART_6) + usart_SR, 0x000000C0 },
+    { STM32F407::SCS_base + 0xD00, 0x410FC241 },   // CPUID: Cortex-M4 r0p1
+  };
+
+  struct Clocks
+  {
+    uint32_t hclk;
+    uint32_t pclk1;
+    uint32_t pclk2;
+  };
+
+  Clocks clocks { };
+
+  void initialise()
+  {
+    static bool initialised { };
+    if (!initialised) {
+      initialised = true;
+      STM32F407::Host::reset();
+    }
+  }
+}
+
+
+namespace STM32F407
+{
+  namespace Host
+  {
+    void* map(uintptr_t address)
+    {
+      initialise();
+      for (auto& region : regions) {
+        if (address >= region.base && address < region.base + region.size) {
+          return region.memory + (address - region.base);
+        }
+      }
+      std::fprintf(stderr, "Peripheral model: access to unmodelled address 0x%08lx\n",
+                   static_cast<unsigned long>(address));
+      std::abort();
+    }
+
+
+    void reset()
+    {
+      for (auto& region : regions) {
+        std::memset(region.memory, 0, region.size);
+      }
+      for (auto& reset : reset_values) {
+        write(reset.address, reset.value);
+      }
+      clocks = { 168000000, 42000000, 84000000 };
+    }
+
+
+    uint32_t read(uintptr_t address)
+    {
+      uint32_t value;
+      std::memcpy(&value, map(address), sizeof value);
+      return value;
+    }
+
+
+    void write(uintptr_t address, uint32_t value)
+    {
+      std::memcpy(map(address), &value, sizeof value);
+    }
+
+
+    void usart_receive(uintptr_t usart_base, char chr)
+    {
+      uint32_t status = read(usart_base + usart_SR);
+      if ((status & usart_RXNE) != 0) status |= usart_ORE;
+      write(usart_base + usart_DR, static_cast<std::uint8_t>(chr));
+      write(usart_base + usart_SR, status | usart_RXNE);
+    }
+
+
+    char usart_transmitted(uintptr_t usart_base)
+    {
+      return static_cast<char>(read(usart_base + usart_DR));
+    }
+
+
+    void set_clocks(uint32_t hclk, uint32_t pclk1, uint32_t pclk2)
+    {
+      initialise();
+      clocks = { hclk, pclk1, pclk2 };
+    }
+
+  } // namespace Host
+
+} // namespace STM32F407
+
+
+// Bus clock accessors (system_clock.h) for the drivers
+//
+extern "C" uint32_t SystemClock_HCLK(void)
+{
+  initialise();
+  return clocks.hclk;
+}
+
+
+extern "C" uint32_t SystemClock_PCLK1(void)
+{
+  initialise();
+  return clocks.pclk1;
+}
+
+
+extern "C" uint32_t SystemClock_PCLK2(void)
+{
+  initialise();
+  return clocks.pclk2;
+}
@@ -0,0 +1,61 @@
+// Peripheral_model.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef PERIPHERAL_MODEL_H
+#define PERIPHERAL_MODEL_H
+
+#include <cstdint>
+
+// -------------------------------------------------------------------------------------
+// Register-level model of the STM32F407 peripherals for host builds
+// (FEABHAS_HOST_PERIPHERALS). STM32F407::peripheral() maps each
+// register address onto simulated memory so the drivers run unchanged
+// on the build machine.
+//
+// Two regions are modelled: the APB1/APB2/AHB1 peripherals
+// (0x40000000 - 0x4007FFFF) and the Cortex-M4 system control space
+// (0xE000E000 - 0xE000EFFF). Accessing any other address aborts.
+//
+// Registers behave as memory: reads and writes have no side effects.
+// Status bits that the hardware would change are set by the model
+// functions below, so a driver test plays the part of the hardware.
+// -------------------------------------------------------------------------------------
+
+namespace STM32F407
+{
+  namespace Host
+  {
+    // Translate a target address to its simulated register
+    //
+    void* map(std::uintptr_t address);
+
+    // Restore every register to its reset value and the
+    // bus clocks to the 168MHz PLL configuration
+    //
+    void reset();
+
+    // Register access bypassing the drivers
+    //
+    std::uint32_t read(std::uintptr_t address);
+    void          write(std::uintptr_t address, std::uint32_t value);
+
+    // USART line side. receive() places a character in the data
+    // register and sets RXNE (overrun if RXNE is already set);
+    // transmitted() returns the last character written to the data
+    // register. The transmitter is always ready (TXE and TC set).
+    //
+    void usart_receive(std::uintptr_t usart_base, char chr);
+    char usart_transmitted(std::uintptr_t usart_base);
+
+    // Bus clock frequencies returned by SystemClock_HCLK(),
+    // SystemClock_PCLK1() and SystemClock_PCLK2()
+    //
+    void set_clocks(std::uint32_t hclk, std::uint32_t pclk1, std::uint32_t pclk2);
+
+  } // namespace Host
+
+} // namespace STM32F407
+
+#endif // PERIPHERAL_MODEL_H_
@@ -0,0 +1,46 @@
+// Timer.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+// Host build replacement for the SysTick timer functions.
+// The tick handler is called from a background thread.
+
+#include "Timer.h"
+
+#ifndef RTOS
+
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace {
+  std::atomic<Tick_handler> tick_handler {};
+  std::once_flag ticker_started {};
+
+  void ticker()
+  {
+    for (;;) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      Tick_handler handler = tick_handler;
+      if (handler != nullptr) handler();
+    }
+  }
+}
+
+void set_tick_handler(Tick_handler handler)
+{
+  tick_handler = handler;
+  std::call_once(ticker_started, [] { std::thread { ticker }.detach(); });
+}
+
+void sleep(duration_mSec period)
+{
+  sleep(std::chrono::milliseconds(period));
+}
+
+void sleep(std::chrono::milliseconds period)
+{
+  std::this_thread::sleep_for(period);
+}
+
+#endif
@@ -0,0 +1,246 @@
+// drivers_bench.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <cstdint>
+#include <benchmark/benchmark.h>
+#include "FIFO.h"
+#include "Memory_map.h"
+#include "Peripherals.h"
+#include "Peripheral_model.h"
+#include "USART.h"
+#include "WMS_board.h"
+#include "Debouncer.h"
+#include "Motor_control.h"
+#include "Transaction_queue.h"
+
+// -------------------------------------------------------------------------------------
+// Host micro-benchmarks of the C++ drivers running against the
+// peripheral model. Times are for the build machine, not the
+// target, but show the relative cost of driver changes.
+// Run with --help for the Google Benchmark options.
+// -------------------------------------------------------------------------------------
+
+namespace {
+
+  using Console = STM32F407::USART<>;
+  using Sensor  = STM32F407::USART<STM32F407::USART_config::Instance::usart_6>;
+
+  constexpr std::uintptr_t usart_3 { Console::config.base };
+  constexpr std::uintptr_t usart_6 { Sensor::config.base };
+
+
+  void BM_FIFO_add_get(benchmark::State& state)
+  {
+    FeabhOS::Utility::FIFO<int, 16> fifo { };
+    int value { };
+
+    for (auto _ : state) {
+      fifo.add(1);
+      fifo.get(value);
+      benchmark::DoNotOptimize(value);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+
+  void BM_Peripheral_enable_disable(benchmark::State& state)
+  {
+    STM32F407::Host::reset();
+
+    for (auto _ : state) {
+      STM32F407::enable(STM32F407::GPIO_D);
+      STM32F407::disable(STM32F407::GPIO_D);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+
+  // Seven-segment display: four pins in one BSRR store
+  //
+  void BM_GPIO_group_write(benchmark::State& state)
+  {
+    STM32F407::Host::reset();
+    WMS::initialise();
+    std::uint32_t digit { };
+
+    for (auto _ : state) {
+      WMS::Seven_segment::write(digit++);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+
+  // Sixteen inputs, one bouncing, debounced with vertical
+  // counters and, for comparison, a counter per input
+  //
+  constexpr std::uint16_t bounce[] { 0x0001, 0x0000, 0x0001, 0x0001, 0x0001, 0x0001, 0x0000, 0x0000 };
+
+  void BM_Debouncer_vertical(benchmark::State& state)
+  {
+    STM32F407::Debouncer<> debouncer { };
+    unsigned edges { };
+    unsigned i { };
+
+    for (auto _ : state) {
+      auto result = debouncer.sample(bounce[i++ % 8]);
+      edges += result.any() ? 1 : 0;
+    }
+
+    benchmark::DoNotOptimize(edges);
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 16));
+  }
+
+
+  void BM_Debouncer_per_input(benchmark::State& state)
+  {
+    std::uint16_t debounced { };
+    std::uint8_t  count[16] { };
+    unsigned edges { };
+    unsigned i { };
+
+    for (auto _ : state) {
+      const std::uint16_t input { bounce[i++ % 8] };
+      for (unsigned pin = 0; pin < 16; ++pin) {
+        const std::uint16_t bit = static_cast<std::uint16_t>(0x1u << pin);
+        if ((input & bit) != (debounced & bit)) {
+          if (++count[pin] == 4) {
+            debounced = static_cast<std::uint16_t>(debounced ^ bit);
+            count[pin] = 0;
+            ++edges;
+          }
+        }
+        else {
+          count[pin] = 0;
+        }
+      }
+      benchmark::DoNotOptimize(count);
+    }
+
+    benchmark::DoNotOptimize(edges);
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 16));
+  }
+
+
+  // One step of the fixed-point speed loop controller against a
+  // first-order motor model; the speed must settle at the target
+  //
+  void BM_PI_controller_step(benchmark::State& state)
+  {
+    STM32F407::PI_controller controller { { 0x0400, 0x0010 }, 0, 0x8000 };
+    std::int32_t speed { };
+    const std::int32_t target { 50 << 8 };
+
+    for (auto _ : state) {
+      const std::int32_t duty { controller.step(target - speed) };
+      speed += (duty - speed / 2) / 64;
+      benchmark::DoNotOptimize(speed);
+    }
+
+    if (state.iterations() > 100'000 && (speed < target - 256 || speed > target + 256)) {
+      state.SkipWithError("Speed did not settle");
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+
+  // Queue and complete bus transactions, four devices at a time:
+  // the per-transaction overhead of a shared SPI or I2C bus
+  //
+  struct Bus_transaction
+  {
+    Bus_transaction* next { };
+    volatile STM32F407::Transaction_status status { STM32F407::Transaction_status::idle };
+  };
+
+  void BM_Transaction_queue(benchmark::State& state)
+  {
+    STM32F407::Transaction_queue<Bus_transaction> queue { };
+    Bus_transaction devices[4] { };
+    std::uint32_t started { };
+
+    for (auto _ : state) {
+      for (auto& transaction : devices) {
+        if (queue.push(transaction)) ++started;
+      }
+      while (queue.pop() != nullptr) {
+        ++started;
+      }
+      benchmark::DoNotOptimize(started);
+    }
+
+    if (!queue.empty() || started != 4 * state.iterations()) {
+      state.SkipWithError("Transactions lost");
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(4 * state.iterations()));
+  }
+
+
+  void BM_USART_send(benchmark::State& state)
+  {
+    STM32F407::Host::reset();
+    Console usart { };
+
+    for (auto _ : state) {
+      usart.send("Hello world\n");
+    }
+
+    if (STM32F407::Host::usart_transmitted(usart_3) != '\n') {
+      state.SkipWithError("USART data register not written");
+    }
+    state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations() * 12));
+  }
+
+
+  void BM_USART_try_get(benchmark::State& state)
+  {
+    STM32F407::Host::reset();
+    Console usart { };
+    char chr { };
+
+    for (auto _ : state) {
+      STM32F407::Host::usart_receive(usart_3, 'A');
+      usart.try_get(chr);
+      benchmark::DoNotOptimize(chr);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+
+  // Two USARTs polled together; each instance's registers
+  // are resolved at compile time
+  //
+  void BM_USART_two_links(benchmark::State& state)
+  {
+    STM32F407::Host::reset();
+    Console console { };
+    Sensor  sensor { };
+    char chr { };
+
+    for (auto _ : state) {
+      STM32F407::Host::usart_receive(usart_6, 'S');
+      if (sensor.try_get(chr)) console.send(chr);
+    }
+
+    if (STM32F407::Host::usart_transmitted(usart_3) != 'S') {
+      state.SkipWithError("Sensor data not forwarded");
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+} // namespace
+
+BENCHMARK(BM_FIFO_add_get);
+BENCHMARK(BM_Peripheral_enable_disable);
+BENCHMARK(BM_GPIO_group_write);
+BENCHMARK(BM_Debouncer_vertical);
+BENCHMARK(BM_Debouncer_per_input);
+BENCHMARK(BM_PI_controller_step);
+BENCHMARK(BM_Transaction_queue);
+BENCHMARK(BM_USART_send);
+BENCHMARK(BM_USART_try_get);
+BENCHMARK(BM_USART_two_links);
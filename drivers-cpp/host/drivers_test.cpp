@@ -0,0 +1,819 @@
+// drivers_test.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include "Memory_map.h"
+#include "Peripherals.h"
+#include "Peripheral_model.h"
+#include "GPIO.h"
+#include "USART.h"
+#include "ADC.h"
+#include "PWM.h"
+#include "Tachometer.h"
+#include "Motor_control.h"
+#include "I2C.h"
+#include "SPI.h"
+#include "Transaction_queue.h"
+#include "Debouncer.h"
+
+// -------------------------------------------------------------------------------------
+// Host tests of the C++ drivers against the peripheral model, run
+// by ctest. Each test resets the model and checks the register
+// values a driver writes. Registers are plain memory in the model,
+// so the expected values include the reset values of other bits.
+// -------------------------------------------------------------------------------------
+
+namespace {
+
+  unsigned failures { };
+
+  void check(bool passed, const char* expression, const char* file, int line)
+  {
+    if (!passed) {
+      std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+      ++failures;
+    }
+  }
+
+  void check_equal(std::uint32_t actual, std::uint32_t expected,
+                   const char* expression, const char* file, int line)
+  {
+    if (actual != expected) {
+      std::fprintf(stderr, "%s:%d: %s is 0x%08X, expected 0x%08X\n",
+                   file, line, expression, unsigned(actual), unsigned(expected));
+      ++failures;
+    }
+  }
+
+#define CHECK(expression)                 check((expression), #expression, __FILE__, __LINE__)
+#define CHECK_EQUAL(actual, expected)     check_equal((actual), (expected), #actual, __FILE__, __LINE__)
+
+  using STM32F407::Host::read;
+
+  constexpr std::uintptr_t RCC_AHB1ENR { STM32F407::RCC_base + 0x30 };
+  constexpr std::uintptr_t RCC_APB1ENR { STM32F407::RCC_base + 0x40 };
+  constexpr std::uintptr_t RCC_APB2ENR { STM32F407::RCC_base + 0x44 };
+
+  constexpr std::uintptr_t gpio_b { STM32F407::device_base_address(STM32F407::GPIO_B) };
+  constexpr std::uintptr_t gpio_d { STM32F407::device_base_address(STM32F407::GPIO_D) };
+
+  constexpr std::uintptr_t MODER   { 0x00 };
+  constexpr std::uintptr_t OSPEEDR { 0x08 };
+  constexpr std::uintptr_t PUPDR   { 0x0C };
+  constexpr std::uintptr_t AFRL    { 0x20 };
+  constexpr std::uintptr_t AFRH    { 0x24 };
+
+  constexpr std::uintptr_t BRR { 0x08 };
+  constexpr std::uintptr_t CR1 { 0x0C };
+  constexpr std::uintptr_t CR2 { 0x10 };
+
+  constexpr std::uint32_t CR1_RE    { 0x1u << 2 };
+  constexpr std::uint32_t CR1_TE    { 0x1u << 3 };
+  constexpr std::uint32_t CR1_UE    { 0x1u << 13 };
+  constexpr std::uint32_t CR1_OVER8 { 0x1u << 15 };
+
+
+  // USART3 on its default pins (PB10 Tx, PB11 Rx, AF7) at 115200
+  // baud: PCLK1 is 42MHz so USARTDIV is 364.6, rounded to 365
+  // (BRR 0x16D) with 16x oversampling
+  //
+  void test_USART_configure()
+  {
+    STM32F407::Host::reset();
+    using Console = STM32F407::USART<>;
+    constexpr std::uintptr_t usart_3 { Console::config.base };
+
+    {
+      Console console { 115200 };
+
+      CHECK_EQUAL(read(usart_3 + BRR), 0x016D);
+      CHECK_EQUAL(read(usart_3 + CR1), CR1_UE | CR1_TE | CR1_RE);
+      CHECK_EQUAL(read(usart_3 + CR2), 0x0000);
+
+      CHECK((read(RCC_APB1ENR) & (0x1u << 18)) != 0);       // USART3EN
+      CHECK((read(RCC_AHB1ENR) & (0x1u << 1)) != 0);        // GPIOBEN
+
+      CHECK_EQUAL(read(gpio_b + MODER),   0x00A00280);      // PB10/11 alternate
+      CHECK_EQUAL(read(gpio_b + AFRH),    0x00007700);      // AF7
+      CHECK_EQUAL(read(gpio_b + OSPEEDR), 0x00F000C0);      // High speed
+      CHECK_EQUAL(read(gpio_b + PUPDR),   0x00500100);      // Pull-up
+    }
+
+    // Destruction disables the USART and its clock
+    //
+    CHECK_EQUAL(read(usart_3 + CR1) & CR1_UE, 0);
+    CHECK_EQUAL(read(RCC_APB1ENR) & (0x1u << 18), 0);
+  }
+
+
+  // USART6 on APB2 (84MHz) at 10.5Mbaud needs a divider of 8, so
+  // 8x oversampling: BRR holds 8 / 8 = 1 in the mantissa
+  //
+  void test_USART_over8()
+  {
+    STM32F407::Host::reset();
+    using Sensor = STM32F407::USART<STM32F407::USART_config::Instance::usart_6>;
+    constexpr std::uintptr_t usart_6 { Sensor::config.base };
+
+    Sensor sensor { 10'500'000 };
+
+    CHECK_EQUAL(read(usart_6 + BRR), 0x0010);
+    CHECK_EQUAL(read(usart_6 + CR1), CR1_OVER8 | CR1_UE | CR1_TE | CR1_RE);
+    CHECK((read(RCC_APB2ENR) & (0x1u << 5)) != 0);          // USART6EN
+  }
+
+
+  // set_alternate() only changes the fields of its own pin;
+  // pins 0-7 use AFRL and 8-15 use AFRH
+  //
+  void test_GPIO_set_alternate()
+  {
+    STM32F407::Host::reset();
+    STM32F407::Host::write(gpio_d + MODER, 0x55555555);     // All outputs
+    STM32F407::Host::write(gpio_d + AFRL,  0x11111111);
+    STM32F407::Host::write(gpio_d + AFRH,  0x11111111);
+
+    using PD5  = STM32F407::GPIO::Pin<STM32F407::GPIO_D, 5>;
+    using PD12 = STM32F407::GPIO::Pin<STM32F407::GPIO_D, 12>;
+
+    PD5::set_alternate<7, STM32F407::GPIO::Pull::up>();
+
+    CHECK_EQUAL(read(gpio_d + MODER),   0x55555955);
+    CHECK_EQUAL(read(gpio_d + AFRL),    0x11711111);
+    CHECK_EQUAL(read(gpio_d + AFRH),    0x11111111);
+    CHECK_EQUAL(read(gpio_d + OSPEEDR), 0x00000C00);
+    CHECK_EQUAL(read(gpio_d + PUPDR),   0x00000400);
+
+    PD12::set_alternate<2>();
+
+    CHECK_EQUAL(read(gpio_d + MODER),   0x56555955);
+    CHECK_EQUAL(read(gpio_d + AFRL),    0x11711111);
+    CHECK_EQUAL(read(gpio_d + AFRH),    0x11121111);
+    CHECK_EQUAL(read(gpio_d + OSPEEDR), 0x03000C00);
+    CHECK_EQUAL(read(gpio_d + PUPDR),   0x00000400);
+  }
+
+
+  // PWM and Tachometer enable the clocks of their pin ports
+  // before connecting the pins: PE9/PE8 on TIM1 and PA0 on TIM5
+  //
+  void test_timer_pin_clocks()
+  {
+    STM32F407::Host::reset();
+    using STM32F407::GPIO::Pin;
+    using STM32F407::GPIO_A;
+    using STM32F407::GPIO_E;
+
+    using Phase = STM32F407::PWM<STM32F407::Timer_config::Instance::tim_1, 1, Pin<GPIO_E, 9>, Pin<GPIO_E, 8>>;
+    using Tacho = STM32F407::Tachometer<STM32F407::Timer_config::Instance::tim_5, 1, Pin<GPIO_A, 0>>;
+
+    Phase phase { };
+    CHECK(phase.start(20'000, 500));
+    CHECK((read(RCC_AHB1ENR) & (0x1u << 4)) != 0);          // GPIOEEN
+    CHECK_EQUAL(read(STM32F407::device_base_address(GPIO_E) + MODER) & 0x000F0000, 0x000A0000);
+
+    Tacho tacho { };
+    CHECK(tacho.start());
+    CHECK((read(RCC_AHB1ENR) & (0x1u << 0)) != 0);          // GPIOAEN
+  }
+
+
+  // The tachometer's period is the difference between successive
+  // captures, modulo the counter's range, so a capture after the
+  // counter wraps still gives the right period. The model does not
+  // clear the capture flag when CCR is read, so capture() does.
+  //
+  template <typename Tacho_Ty>
+  bool capture(Tacho_Ty& tacho, std::uint32_t count, std::uint32_t flags = 0)
+  {
+    using SR = typename Tacho_Ty::Registers::SR;
+
+    STM32F407::Host::write(Tacho_Ty::CCR::address, count);
+    STM32F407::Host::write(SR::address, SR::CC1IF::mask | flags);
+    const bool measured { tacho.update() };
+    STM32F407::Host::write(SR::address, 0);
+    return measured;
+  }
+
+
+  void test_Tachometer_period()
+  {
+    STM32F407::Host::reset();
+    using STM32F407::GPIO::Pin;
+    using STM32F407::GPIO_A;
+    using STM32F407::Timer_config::Instance;
+
+    using Tacho = STM32F407::Tachometer<Instance::tim_5, 1, Pin<GPIO_A, 0>>;
+    Tacho tacho { };
+    CHECK(tacho.start());
+    CHECK_EQUAL(tacho.frequency(), 0);
+
+    // The first capture only starts the measurement
+    //
+    CHECK(!capture(tacho, 1000));
+    CHECK_EQUAL(tacho.period(), 0);
+
+    // 2000us is 500Hz: 500 << 8 in Q24.8
+    //
+    CHECK(capture(tacho, 3000));
+    CHECK_EQUAL(tacho.period(), 2000);
+    CHECK_EQUAL(tacho.frequency(), 500 << 8);
+
+    // Across the 32-bit counter's overflow
+    //
+    CHECK(capture(tacho, 0xFFFFFF00));
+    CHECK(capture(tacho, 0x00000100));
+    CHECK_EQUAL(tacho.period(), 0x200);
+    CHECK_EQUAL(tacho.frequency(), (1'000'000u * 256) / 0x200);
+
+    // An overcapture loses the period: the next capture
+    // restarts the measurement
+    //
+    CHECK(!capture(tacho, 0x00000300, Tacho::Registers::SR::CC1OF::mask));
+    CHECK_EQUAL(tacho.period(), 0x200);
+    CHECK(capture(tacho, 0x00000700));
+    CHECK_EQUAL(tacho.period(), 0x400);
+
+    // No capture for more than the stall time (100ms)
+    //
+    STM32F407::Host::write(Tacho::Registers::CNT::address, 0x00000700 + 100'001);
+    CHECK(!tacho.update());
+    CHECK_EQUAL(tacho.period(), 0);
+    CHECK_EQUAL(tacho.frequency(), 0);
+
+    // A 16-bit timer wraps at 0xFFFF; with a capture every
+    // 4th edge the frequency is four times the capture rate
+    //
+    using Tacho_16 = STM32F407::Tachometer<Instance::tim_3, 1, Pin<GPIO_A, 6>>;
+    Tacho_16 tacho_16 { };
+    CHECK(!tacho_16.start(Tacho_16::Edges::every, 100'000));
+    CHECK(tacho_16.start(Tacho_16::Edges::every_4th, 20'000));
+
+    CHECK(!capture(tacho_16, 0xFF00));
+    CHECK(capture(tacho_16, 0x0100));
+    CHECK_EQUAL(tacho_16.period(), 0x200);
+    CHECK_EQUAL(tacho_16.frequency(), (1'000'000u * 256 * 4) / 0x200);
+  }
+
+
+  // PI controller: kp 1.0 and ki 1/16 per step, output 0 to 1000
+  //
+  void test_PI_controller()
+  {
+    using STM32F407::PI_controller;
+    constexpr PI_controller::Gains gains { 0x10000, 0x1000 };
+
+    // Step response: the proportional term, then the integral
+    // adds 100 / 16 per step
+    //
+    PI_controller pi { gains, 0, 1000 };
+    CHECK_EQUAL(pi.step(100), 106);
+    CHECK_EQUAL(pi.step(100), 112);
+    CHECK_EQUAL(pi.step(100), 118);
+    CHECK_EQUAL(pi.step(0), 18);
+
+    // Saturation at each limit
+    //
+    pi.reset();
+    CHECK_EQUAL(pi.step(10'000), 1000);
+    CHECK_EQUAL(pi.step(-10'000), 0);
+
+    // Anti-windup: however long the output is held at the limit,
+    // the integral does not grow, so when the error reverses the
+    // output comes straight off the limit
+    //
+    pi.reset(500);
+    for (unsigned i = 0; i < 1000; ++i) {
+      CHECK_EQUAL(pi.step(10'000), 1000);
+    }
+    CHECK(pi.step(-100) < 1000);
+
+    // Bumpless restart
+    //
+    pi.reset(500);
+    CHECK_EQUAL(pi.step(0), 500);
+  }
+
+
+  // Speed_loop with stand-ins for the PWM and the tachometer.
+  // The duty cycle tracks the controller and is limited to
+  // full scale; a speed of zero stops the motor
+  //
+  struct Test_drive
+  {
+    static constexpr std::uint32_t full_scale { 1000 };
+    static bool update_interrupt() { return true; }
+    void set_duty(std::uint32_t value) { duty = value; }
+    std::uint32_t duty { };
+  };
+
+  struct Test_sensor
+  {
+    void update() { }
+    std::uint32_t frequency() const { return speed; }
+    std::uint32_t speed { };
+  };
+
+  void test_Speed_loop()
+  {
+    Test_drive  drive { };
+    Test_sensor sensor { };
+    STM32F407::Speed_loop<Test_drive, Test_sensor> loop { drive, sensor, { 0x10000, 0x1000 } };
+
+    loop.set_speed(100);
+    loop.update_interrupt();
+    CHECK_EQUAL(drive.duty, 106);
+    CHECK_EQUAL(loop.duty(), 106);
+
+    // At the set speed the integral holds the duty cycle
+    //
+    sensor.speed = 100;
+    loop.update_interrupt();
+    CHECK_EQUAL(loop.speed(), 100);
+    CHECK_EQUAL(drive.duty, 6);
+    loop.update_interrupt();
+    CHECK_EQUAL(drive.duty, 6);
+
+    sensor.speed = 0;
+    loop.set_speed(50'000);
+    loop.update_interrupt();
+    CHECK_EQUAL(drive.duty, Test_drive::full_scale);
+
+    loop.set_speed(0);
+    loop.update_interrupt();
+    CHECK_EQUAL(drive.duty, 0);
+  }
+
+
+  // An ADC overrun stops the DMA requests: the ADC interrupt
+  // re-arms the DMA stream, clears OVR and resets CR2.DMA. The
+  // next block is block 0 of the buffer, so the odd sequence
+  // number is skipped
+  //
+  void test_ADC_scan_overrun()
+  {
+    STM32F407::Host::reset();
+    using Sampler = STM32F407::ADC_scan<STM32F407::ADC_config::Instance::adc_1, 2, 8>;
+    using Stream  = Sampler::DMA_stream;
+    using ADC_SR  = Sampler::Registers::SR;
+    using ADC_CR1 = Sampler::Registers::CR1;
+    using ADC_CR2 = Sampler::Registers::CR2;
+
+    static Sampler adc { { { 1 }, { 2 } }, nullptr };
+
+    CHECK(adc.start(1000));
+    CHECK_EQUAL(read(ADC_CR1::address) & ADC_CR1::OVRIE::mask, ADC_CR1::OVRIE::mask);
+
+    // Block 0 completes, then the DMA falls behind part way
+    // through block 1 and the ADC overruns
+    //
+    STM32F407::Host::write(Stream::Registers::LISR::address, STM32F407::DMA_config::Flags::HTIF);
+    adc.dma_interrupt();
+    CHECK_EQUAL(adc.completed(), 1);
+
+    STM32F407::Host::write(Stream::NDTR::address, 5);
+    STM32F407::Host::write(ADC_SR::address, ADC_SR::OVR::mask);
+    adc.adc_interrupt();
+
+    CHECK_EQUAL(read(ADC_SR::address) & ADC_SR::OVR::mask, 0);
+    CHECK_EQUAL(read(ADC_CR2::address) & ADC_CR2::DMA::mask, ADC_CR2::DMA::mask);
+    CHECK_EQUAL(read(Stream::NDTR::address), 2 * Sampler::block_size);
+    CHECK_EQUAL(read(Stream::CR::address) & Stream::CR::EN::mask, Stream::CR::EN::mask);
+    CHECK_EQUAL(adc.errors(), 1);
+    CHECK_EQUAL(adc.completed(), 2);
+
+    // An interrupt from another ADC leaves the scan alone
+    //
+    adc.adc_interrupt();
+    CHECK_EQUAL(adc.errors(), 1);
+
+    adc.stop();
+    CHECK_EQUAL(read(ADC_CR1::address) & ADC_CR1::OVRIE::mask, 0);
+  }
+
+
+  // A transaction queued while another is on the bus follows it
+  // with a repeated start from the BTF event, without a stop. One
+  // submitted while a stop is still being generated is started by
+  // tick() once CR1.STOP clears
+  //
+  void test_I2C_chaining()
+  {
+    STM32F407::Host::reset();
+    using Bus = STM32F407::I2C<STM32F407::I2C_config::Instance::i2c_1>;
+    using CR1 = Bus::Registers::CR1;
+    using SR1 = Bus::Registers::SR1;
+    using STM32F407::Host::write;
+    using STM32F407::I2C_config::Transaction;
+    using STM32F407::Transaction_status;
+
+    constexpr std::uint32_t start_stop { CR1::START::mask | CR1::STOP::mask };
+
+    static const std::uint8_t data[] { 0x3B };
+    static const STM32F407::I2C_config::Segment message[] { STM32F407::I2C_config::write(data, 1) };
+
+    Bus bus { 5, 400'000 };
+    CHECK(CR1::PE::is_set());
+
+    Transaction first  { 0x68, message, 1 };
+    Transaction second { 0x69, message, 1 };
+    Transaction third  { 0x6A, message, 1 };
+
+    CHECK(bus.submit(first));
+    CHECK(bus.submit(second));
+    CHECK_EQUAL(read(CR1::address) & start_stop, CR1::START::mask);
+    CHECK(second.status == Transaction_status::queued);
+
+    // Play the hardware through the first transaction: start
+    // and address sent, then the byte by DMA and BTF
+    //
+    write(CR1::address, read(CR1::address) & ~start_stop);
+    write(SR1::address, SR1::SB::mask);
+    bus.event_interrupt();
+    write(SR1::address, SR1::ADDR::mask);
+    bus.event_interrupt();
+
+    const std::uintptr_t tx_status { (Bus::Tx_stream::stream < 4) ? Bus::Tx_stream::Registers::LISR::address
+                                                                  : Bus::Tx_stream::Registers::HISR::address };
+    write(tx_status, STM32F407::DMA_config::Flags::TCIF << STM32F407::DMA_config::Flags::offset(Bus::Tx_stream::stream));
+    bus.dma_interrupt();
+    write(tx_status, 0);
+    write(SR1::address, SR1::BTF::mask);
+    bus.event_interrupt();
+
+    CHECK(first.status == Transaction_status::complete);
+    CHECK(second.status == Transaction_status::active);
+    CHECK_EQUAL(read(CR1::address) & start_stop, CR1::START::mask);    // Repeated start
+
+    // The second transaction ends the queue with a stop
+    //
+    write(CR1::address, read(CR1::address) & ~start_stop);
+    write(SR1::address, SR1::SB::mask);
+    bus.event_interrupt();
+    write(SR1::address, SR1::ADDR::mask);
+    bus.event_interrupt();
+    write(tx_status, STM32F407::DMA_config::Flags::TCIF << STM32F407::DMA_config::Flags::offset(Bus::Tx_stream::stream));
+    bus.dma_interrupt();
+    write(tx_status, 0);
+    write(SR1::address, SR1::BTF::mask);
+    bus.event_interrupt();
+
+    CHECK(second.status == Transaction_status::complete);
+    CHECK(bus.idle());
+    CHECK_EQUAL(read(CR1::address) & start_stop, CR1::STOP::mask);
+
+    // Submitted while the stop is still set: START waits
+    // for a tick after CR1.STOP clears
+    //
+    write(SR1::address, 0);
+    CHECK(bus.submit(third));
+    CHECK(third.status == Transaction_status::active);
+    CHECK_EQUAL(read(CR1::address) & start_stop, CR1::STOP::mask);
+
+    bus.event_interrupt();
+    bus.tick();
+    CHECK_EQUAL(read(CR1::address) & start_stop, CR1::STOP::mask);     // Still stopping
+
+    write(CR1::address, read(CR1::address) & ~start_stop);
+    bus.event_interrupt();
+    CHECK_EQUAL(read(CR1::address) & start_stop, 0);
+    bus.tick();
+    CHECK_EQUAL(read(CR1::address) & start_stop, CR1::START::mask);
+
+    // A transaction with no segments is rejected
+    //
+    Transaction empty { 0x6B, message, 0 };
+    CHECK(!bus.submit(empty));
+    CHECK(empty.status == Transaction_status::idle);
+  }
+
+
+  // SPI transactions run one after another, each with its own
+  // device's chip select and clock settings. Segments without data
+  // are skipped; the next transaction is started before the
+  // previous one's handler is called
+  //
+  namespace SPI_test {
+
+    int      selects[2] { };                // Chip select active count per device
+    unsigned events { };                    // Select and deselect calls
+
+    void select_a(bool active) { selects[0] += active ? 1 : -1; ++events; }
+    void select_b(bool active) { selects[1] += active ? 1 : -1; ++events; }
+
+    STM32F407::SPI_config::Transaction* completed[3] { };
+    bool next_started[3] { };
+    unsigned completions { };
+
+    void handler(STM32F407::SPI_config::Transaction& transaction, void* next)
+    {
+      auto* const following = static_cast<STM32F407::SPI_config::Transaction*>(next);
+      next_started[completions] = (following == nullptr) ||
+                                  (following->status == STM32F407::Transaction_status::active);
+      completed[completions++] = &transaction;
+    }
+
+  } // namespace SPI_test
+
+  void test_SPI_sequencing()
+  {
+    STM32F407::Host::reset();
+    using Bus = STM32F407::SPI<STM32F407::SPI_config::Instance::spi_2>;
+    using CR1 = Bus::Registers::CR1;
+    using STM32F407::Host::write;
+    using STM32F407::SPI_config::Device;
+    using STM32F407::SPI_config::Mode;
+    using STM32F407::SPI_config::Segment;
+    using STM32F407::SPI_config::Transaction;
+    using STM32F407::Transaction_status;
+    using namespace SPI_test;
+
+    constexpr std::uint32_t mode_bits { CR1::CPOL::mask | CR1::CPHA::mask };
+
+    static const Device sensor { select_a, 1'000'000, Mode::mode_3 };
+    static const Device flash  { select_b, 21'000'000 };
+
+    static const std::uint8_t command[4] { 0x03, 0x00, 0x10, 0x00 };
+    static std::uint8_t       page[8] { };
+    static std::uint8_t       reply[2] { };
+
+    const Segment read_page[] { { command, nullptr, 4 }, { nullptr, nullptr, 0 }, { nullptr, page, 8 } };
+    const Segment exchange[]  { { command, reply, 2 } };
+    const Segment nothing[]   { { command, nullptr, 0 } };
+
+    Bus bus { 5 };
+
+    Transaction first  { &sensor, read_page, 3, handler };
+    Transaction second { &flash,  exchange,  1, handler };
+    Transaction empty  { &flash,  nothing,   1, handler };
+    first.context = &second;
+
+    CHECK(!bus.submit(empty));
+    CHECK(empty.status == Transaction_status::idle);
+    CHECK(bus.idle());
+
+    CHECK(bus.submit(first));
+    CHECK(bus.submit(second));
+    CHECK(first.status == Transaction_status::active);
+    CHECK(second.status == Transaction_status::queued);
+    CHECK_EQUAL(selects[0], 1);
+    CHECK_EQUAL(selects[1], 0);
+    CHECK_EQUAL(read(CR1::address) & mode_bits, mode_bits);
+    CHECK_EQUAL(read(Bus::Rx_stream::NDTR::address), 4);
+
+    const std::uintptr_t rx_status { (Bus::Rx_stream::stream < 4) ? Bus::Rx_stream::Registers::LISR::address
+                                                                  : Bus::Rx_stream::Registers::HISR::address };
+    const std::uint32_t  rx_done   { STM32F407::DMA_config::Flags::TCIF
+                                     << STM32F407::DMA_config::Flags::offset(Bus::Rx_stream::stream) };
+    auto segment_done = [&]() {
+      write(rx_status, rx_done);
+      bus.dma_interrupt();
+      write(rx_status, 0);
+    };
+
+    // The empty segment is skipped
+    //
+    segment_done();
+    CHECK_EQUAL(read(Bus::Rx_stream::NDTR::address), 8);
+    CHECK_EQUAL(read(Bus::Rx_stream::M0AR::address), std::uint32_t(reinterpret_cast<std::uintptr_t>(page)));
+    CHECK_EQUAL(completions, 0);
+
+    // The first transaction ends: its device is deselected and
+    // the second device selected, with its own clock mode
+    //
+    segment_done();
+    CHECK(first.status == Transaction_status::complete);
+    CHECK(second.status == Transaction_status::active);
+    CHECK_EQUAL(selects[0], 0);
+    CHECK_EQUAL(selects[1], 1);
+    CHECK_EQUAL(read(CR1::address) & mode_bits, 0);
+    CHECK_EQUAL(read(Bus::Rx_stream::NDTR::address), 2);
+
+    segment_done();
+    CHECK(second.status == Transaction_status::complete);
+    CHECK(bus.idle());
+    CHECK_EQUAL(selects[1], 0);
+    CHECK_EQUAL(events, 4);
+
+    CHECK_EQUAL(completions, 2);
+    CHECK(completed[0] == &first);
+    CHECK(completed[1] == &second);
+    CHECK(next_started[0]);
+
+    // Interrupts while idle are ignored
+    //
+    segment_done();
+    CHECK_EQUAL(completions, 2);
+  }
+
+
+  struct Bus_transaction {
+    Bus_transaction*                       next   { };
+    volatile STM32F407::Transaction_status status { };
+    std::atomic<unsigned>                  starts { };
+  };
+
+  using Queue = STM32F407::Transaction_queue<Bus_transaction>;
+  using STM32F407::Transaction_status;
+
+
+  // The caller of push() starts the transaction only if the queue
+  // was empty; pop() returns the transaction to start next
+  //
+  void test_Transaction_queue_push_pop()
+  {
+    Queue           queue { };
+    Bus_transaction first { };
+    Bus_transaction second { };
+    Bus_transaction third { };
+
+    CHECK(queue.empty());
+    CHECK(queue.front() == nullptr);
+
+    CHECK(queue.push(first));
+    CHECK(!queue.push(second));
+    CHECK(!queue.push(third));
+    CHECK(queue.front() == &first);
+    CHECK(second.status == Transaction_status::queued);
+
+    CHECK(queue.pop() == &second);
+    CHECK(queue.front() == &second);
+    CHECK(queue.pop() == &third);
+    CHECK(queue.pop() == nullptr);
+    CHECK(queue.empty());
+
+    // The queue is reusable once empty
+    //
+    CHECK(queue.push(second));
+    CHECK(queue.front() == &second);
+    CHECK(queue.pop() == nullptr);
+  }
+
+
+  // A task queues transactions while a second thread, playing the
+  // interrupt handler, completes the head and starts the next.
+  // Every transaction must be started exactly once, in order.
+  //
+  void test_Transaction_queue_hand_off()
+  {
+    constexpr unsigned count { 10000 };
+
+    static Bus_transaction transactions[count] { };
+    Queue                  queue { };
+    std::atomic<unsigned>  completed { };
+    std::atomic<bool>      in_order { true };
+
+    std::thread handler {
+      [&]() {
+        unsigned expected { };
+        while (completed < count) {
+          Bus_transaction* active = queue.front();
+          if (active == nullptr || active->status != Transaction_status::active) continue;
+
+          if (active != &transactions[expected++]) in_order = false;
+          active->status = Transaction_status::complete;
+          ++completed;
+
+          if (Bus_transaction* next = queue.pop()) {
+            ++next->starts;
+            next->status = Transaction_status::active;
+          }
+        }
+      }
+    };
+
+    for (auto& transaction : transactions) {
+      if (queue.push(transaction)) {
+        ++transaction.starts;
+        transaction.status = Transaction_status::active;
+      }
+    }
+
+    handler.join();
+
+    CHECK(in_order);
+    CHECK(queue.empty());
+    unsigned started_once { };
+    for (auto& transaction : transactions) {
+      if (transaction.starts == 1 && transaction.status == Transaction_status::complete) ++started_once;
+    }
+    CHECK_EQUAL(started_once, count);
+  }
+
+
+
+  // An input changes state on the fourth consecutive sample at its
+  // new level; a sample back at the old level resets its count.
+  // Every input is counted on its own.
+  //
+  void test_Debouncer_samples()
+  {
+    STM32F407::Debouncer<> debouncer { };
+
+    for (unsigned i = 0; i < 3; ++i) {
+      CHECK(!debouncer.sample(0x0001).any());
+    }
+    auto edges = debouncer.sample(0x0001);
+    CHECK_EQUAL(edges.rising, 0x0001);
+    CHECK_EQUAL(edges.falling, 0x0000);
+    CHECK_EQUAL(debouncer.state(), 0x0001);
+
+    // Glitches low after one, two and three samples
+    //
+    for (unsigned glitch = 1; glitch <= 3; ++glitch) {
+      for (unsigned i = 0; i < glitch; ++i) {
+        CHECK(!debouncer.sample(0x0000).any());
+      }
+      CHECK(!debouncer.sample(0x0001).any());
+      CHECK_EQUAL(debouncer.state(), 0x0001);
+    }
+
+    // Input 0 falls while input 4 rises two samples behind
+    //
+    CHECK(!debouncer.sample(0x0000).any());
+    CHECK(!debouncer.sample(0x0000).any());
+    CHECK(!debouncer.sample(0x0010).any());
+    edges = debouncer.sample(0x0010);
+    CHECK_EQUAL(edges.rising, 0x0000);
+    CHECK_EQUAL(edges.falling, 0x0001);
+    CHECK(!debouncer.sample(0x0010).any());
+    edges = debouncer.sample(0x0010);
+    CHECK_EQUAL(edges.rising, 0x0010);
+    CHECK_EQUAL(edges.falling, 0x0000);
+    CHECK_EQUAL(debouncer.state(), 0x0010);
+  }
+
+
+  // Debounced_inputs samples on every fifth tick by default, so
+  // a new level must be held for four sample periods (20 ticks)
+  //
+  struct Test_inputs
+  {
+    static inline std::uint16_t level { };
+    static std::uint16_t read() { return level; }
+  };
+
+  void test_Debounced_inputs_ticks()
+  {
+    using STM32F407::Edges;
+
+    static unsigned calls;
+    static Edges<> last;
+    calls = 0;
+    Test_inputs::level = 0x0000;
+
+    STM32F407::Debounced_inputs<Test_inputs> inputs {
+      [](Edges<> edges, void*) { ++calls; last = edges; }
+    };
+
+    Test_inputs::level = 0x0004;
+    for (unsigned tick = 1; tick < 20; ++tick) inputs.tick();
+    CHECK_EQUAL(calls, 0);
+    CHECK_EQUAL(inputs.state(), 0x0000);
+
+    inputs.tick();
+    CHECK_EQUAL(calls, 1);
+    CHECK_EQUAL(last.rising, 0x0004);
+    CHECK_EQUAL(inputs.state(), 0x0004);
+
+    // A glitch that lasts less than a sample period is not seen
+    //
+    Test_inputs::level = 0x0000;
+    for (unsigned tick = 0; tick < 4; ++tick) inputs.tick();
+    Test_inputs::level = 0x0004;
+    for (unsigned tick = 0; tick < 40; ++tick) inputs.tick();
+    CHECK_EQUAL(calls, 1);
+    CHECK_EQUAL(inputs.state(), 0x0004);
+  }
+
+} // namespace
+
+
+int main()
+{
+  test_USART_configure();
+  test_USART_over8();
+  test_GPIO_set_alternate();
+  test_timer_pin_clocks();
+  test_Tachometer_period();
+  test_PI_controller();
+  test_Speed_loop();
+  test_ADC_scan_overrun();
+  test_I2C_chaining();
+  test_SPI_sequencing();
+  test_Transaction_queue_push_pop();
+  test_Transaction_queue_hand_off();
+  test_Debouncer_samples();
+  test_Debounced_inputs_ticks();
+
+  if (failures != 0) {
+    std::fprintf(stderr, "%u check(s) failed\n", failures);
+    return 1;
+  }
+  std::printf("All driver tests passed\n");
+  return 0;
+}
@@ -0,0 +1,164 @@
+// Vibration.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef VIBRATION_H
+#define VIBRATION_H
+
+#include <cstddef>
+#include <cstdint>
+#include "cmsis_device.h"   // Before arm_math.h, which includes only part of core_cm4.h
+#include "arm_math.h"
+
+// -------------------------------------------------------------------------------------
+// Vibration analysis of one channel of ADC_scan blocks (ADC.h) with
+// the CMSIS-DSP q15 kernels.
+//
+// Each block is converted from 12-bit unsigned samples to q15 about
+// mid-scale, filtered by a biquad cascade (for example a DC-blocking
+// high-pass followed by an anti-alias low-pass) and reduced to its RMS
+// and peak levels. The filtered block is kept so spectrum() can
+// compute the magnitude spectrum of the latest block on demand.
+//
+// process() takes about as long as the filter, so it can be called
+// from the ADC block callback through on_block(), or from a task
+// woken by ADC_scan::notify_signal() for heavier processing:
+//
+//   using Sampler = ADC_scan<ADC_config::Instance::adc_1, 1, 512>;
+//   Vibration<Sampler, 2> drum { 0, coefficients, 1 };
+//   Sampler adc { { { 3 } }, Vibration<Sampler, 2>::on_block, &drum };
+//
+// The coefficients are in CMSIS order, { b0, 0, b1, b2, a1, a2 } per
+// stage, scaled down by 2^post_shift (see arm_biquad_cascade_df1_init_q15).
+// -------------------------------------------------------------------------------------
+
+namespace DSP
+{
+  // 12-bit right-aligned ADC sample to q15, 0x800 is zero
+  //
+  inline q15_t to_q15(std::uint16_t sample)
+  {
+    return static_cast<q15_t>((static_cast<std::int32_t>(sample) - 0x800) * 16);
+  }
+
+
+  template <typename ADC_scan_Ty, std::size_t stages>
+  class Vibration
+  {
+  public:
+    using Block = typename ADC_scan_Ty::Block;
+
+    static constexpr std::size_t block_size { ADC_scan_Ty::scans };
+    static constexpr std::size_t bins       { block_size / 2 };
+
+    static_assert(stages >= 1, "The filter needs at least one stage");
+    static_assert(block_size == 128 || block_size == 512 || block_size == 2048,
+                  "The q15 real FFT supports blocks of 128, 512 or 2048 scans");
+
+    struct Level
+    {
+      q15_t rms;
+      q15_t peak;       // Largest magnitude
+      std::uint32_t sequence;
+    };
+
+    Vibration(std::size_t adc_channel, const q15_t (&coefficients)[6 * stages], std::int8_t post_shift);
+
+    Vibration(const Vibration&)            = delete;
+    Vibration& operator=(const Vibration&) = delete;
+
+    void process(const Block& block);
+
+    // Levels of the latest block processed
+    //
+    Level level() const { return latest; }
+
+    // Magnitude spectrum of the latest filtered block, bins of
+    // sample_rate / block_size. Not for interrupt context; the
+    // block is overwritten by the next process()
+    //
+    void spectrum(q15_t (&magnitude)[bins]);
+
+    // ADC_scan handler, with the Vibration object as context
+    //
+    static void on_block(const Block& block, void* context)
+    {
+      static_cast<Vibration*>(context)->process(block);
+    }
+
+  private:
+    std::size_t channel;
+    arm_biquad_casd_df1_inst_q15 filter { };
+    arm_rfft_instance_q15        fft    { };
+    arm_cfft_radix4_instance_q15 cfft   { };
+    bool fft_ready { false };
+
+    q15_t coefficient_store[6 * stages];
+    q15_t state[4 * stages] { };
+    q15_t input[block_size];
+    q15_t output[block_size];
+    q15_t transform[2 * block_size];
+
+    Level latest { };
+  };
+
+
+  template <typename ADC_scan_Ty, std::size_t stages>
+  Vibration<ADC_scan_Ty, stages>::Vibration(std::size_t adc_channel,
+                                            const q15_t (&coefficients)[6 * stages],
+                                            std::int8_t post_shift) :
+    channel { adc_channel }
+  {
+    for (std::size_t i = 0; i < 6 * stages; ++i) {
+      coefficient_store[i] = coefficients[i];
+    }
+    arm_biquad_cascade_df1_init_q15(&filter, static_cast<std::uint8_t>(stages), coefficient_store, state, post_shift);
+    fft_ready = (arm_rfft_init_q15(&fft, &cfft, block_size, 0, 1) == ARM_MATH_SUCCESS);
+  }
+
+
+  template <typename ADC_scan_Ty, std::size_t stages>
+  void Vibration<ADC_scan_Ty, stages>::process(const Block& block)
+  {
+    for (std::size_t scan = 0; scan < block_size; ++scan) {
+      input[scan] = to_q15(block(scan, channel));
+    }
+
+    // 32-bit accumulator: the coefficients must keep each stage's
+    // sums in range (see arm_biquad_cascade_df1_fast_q15)
+    //
+    arm_biquad_cascade_df1_fast_q15(&filter, input, output, block_size);
+
+    Level result { };
+    q15_t maximum { };
+    q15_t minimum { };
+    std::uint32_t index { };
+    arm_rms_q15(output, block_size, &result.rms);
+    arm_max_q15(output, block_size, &maximum, &index);
+    arm_min_q15(output, block_size, &minimum, &index);
+    const std::int32_t negative_peak { -static_cast<std::int32_t>(minimum) };
+    const std::int32_t peak { (negative_peak > maximum) ? negative_peak : maximum };
+    result.peak     = static_cast<q15_t>((peak > INT16_MAX) ? INT16_MAX : peak);
+    result.sequence = block.sequence();
+    latest = result;
+  }
+
+
+  template <typename ADC_scan_Ty, std::size_t stages>
+  void Vibration<ADC_scan_Ty, stages>::spectrum(q15_t (&magnitude)[bins])
+  {
+    if (!fft_ready) return;
+
+    // arm_rfft_q15 modifies its input
+    //
+    for (std::size_t i = 0; i < block_size; ++i) {
+      input[i] = output[i];
+    }
+    arm_rfft_q15(&fft, input, transform);
+    arm_cmplx_mag_q15(transform, magnitude, bins);
+  }
+
+} // namespace DSP
+
+#endif // VIBRATION_H_
@@ -54,7 +54,12 @@
 
 #define configUSE_TIME_SLICING            1
 #define configSUPPORT_DYNAMIC_ALLOCATION  1
+#if defined(OS_USE_CCMRAM)
+// Idle and timer task stacks in CCMRAM, see feabhas_freertos.c
+#define configSUPPORT_STATIC_ALLOCATION   1
+#else
 #define configSUPPORT_STATIC_ALLOCATION   0
+#endif
 
 #define configUSE_POSIX_ERRNO    1
 
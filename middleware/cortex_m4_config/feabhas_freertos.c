@@ -6,6 +6,39 @@
 #include <stdio.h>
 #endif
 
+#if defined(OS_USE_CCMRAM)
+#include "memory_sections.h"
+
+// The kernel's own idle and timer tasks in zero wait state CCMRAM.
+// Application task stacks and kernel objects stay on the heap in SRAM:
+// the DMA controllers cannot access CCMRAM, and drivers may use task
+// stacks and queues for DMA buffers.
+
+static StaticTask_t idle_task FEABHAS_CCM_BSS;
+static StackType_t  idle_stack[ configMINIMAL_STACK_SIZE ] FEABHAS_CCM_BSS;
+
+static StaticTask_t timer_task FEABHAS_CCM_BSS;
+static StackType_t  timer_stack[ configTIMER_TASK_STACK_DEPTH ] FEABHAS_CCM_BSS;
+
+void vApplicationGetIdleTaskMemory( StaticTask_t ** ppxIdleTaskTCBBuffer,
+                                    StackType_t ** ppxIdleTaskStackBuffer,
+                                    uint32_t * pulIdleTaskStackSize )
+{
+    *ppxIdleTaskTCBBuffer   = &idle_task;
+    *ppxIdleTaskStackBuffer = idle_stack;
+    *pulIdleTaskStackSize   = configMINIMAL_STACK_SIZE;
+}
+
+void vApplicationGetTimerTaskMemory( StaticTask_t ** ppxTimerTaskTCBBuffer,
+                                     StackType_t ** ppxTimerTaskStackBuffer,
+                                     uint32_t * pulTimerTaskStackSize )
+{
+    *ppxTimerTaskTCBBuffer   = &timer_task;
+    *ppxTimerTaskStackBuffer = timer_stack;
+    *pulTimerTaskStackSize   = configTIMER_TASK_STACK_DEPTH;
+}
+#endif
+
 
 // Hooks for better diagnostics
 
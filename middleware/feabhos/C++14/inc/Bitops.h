@@ -6,6 +6,8 @@
 #ifndef CPP14_FEABHOS_BITOPS_H
 #define CPP14_FEABHOS_BITOPS_H
 
+#include <cstdint>
+
 namespace FeabhOS {
 
   namespace Utility {
@@ -6,13 +6,22 @@
 #ifndef CPP14_FEABHOS_CONDITION_H
 #define CPP14_FEABHOS_CONDITION_H
 
-#include "Signal.h"
+#include "feabhOS_condition.h"
 #include "Mutex.h"
+#include "Duration.h"
+
+#if !OS_CONDITION_ATOMIC_WAIT
+#include "Signal.h"
+#endif
 
 // -------------------------------------------------------------------------------------
 // The FeabhOS::Condition class provides a C++ wrapper around the
 // FeabhOS condition variable C API.
 //
+// Where the port cannot release the mutex and wait as one
+// operation (OS_CONDITION_ATOMIC_WAIT is 0, as on FreeRTOS) the
+// condition is a Signal, which uses fewer OS objects.
+//
 // -------------------------------------------------------------------------------------
 
 namespace FeabhOS {
@@ -22,7 +31,8 @@ namespace FeabhOS {
 
   class Condition {
   public:
-    Condition() = default;
+    inline Condition();
+    inline ~Condition();
 
     // Condition API:
     // wait()       - Blocking call; will block forever for
@@ -51,15 +61,56 @@ namespace FeabhOS {
     Condition& operator=(Condition&&)      = delete;
 
   private:
+#if OS_CONDITION_ATOMIC_WAIT
+    feabhOS_CONDITION handle { nullptr };
+#else
     Signal signal { };
+#endif
   };
 
 
-  void Condition::wait(Mutex& mutex)
+#if OS_CONDITION_ATOMIC_WAIT
+
+  Condition::Condition()
   {
-    wait_for(mutex, Time::wait_forever);
+    auto err = feabhOS_condition_create(&handle);
+    if (err != ERROR_OK) {
+      // What to do here?
+    }
+  }
+
+
+  // The port releases the mutex and waits as one operation
+  // so a notification cannot be missed between the two.
+  //
+  bool Condition::wait_for(Mutex& mutex, const Time::Duration& timeout)
+  {
+    return (feabhOS_condition_wait(&handle, &mutex.handle, timeout) == ERROR_OK);
+  }
+
+
+  void Condition::notify_one()
+  {
+    feabhOS_condition_notify_one(&handle);
+  }
+
+
+  void Condition::notify_all()
+  {
+    feabhOS_condition_notify_all(&handle);
+  }
+
+
+  Condition::~Condition()
+  {
+    feabhOS_condition_destroy(&handle);
   }
 
+#else
+
+  Condition::Condition()  = default;
+  Condition::~Condition() = default;
+
 
   bool Condition::wait_for(Mutex& mutex, const Time::Duration& timeout)
   {
@@ -71,13 +122,6 @@ namespace FeabhOS {
   }
 
 
-  template <typename Pred_Ty>
-  void Condition::wait_while(Mutex& mutex, const Pred_Ty&& predicate)
-  {
-    while (predicate()) wait(mutex);
-  }
-
-
   void Condition::notify_one()
   {
     signal.notify_one();
@@ -89,6 +133,22 @@ namespace FeabhOS {
     signal.notify_all();
   }
 
+#endif
+
+
+  void Condition::wait(Mutex& mutex)
+  {
+    wait_for(mutex, Time::wait_forever);
+  }
+
+
+  template <typename Pred_Ty>
+  void Condition::wait_while(Mutex& mutex, const Pred_Ty&& predicate)
+  {
+    while (predicate()) wait(mutex);
+  }
+
+
 } // namespace FeabhOS
 
 #endif // CPP14_FEABHOS_CONDITION_H
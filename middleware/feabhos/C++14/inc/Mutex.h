@@ -45,6 +45,10 @@ namespace FeabhOS {
     Mutex& operator=(Mutex&&)       = delete;
 
 private:
+    // Condition waits on the underlying C mutex
+    //
+    friend class Condition;
+
     feabhOS_MUTEX handle { nullptr };
   };
 
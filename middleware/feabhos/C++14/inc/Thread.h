@@ -97,7 +97,8 @@ namespace FeabhOS {
     // Thread destruction
     // Destroying a Thread object will cause it to delete the
     // underlying OS thread.  The behaviour of your application
-    // is undefined.
+    // is undefined.  In particular, a running thread does not
+    // release any Mutex it holds; join() the thread first.
     //
     inline ~Thread();
 
@@ -90,6 +90,9 @@ feabhOS_error feabhOS_task_create(feabhOS_TASK * const  task_handle,
 // ERROR_INVALID_HANDLE     The task's handle was NULL
 // ERROR_PARAM1             The priority was invalid
 // ERROR_STUPID             Attempting to modify terminated task
+// ERROR_UNKNOWN            The OS refused the change (for example,
+//                          the POSIX port is not permitted to use
+//                          real-time priorities)
 //
 feabhOS_error feabhOS_task_setPriority(feabhOS_TASK * const task_handle, feabhOS_priority_t prio);
 
@@ -135,6 +138,13 @@ feabhOS_error feabhOS_task_detach(feabhOS_TASK * const task_handle);
 // -----------------------------------------------------------------------------------------------
 // Destroy a task.
 // After being destroyed the task can no longer be used.
+// A running task is stopped wherever it is: it does not unlock
+// any mutex, or release any other resource, it holds. Only destroy
+// a task that has finished or is known to hold no locks (for
+// example, blocked waiting on a signal, semaphore, event flags or
+// queue; the object no longer counts it as waiting, on every
+// port); otherwise tell the task to return from its function and
+// join it.
 //
 // Parameters:
 // - task_handle            A pointer to a feabhOS_TASK object
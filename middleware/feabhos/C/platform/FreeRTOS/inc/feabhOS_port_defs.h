@@ -54,6 +54,21 @@
 #define MAX_TASKS                 4
 
 
+// ---------------------------------------------------------------------------
+//
+//  Condition implementation
+//  ------------------------
+//
+//  Set to 1 if feabhOS_condition_wait() releases the mutex and
+//  blocks as one operation, so a notify cannot be lost between
+//  the two. The C++ FeabhOS::Condition then wraps the condition
+//  C API. Set to 0 and FeabhOS::Condition waits on a signal
+//  directly; on FreeRTOS this avoids using a condition object as
+//  well as a signal from the fixed pools above.
+//
+#define OS_CONDITION_ATOMIC_WAIT  0
+
+
 // ---------------------------------------------------------------------------
 //  Stack size definitions.
 //  For your underlying OS define the legitimate stack sizes (in bytes).
@@ -0,0 +1,104 @@
+// feabhOS_futex.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef FEABHOS_FUTEX_H
+#define FEABHOS_FUTEX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+#include "feabhOS_time.h"
+
+// -------------------------------------------------------------------------------------
+// Linux futex support for the POSIX port.
+// A futex is a 32-bit word in user memory.  Uncontended operations
+// are atomic updates of the word; the kernel is only entered to
+// block a task while the word holds an expected value, or to wake
+// tasks blocked on the word.
+// The futex implementations of signals, semaphores, mutexes,
+// conditions and event flags are built when FEABHOS_USE_FUTEX is
+// defined.
+//
+typedef uint32_t feabhOS_futex_t;
+
+
+// -------------------------------------------------------------------------------------
+// Convert a timeout into an absolute deadline on the monotonic
+// clock, so that repeated waits (after spurious wake-ups) do not
+// extend the overall timeout.
+//
+// Parameters:
+// - timeout               Duration (not NO_WAIT or WAIT_FOREVER)
+//
+// Return values           current monotonic time + timeout
+//
+struct timespec futex_deadline(duration_mSec_t timeout);
+
+
+// -------------------------------------------------------------------------------------
+// Block the caller while the futex word holds the expected value.
+// Returns immediately if the word has already changed.  Callers
+// must re-check their condition on return as wake-ups may be
+// spurious.  The wait is a cancellation point, so a blocked task
+// can be destroyed.
+//
+// Parameters:
+// - word                  The futex word
+// - expected              Value the word must hold for the caller to block
+// - deadline              Absolute monotonic deadline; NULL waits forever
+//
+// Return values
+// true                    Woken, or the word had changed
+// false                   The deadline passed
+//
+bool futex_wait(feabhOS_futex_t * const word,
+                feabhOS_futex_t         expected,
+                const struct timespec * deadline);
+
+
+// -------------------------------------------------------------------------------------
+// Cancellation cleanup handler for tasks that count themselves
+// into a waiting_tasks word before calling futex_wait().  A task
+// destroyed while blocked is removed from the count, so later
+// notifications are not given to a task that no longer exists.
+// Install with pthread_cleanup_push() around the wait.
+//
+// Parameters:
+// - waiting_tasks         The (feabhOS_futex_t) count to decrement
+//
+void futex_cancel_waiting(void * waiting_tasks);
+
+
+// -------------------------------------------------------------------------------------
+// Wake tasks blocked on the futex word.
+//
+// Parameters:
+// - word                  The futex word
+// - count                 Maximum number of tasks to wake (INT_MAX for all)
+//
+void futex_wake(feabhOS_futex_t * const word, int count);
+
+
+// -------------------------------------------------------------------------------------
+// Wake one task blocked on the futex word and move the rest
+// (without waking them) to wait on a second futex word.  Used by
+// conditions to transfer waiters to the mutex, so a broadcast does
+// not wake every task only for them to contend for the mutex.
+// Fails if the first word no longer holds the expected value.
+//
+// Parameters:
+// - word                  The futex word tasks are blocked on
+// - expected              Value the word must still hold
+// - target                The futex word to move waiting tasks to
+//
+// Return values
+// true                    Waiters were woken or moved
+// false                   The word had changed; the caller should retry
+//
+bool futex_requeue(feabhOS_futex_t * const word,
+                   feabhOS_futex_t         expected,
+                   feabhOS_futex_t * const target);
+
+#endif // FEABHOS_FUTEX_H
@@ -50,6 +50,19 @@
 #define MAX_TASKS                  NO_LIMIT
 
 
+// ---------------------------------------------------------------------------
+//
+//  Condition implementation
+//  ------------------------
+//
+//  Set to 1 if feabhOS_condition_wait() releases the mutex and
+//  blocks as one operation, so a notify cannot be lost between
+//  the two (pthread_cond_wait(), or the futex sequence count).
+//  The C++ FeabhOS::Condition then wraps the condition C API.
+//
+#define OS_CONDITION_ATOMIC_WAIT   1
+
+
 // ---------------------------------------------------------------------------
 //  Stack size definitions.
 //  For your underlying OS define the legitimate stack sizes (in bytes).
@@ -85,6 +98,36 @@
 #define OS_PRIORITY_HIGHEST        5
 
 
+// ---------------------------------------------------------------------------
+//  Real-time scheduling
+//  --------------------
+//
+//  If FEABHOS_REALTIME is defined tasks are created with the SCHED_FIFO
+//  policy, at priority
+//
+//    OS_REALTIME_PRIORITY_BASE +
+//      (priority - OS_PRIORITY_LOWEST) * OS_REALTIME_PRIORITY_STEP
+//
+//  (10..30 by default, below the PREEMPT_RT interrupt threads at 50).
+//  Tasks are pinned to the CPUs in the OS_TASK_CPU_AFFINITY bitmask
+//  (bit n = CPU n; 0 leaves placement to Linux) and memory is locked
+//  with mlockall() when the scheduler is initialised.
+//  As every task stack is locked, stacks are at least
+//  OS_REALTIME_STACK_MIN bytes rather than the Linux default (8MB).
+//
+//  Without the privileges required (CAP_SYS_NICE, CAP_IPC_LOCK or
+//  suitable rlimits) a warning is printed once and tasks run with the
+//  default policy.
+//
+#define OS_REALTIME_PRIORITY_BASE  10
+#define OS_REALTIME_PRIORITY_STEP  5
+#define OS_REALTIME_STACK_MIN      ((size_bytes_t)65536)
+
+#if !defined(OS_TASK_CPU_AFFINITY)
+#define OS_TASK_CPU_AFFINITY       0
+#endif
+
+
 // ---------------------------------------------------------------------------
 //
 //  OS-specific structures
@@ -94,13 +137,27 @@
 //  integer values, structures or pointers-to-opaque-types.  Use the following
 //  macros to define the underlying types used by your OS.
 //
+//  If FEABHOS_USE_FUTEX is defined (Linux only) signals, semaphores,
+//  mutexes and conditions are built directly on 32-bit futex words
+//  (feabhOS_futex_t) rather than the pthread / POSIX semaphore
+//  primitives.
+//
 #define OS_TASK_TYPE               pthread_t
+#if defined(FEABHOS_USE_FUTEX)
+#define OS_MUTEX_TYPE              uint32_t
+#define OS_SIGNAL_TYPE             uint32_t
+#define OS_CONDITION_TYPE          uint32_t
+#define OS_BINARY_SEMAPHORE_TYPE   uint32_t
+#define OS_COUNTING_SEMAPHORE_TYPE uint32_t
+#define OS_SEMAPHORE_TYPE          uint32_t
+#else
 #define OS_MUTEX_TYPE              pthread_mutex_t
 #define OS_SIGNAL_TYPE             sem_t
 #define OS_CONDITION_TYPE          pthread_cond_t
 #define OS_BINARY_SEMAPHORE_TYPE   sem_t
 #define OS_COUNTING_SEMAPHORE_TYPE sem_t
 #define OS_SEMAPHORE_TYPE          sem_t
+#endif
 #define OS_QUEUE_TYPE              mqd_t
 #define OS_MAILBOX_TYPE            mqd_t
 #define OS_EVENTFLAGS_TYPE
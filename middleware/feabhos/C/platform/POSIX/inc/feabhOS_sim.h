@@ -0,0 +1,188 @@
+// feabhOS_sim.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#pragma once
+#ifndef FEABHOS_SIM_H
+#define FEABHOS_SIM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include "feabhOS_time.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// -------------------------------------------------------------------------------------
+// Deterministic simulation kernel for the POSIX port.
+// Built when FEABHOS_SIMULATION is defined.
+//
+// Tasks are still pthreads but only one runs at a time: the
+// highest priority ready task, in FIFO order within a priority
+// (as FreeRTOS without time slicing).  Every other task is parked
+// inside the simulation kernel.  A running task only gives up the
+// processor when it blocks, sleeps or yields, or when it readies a
+// higher priority task.
+//
+// feabhOS time is virtual.  When no task is ready the kernel
+// advances time directly to the next timeout, so sleeps and
+// timed waits cost no wall-clock time and a run always produces
+// the same interleaving.  If no task is ready and none is waiting
+// on a timeout the system is deadlocked; the kernel reports this
+// and aborts.
+//
+// The signal, semaphore, mutex and condition simulation
+// implementations are built on wait queues; other feabhOS objects
+// are built on those.
+//
+
+// -------------------------------------------------------------------------------------
+// Simulation task control block.
+// Embedded in the feabhOS task structure; the task calling
+// feabhOS_scheduler_init() is given a static control block.
+//
+typedef struct sim_task  sim_task;
+typedef struct sim_queue sim_queue;
+
+typedef enum
+{
+  SIM_READY,
+  SIM_BLOCKED,
+  SIM_SLEEPING,
+  SIM_DONE
+} sim_state;
+
+struct sim_queue
+{
+  sim_task* head;
+};
+
+struct sim_task
+{
+  pthread_cond_t run;             // Signalled when the task is scheduled
+  unsigned       priority;
+  sim_state      state;
+  bool           timed_out;
+  bool           killed;
+
+  sim_task*      next;            // Ready list or wait queue link
+  sim_queue*     queue;           // Wait queue the task is blocked on
+
+  sim_task*      timer_next;      // Timer list link
+  uint64_t       wake_time;
+  bool           timer_active;
+
+  sim_queue      joiners;         // Tasks waiting for this task to finish
+};
+
+
+// -------------------------------------------------------------------------------------
+// Register the calling thread as the first simulated task
+// (priority NORMAL) and make it the running task.
+//
+void sim_init(void);
+
+
+// -------------------------------------------------------------------------------------
+// The calling task's control block.
+//
+sim_task* sim_self(void);
+
+
+// -------------------------------------------------------------------------------------
+// Add a new task to the back of its ready list.  Create the
+// task's thread, then call sim_preempt() to run the new task
+// if it has a higher priority than the caller.
+//
+void sim_task_add(sim_task* const task, unsigned priority);
+
+
+// -------------------------------------------------------------------------------------
+// Called by a new task's thread; blocks until first scheduled.
+//
+void sim_task_start(sim_task* const task);
+
+
+// -------------------------------------------------------------------------------------
+// The calling task has finished.  Releases any joining tasks
+// and schedules the next task.  The caller's thread must exit
+// without calling any other feabhOS function.
+//
+void sim_task_exit(void);
+
+
+// -------------------------------------------------------------------------------------
+// Block until the task has finished.
+//
+void sim_task_join(sim_task* const task);
+
+
+// -------------------------------------------------------------------------------------
+// Remove a task (that is not the caller) from the simulation.
+// Its thread is woken and exits (pthread_exit) without running
+// any more task code; kernel calls made while it unwinds do not
+// block or reschedule.  Join the thread before reusing the task.
+// Returns false if the task had already finished.
+//
+bool sim_task_kill(sim_task* const task);
+
+
+// -------------------------------------------------------------------------------------
+// Change the priority of a task.  The caller is preempted if a
+// higher priority task becomes ready as a result.
+//
+void sim_task_set_priority(sim_task* const task, unsigned priority);
+
+
+// -------------------------------------------------------------------------------------
+// Block the calling task on a wait queue.  Tasks are queued in
+// priority order, FIFO within a priority.
+//
+// Parameters:
+// - queue                 The wait queue
+// - timeout               WAIT_FOREVER or a duration (not NO_WAIT)
+//
+// Return values
+// true                    Woken by sim_wake_one() / sim_wake_all()
+// false                   The timeout expired
+//
+bool sim_block(sim_queue* const queue, duration_mSec_t timeout);
+
+
+// -------------------------------------------------------------------------------------
+// Make the first (or every) task on a wait queue ready.
+// The caller is not preempted; once any state handed to the
+// woken tasks is updated call sim_preempt().
+//
+// Return values           The task made ready (NULL if none) / number of tasks
+//
+sim_task* sim_wake_one(sim_queue* const queue);
+unsigned  sim_wake_all(sim_queue* const queue);
+
+
+// -------------------------------------------------------------------------------------
+// Run a higher priority task if one is ready.
+//
+void sim_preempt(void);
+
+
+// -------------------------------------------------------------------------------------
+// Move the calling task to the back of its ready list, or
+// suspend it for a period of virtual time.
+//
+void sim_yield(void);
+void sim_sleep(duration_mSec_t period);
+
+
+// -------------------------------------------------------------------------------------
+// Current virtual time, in milliseconds since sim_init().
+//
+uint64_t feabhOS_sim_time(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // FEABHOS_SIM_H
@@ -86,7 +86,7 @@ block_ptr next(feabhOS_POOL * const pool_handle, block_ptr ptr)
 // FeabhOS mutexes themselves use the allocator!  Instead, we must
 // use the underlying OS mutex mechanism.
 //
-static OS_MUTEX_TYPE alloc_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t alloc_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static inline
 void init_lock(void)
@@ -87,6 +87,16 @@ static void deallocate(feabhOS_CONDITION condition)
 
 #endif
 
+// ----------------------------------------------------------------------------
+// A task cancelled (destroyed) while waiting on a condition
+// re-acquires the mutex before it exits; release it again so
+// the destroyed task does not leave the mutex locked.
+//
+static void unlock_cancelled(void * mutex)
+{
+  pthread_mutex_unlock((OS_MUTEX_TYPE *)mutex);
+}
+
 // ----------------------------------------------------------------------------
 //
 feabhOS_error feabhOS_condition_create(feabhOS_CONDITION * const condition_handle)
@@ -164,6 +174,7 @@ feabhOS_error feabhOS_condition_wait(feabhOS_CONDITION * const condition_handle,
   feabhOS_error error;
 
   OS_MUTEX_TYPE *mutex = feabhOS_mutex_native_handle(mutex_handle);
+  pthread_cleanup_push(unlock_cancelled, mutex);
 
   // POSiX doesn't support infinite timeouts, but it does have
   // blocking and timed-blocking calls
@@ -195,6 +206,8 @@ feabhOS_error feabhOS_condition_wait(feabhOS_CONDITION * const condition_handle,
     }
   }
 
+  pthread_cleanup_pop(0);
+
   return error;
 }
 
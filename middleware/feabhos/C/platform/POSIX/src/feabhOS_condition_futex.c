@@ -0,0 +1,229 @@
+// feabhOS_condition_futex.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+#include <limits.h>
+
+#include "feabhOS_condition.h"
+#include "feabhOS_mutex.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_futex.h"
+
+// ----------------------------------------------------------------------------
+//  Futex condition.
+//  The futex word is a sequence number incremented by every
+//  notification.  A waiting task records the sequence number
+//  before releasing the mutex and only blocks if it has not
+//  changed, so a notification between the two cannot be lost.
+//  notify_all() wakes one task and moves the rest to the mutex
+//  futex; they are then woken one at a time as the mutex is
+//  released, rather than all contending for it at once.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_condition
+{
+  OS_CONDITION_TYPE handle;
+  OS_MUTEX_TYPE*    mutex;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR CONDITION STRUCTURES
+//  ---------------------------------------
+//
+//  For a fixed number of conditions we use a fixed-block
+//  dynamic allocator.
+//  If MAX_CONDITIONS == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_CONDITIONS==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_CONDITION allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_condition));
+}
+
+
+static void deallocate(feabhOS_CONDITION condition)
+{
+  feabhOS_memory_free(condition);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_condition conditions[MAX_CONDITIONS];
+static feabhOS_POOL condition_pool = NULL;
+
+
+static feabhOS_CONDITION allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(condition_pool == NULL)
+  {
+    feabhOS_pool_create(&condition_pool,
+                        conditions,
+                        sizeof(conditions),
+                        sizeof(struct feabhOS_condition),
+                        MAX_CONDITIONS);
+  }
+
+  return feabhOS_block_allocate(&condition_pool);
+}
+
+
+static void deallocate(feabhOS_CONDITION condition)
+{
+  feabhOS_block_free(&condition_pool, condition);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// The condition requires access to the futex mutex.
+// Here, we are using (hidden) functions from the mutex
+// implementation.
+//
+extern OS_MUTEX_TYPE* feabhOS_mutex_native_handle(feabhOS_MUTEX * const mutex_handle);
+extern void           feabhOS_mutex_relock(feabhOS_MUTEX * const mutex_handle);
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_create(feabhOS_CONDITION * const condition_handle)
+{
+  feabhOS_CONDITION condition = allocate();
+  if(condition == NULL) return ERROR_OUT_OF_MEMORY;
+
+  condition->handle = 0;
+  condition->mutex  = NULL;
+
+  *condition_handle = condition;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_notify_one(feabhOS_CONDITION * const condition_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_CONDITION condition = *condition_handle;
+
+  __atomic_add_fetch(&condition->handle, 1, __ATOMIC_SEQ_CST);
+  futex_wake(&condition->handle, 1);
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_notify_all(feabhOS_CONDITION * const condition_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_CONDITION condition = *condition_handle;
+
+  OS_CONDITION_TYPE sequence = __atomic_add_fetch(&condition->handle, 1, __ATOMIC_SEQ_CST);
+  OS_MUTEX_TYPE*    mutex    = __atomic_load_n(&condition->mutex, __ATOMIC_SEQ_CST);
+
+  if(mutex == NULL)
+  {
+    futex_wake(&condition->handle, INT_MAX);
+    return ERROR_OK;
+  }
+
+  // Retry if another notification changes the
+  // sequence number before the waiters are moved
+  //
+  while(!futex_requeue(&condition->handle, sequence, mutex))
+  {
+    sequence = __atomic_load_n(&condition->handle, __ATOMIC_SEQ_CST);
+  }
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_wait(feabhOS_CONDITION * const condition_handle,
+                                     feabhOS_MUTEX     * const mutex_handle,
+                                     duration_mSec_t           timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+  if(mutex_handle == NULL)     return ERROR_PARAM1;
+
+  feabhOS_CONDITION condition = *condition_handle;
+  bool notified = false;
+
+  OS_CONDITION_TYPE sequence = __atomic_load_n(&condition->handle, __ATOMIC_SEQ_CST);
+  __atomic_store_n(&condition->mutex, feabhOS_mutex_native_handle(mutex_handle), __ATOMIC_SEQ_CST);
+
+  feabhOS_mutex_unlock(mutex_handle);
+
+  switch(timeout)
+  {
+  case NO_WAIT:
+    break;
+
+  case WAIT_FOREVER:
+    notified = futex_wait(&condition->handle, sequence, NULL);
+    break;
+
+  default:
+    {
+      struct timespec deadline = futex_deadline(timeout);
+      notified = futex_wait(&condition->handle, sequence, &deadline);
+      break;
+    }
+  }
+
+  feabhOS_mutex_relock(mutex_handle);
+
+  return notified ? ERROR_OK : ERROR_TIMED_OUT;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_destroy(feabhOS_CONDITION * const condition_handle)
+{
+  // Parameter checking:
+  //
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_CONDITION condition = *condition_handle;
+  deallocate(condition);
+
+  return ERROR_OK;
+}
@@ -0,0 +1,192 @@
+// feabhOS_condition_sim.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "feabhOS_condition.h"
+#include "feabhOS_mutex.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_sim.h"
+
+// ----------------------------------------------------------------------------
+//  Simulation condition (see feabhOS_sim.h).
+//  Waiting tasks are queued in priority order.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_condition
+{
+  sim_queue waiting_tasks;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR CONDITION STRUCTURES
+//  ---------------------------------------
+//
+//  For a fixed number of conditions we use a fixed-block
+//  dynamic allocator.
+//  If MAX_CONDITIONS == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_CONDITIONS==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_CONDITION allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_condition));
+}
+
+
+static void deallocate(feabhOS_CONDITION condition)
+{
+  feabhOS_memory_free(condition);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_condition conditions[MAX_CONDITIONS];
+static feabhOS_POOL condition_pool = NULL;
+
+
+static feabhOS_CONDITION allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(condition_pool == NULL)
+  {
+    feabhOS_pool_create(&condition_pool,
+                        conditions,
+                        sizeof(conditions),
+                        sizeof(struct feabhOS_condition),
+                        MAX_CONDITIONS);
+  }
+
+  return feabhOS_block_allocate(&condition_pool);
+}
+
+
+static void deallocate(feabhOS_CONDITION condition)
+{
+  feabhOS_block_free(&condition_pool, condition);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+// The mutex must be released without rescheduling, so no other
+// task can run (and notify the condition) before the caller is
+// waiting.  Here, we are using a (hidden) function from the
+// mutex implementation.
+//
+extern feabhOS_error feabhOS_mutex_release(feabhOS_MUTEX * const mutex_handle);
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_create(feabhOS_CONDITION * const condition_handle)
+{
+  feabhOS_CONDITION condition = allocate();
+  if(condition == NULL) return ERROR_OUT_OF_MEMORY;
+
+  condition->waiting_tasks.head = NULL;
+
+  *condition_handle = condition;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_notify_one(feabhOS_CONDITION * const condition_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_CONDITION condition = *condition_handle;
+
+  sim_wake_one(&condition->waiting_tasks);
+  sim_preempt();
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_notify_all(feabhOS_CONDITION * const condition_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_CONDITION condition = *condition_handle;
+
+  sim_wake_all(&condition->waiting_tasks);
+  sim_preempt();
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_wait(feabhOS_CONDITION * const condition_handle,
+                                     feabhOS_MUTEX     * const mutex_handle,
+                                     duration_mSec_t           timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+  if(mutex_handle == NULL)     return ERROR_PARAM1;
+
+  feabhOS_CONDITION condition = *condition_handle;
+  bool notified = false;
+
+  feabhOS_error error = feabhOS_mutex_release(mutex_handle);
+  if(error != ERROR_OK) return error;
+
+  if(timeout != NO_WAIT)
+  {
+    notified = sim_block(&condition->waiting_tasks, timeout);
+  }
+
+  feabhOS_mutex_lock(mutex_handle, WAIT_FOREVER);
+
+  return notified ? ERROR_OK : ERROR_TIMED_OUT;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_condition_destroy(feabhOS_CONDITION * const condition_handle)
+{
+  // Parameter checking:
+  //
+  if(condition_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_CONDITION condition = *condition_handle;
+  deallocate(condition);
+
+  return ERROR_OK;
+}
@@ -0,0 +1,269 @@
+// feabhOS_eventflags_futex.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <limits.h>
+
+#include "feabhOS_eventflags.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_futex.h"
+
+// ----------------------------------------------------------------------------
+//  Futex event flags.
+//  The futex word holds the flags.  Setting and clearing flags
+//  are atomic bit operations; waiting tasks block on the futex
+//  while the flags hold the value they last checked, and are
+//  all woken when new flags are set.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_eventflags
+{
+  feabhOS_futex_t flags;
+  feabhOS_futex_t waiting_tasks;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR EVENTFLAGS STRUCTURES
+//  ----------------------------------------
+//
+//  For a fixed number of event_flags we use a fixed-block
+//  dynamic allocator.
+//  If MAX_EVENTFLAGS == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_EVENTFLAGS==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_EVENTFLAGS allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_eventflags));
+}
+
+
+static void deallocate(feabhOS_EVENTFLAGS event_flags)
+{
+  feabhOS_memory_free(event_flags);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_eventflags event_flags_objects[MAX_EVENTFLAGS];
+static feabhOS_POOL eventflags_pool = NULL;
+
+
+static feabhOS_EVENTFLAGS allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(eventflags_pool == NULL)
+  {
+    feabhOS_pool_create(&eventflags_pool,
+                        event_flags_objects,
+                        sizeof(event_flags_objects),
+                        sizeof(struct feabhOS_eventflags),
+                        MAX_EVENTFLAGS);
+  }
+
+  return feabhOS_block_allocate(&eventflags_pool);
+}
+
+
+static void deallocate(feabhOS_EVENTFLAGS event_flags)
+{
+  feabhOS_block_free(&eventflags_pool, event_flags);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_eventflags_create(feabhOS_EVENTFLAGS * const events_handle)
+{
+  feabhOS_EVENTFLAGS event_flags = allocate();
+  if(event_flags == NULL) return ERROR_OUT_OF_MEMORY;
+
+  event_flags->flags         = 0;
+  event_flags->waiting_tasks = 0;
+
+  *events_handle = event_flags;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_eventflags_set(feabhOS_EVENTFLAGS * const events_handle,
+                                     bitmask8_t                 flags_to_set)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(events_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_EVENTFLAGS event_flags = *events_handle;
+
+  feabhOS_futex_t previous = __atomic_fetch_or(&event_flags->flags, flags_to_set, __ATOMIC_SEQ_CST);
+
+  // Only wake waiting tasks if the flags have changed
+  //
+  if(((previous | flags_to_set) != previous) &&
+     (__atomic_load_n(&event_flags->waiting_tasks, __ATOMIC_SEQ_CST) > 0))
+  {
+    futex_wake(&event_flags->flags, INT_MAX);
+  }
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+// Wait until the match function is satisfied by the flags.
+// On return flags_to_check holds the current flags.
+//
+typedef bool (*match_fn)(feabhOS_futex_t flags, bitmask8_t to_check);
+
+static bool match_all(feabhOS_futex_t flags, bitmask8_t to_check)
+{
+  return ((flags & to_check) == to_check);
+}
+
+static bool match_any(feabhOS_futex_t flags, bitmask8_t to_check)
+{
+  return ((flags & to_check) != 0);
+}
+
+static feabhOS_error wait_for(feabhOS_EVENTFLAGS         event_flags,
+                              bitmask8_t         * const flags_to_check,
+                              duration_mSec_t            timeout,
+                              match_fn                   match)
+{
+  struct timespec deadline;
+  struct timespec *until = NULL;
+  if((timeout != WAIT_FOREVER) && (timeout != NO_WAIT))
+  {
+    deadline = futex_deadline(timeout);
+    until    = &deadline;
+  }
+
+  feabhOS_error   error = ERROR_OK;
+  feabhOS_futex_t flags = __atomic_load_n(&event_flags->flags, __ATOMIC_SEQ_CST);
+
+  while(!match(flags, *flags_to_check))
+  {
+    if(timeout == NO_WAIT)
+    {
+      error = ERROR_TIMED_OUT;
+      break;
+    }
+
+    bool woken;
+    __atomic_add_fetch(&event_flags->waiting_tasks, 1, __ATOMIC_SEQ_CST);
+    pthread_cleanup_push(futex_cancel_waiting, &event_flags->waiting_tasks);
+    woken = futex_wait(&event_flags->flags, flags, until);
+    pthread_cleanup_pop(1);
+
+    flags = __atomic_load_n(&event_flags->flags, __ATOMIC_SEQ_CST);
+    if(!woken && !match(flags, *flags_to_check))
+    {
+      error = ERROR_TIMED_OUT;
+      break;
+    }
+  }
+
+  *flags_to_check = (bitmask8_t)(flags & 0xFF);
+  return error;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_eventflags_wait_all(feabhOS_EVENTFLAGS * const events_handle,
+                                          bitmask8_t         * const flags_to_check,
+                                          duration_mSec_t            timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(events_handle == NULL) return ERROR_INVALID_HANDLE;
+  if(flags_to_check == 0)   return ERROR_PARAM1;
+  if(*flags_to_check == 0)  return ERROR_STUPID;
+
+  return wait_for(*events_handle, flags_to_check, timeout, match_all);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_eventflags_wait_any(feabhOS_EVENTFLAGS * const events_handle,
+                                          bitmask8_t         * const flags_to_check,
+                                          duration_mSec_t            timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(events_handle == NULL) return ERROR_INVALID_HANDLE;
+  if(flags_to_check == 0)   return ERROR_PARAM1;
+  if(*flags_to_check == 0)  return ERROR_STUPID;
+
+  return wait_for(*events_handle, flags_to_check, timeout, match_any);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_eventflags_clear(feabhOS_EVENTFLAGS * const events_handle,
+                                       bitmask8_t                 flags_to_clear)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(events_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_EVENTFLAGS event_flags = *events_handle;
+
+  __atomic_fetch_and(&event_flags->flags, ~(feabhOS_futex_t)flags_to_clear, __ATOMIC_SEQ_CST);
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_eventflags_clear_all(feabhOS_EVENTFLAGS * const events_handle)
+{
+  return feabhOS_eventflags_clear(events_handle, 0xFF);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_eventflags_destroy(feabhOS_EVENTFLAGS * const events_handle)
+{
+  // Parameter checking:
+  //
+  if(events_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_EVENTFLAGS event_flags = *events_handle;
+  deallocate(event_flags);
+
+  return ERROR_OK;
+}
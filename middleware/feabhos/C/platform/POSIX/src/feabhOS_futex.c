@@ -0,0 +1,105 @@
+// feabhOS_futex.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "feabhOS_futex.h"
+#include "feabhOS_time_utils.h"
+
+// ----------------------------------------------------------------------------
+// glibc does not provide a wrapper for the futex system call.
+// All feabhOS objects are private to the process so the
+// (faster) private futex operations are used.
+//
+static long sys_futex(feabhOS_futex_t * const word,
+                      int                     op,
+                      feabhOS_futex_t         val,
+                      const struct timespec * timeout,
+                      feabhOS_futex_t * const word2,
+                      feabhOS_futex_t         val3)
+{
+  return syscall(SYS_futex, word, op, val, timeout, word2, val3);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+struct timespec futex_deadline(duration_mSec_t timeout)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+
+  struct timespec offset = to_timespec(timeout);
+
+  return timespec_add(&now, &offset);
+}
+
+
+// ----------------------------------------------------------------------------
+// FUTEX_WAIT_BITSET takes an absolute timeout on CLOCK_MONOTONIC
+// (FUTEX_WAIT takes a relative one).
+// A raw system call is not a cancellation point, so a task
+// blocked here could never be destroyed.  Cancellation is made
+// asynchronous for the duration of the call only: no locks
+// are held while blocked, and enabling it acts on any
+// cancellation that is already pending.
+//
+bool futex_wait(feabhOS_futex_t * const word,
+                feabhOS_futex_t         expected,
+                const struct timespec * deadline)
+{
+  int cancel_type;
+  pthread_setcanceltype(PTHREAD_CANCEL_ASYNCHRONOUS, &cancel_type);
+
+  long result = sys_futex(word,
+                          FUTEX_WAIT_BITSET_PRIVATE,
+                          expected,
+                          deadline,
+                          NULL,
+                          FUTEX_BITSET_MATCH_ANY);
+  int  error  = errno;
+
+  pthread_setcanceltype(cancel_type, NULL);
+
+  return !((result == -1) && (error == ETIMEDOUT));
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void futex_cancel_waiting(void * waiting_tasks)
+{
+  __atomic_sub_fetch((feabhOS_futex_t *)waiting_tasks, 1, __ATOMIC_SEQ_CST);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void futex_wake(feabhOS_futex_t * const word, int count)
+{
+  sys_futex(word, FUTEX_WAKE_PRIVATE, (feabhOS_futex_t)count, NULL, NULL, 0);
+}
+
+
+// ----------------------------------------------------------------------------
+// For FUTEX_CMP_REQUEUE the timeout argument carries the maximum
+// number of tasks to requeue.
+//
+bool futex_requeue(feabhOS_futex_t * const word,
+                   feabhOS_futex_t         expected,
+                   feabhOS_futex_t * const target)
+{
+  long result = sys_futex(word,
+                          FUTEX_CMP_REQUEUE_PRIVATE,
+                          1,
+                          (const struct timespec *)(uintptr_t)INT_MAX,
+                          target,
+                          expected);
+
+  return !((result == -1) && (errno == EAGAIN));
+}
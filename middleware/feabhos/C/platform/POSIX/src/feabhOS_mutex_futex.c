@@ -0,0 +1,246 @@
+// feabhOS_mutex_futex.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "feabhOS_mutex.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_futex.h"
+
+// ----------------------------------------------------------------------------
+//  Futex mutex (see "Futexes Are Tricky", Ulrich Drepper).
+//  The futex word is
+//    0 - unlocked
+//    1 - locked, no waiting tasks
+//    2 - locked, tasks may be waiting
+//  Locking and unlocking an uncontended mutex is a single atomic
+//  operation; the kernel is only entered when a task must block
+//  or there may be tasks to wake.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_mutex
+{
+  OS_MUTEX_TYPE handle;
+  pthread_t     owner;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR MUTEX STRUCTURES
+//  -----------------------------------
+//
+//  For a fixed number of mutexes we use a fixed-block
+//  dynamic allocator.
+//  If MAX_MUTEXES == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_MUTEXES==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_MUTEX allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_mutex));
+}
+
+
+static void deallocate(feabhOS_MUTEX mutex)
+{
+  feabhOS_memory_free(mutex);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_mutex mutexes[MAX_MUTEXES];
+static feabhOS_POOL mutex_pool = NULL;
+
+
+static feabhOS_MUTEX allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(mutex_pool == NULL)
+  {
+    feabhOS_pool_create(&mutex_pool,
+                        mutexes,
+                        sizeof(mutexes),
+                        sizeof(struct feabhOS_mutex),
+                        MAX_MUTEXES);
+  }
+
+  return feabhOS_block_allocate(&mutex_pool);
+}
+
+
+static void deallocate(feabhOS_MUTEX mutex)
+{
+  feabhOS_block_free(&mutex_pool, mutex);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_create(feabhOS_MUTEX * const mutex_handle)
+{
+  feabhOS_MUTEX mutex = allocate();
+  if(mutex == NULL) return ERROR_OUT_OF_MEMORY;
+
+  mutex->handle = 0;
+  mutex->owner  = (pthread_t)0;
+
+  *mutex_handle = mutex;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+static inline void set_owner(feabhOS_MUTEX mutex)
+{
+  __atomic_store_n(&mutex->owner, pthread_self(), __ATOMIC_RELAXED);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_lock(feabhOS_MUTEX * const mutex_handle, duration_mSec_t timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(mutex_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_MUTEX mutex = *mutex_handle;
+
+  // Uncontended: 0 -> 1 without entering the kernel
+  //
+  OS_MUTEX_TYPE state = 0;
+  if(__atomic_compare_exchange_n(&mutex->handle, &state, 1,
+                                 false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+  {
+    set_owner(mutex);
+    return ERROR_OK;
+  }
+
+  if(timeout == NO_WAIT) return ERROR_TIMED_OUT;
+
+  struct timespec deadline;
+  struct timespec *until = NULL;
+  if(timeout != WAIT_FOREVER)
+  {
+    deadline = futex_deadline(timeout);
+    until    = &deadline;
+  }
+
+  // Contended: mark the mutex as having waiters and
+  // block until the owner releases it.
+  //
+  if(state != 2)
+  {
+    state = __atomic_exchange_n(&mutex->handle, 2, __ATOMIC_ACQUIRE);
+  }
+
+  while(state != 0)
+  {
+    if(!futex_wait(&mutex->handle, 2, until)) return ERROR_TIMED_OUT;
+    state = __atomic_exchange_n(&mutex->handle, 2, __ATOMIC_ACQUIRE);
+  }
+
+  set_owner(mutex);
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_unlock(feabhOS_MUTEX * const mutex_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(mutex_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_MUTEX mutex = *mutex_handle;
+
+  if(__atomic_load_n(&mutex->handle, __ATOMIC_RELAXED) == 0)                        return ERROR_NOT_OWNER;
+  if(!pthread_equal(__atomic_load_n(&mutex->owner, __ATOMIC_RELAXED), pthread_self())) return ERROR_NOT_OWNER;
+
+  __atomic_store_n(&mutex->owner, (pthread_t)0, __ATOMIC_RELAXED);
+
+  // Only enter the kernel if there may be waiting tasks
+  //
+  if(__atomic_fetch_sub(&mutex->handle, 1, __ATOMIC_RELEASE) != 1)
+  {
+    __atomic_store_n(&mutex->handle, 0, __ATOMIC_RELEASE);
+    futex_wake(&mutex->handle, 1);
+  }
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_destroy(feabhOS_MUTEX * const mutex_handle)
+{
+  // Parameter checking:
+  //
+  if(mutex_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_MUTEX mutex = *mutex_handle;
+  deallocate(mutex);
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+// Return the futex word of the mutex.
+// This function is not part of the public API,
+// and specific to the POSIX implementation.
+//
+OS_MUTEX_TYPE* feabhOS_mutex_native_handle(feabhOS_MUTEX * const mutex_handle)
+{
+  feabhOS_MUTEX mutex = *mutex_handle;
+  return &mutex->handle;
+}
+
+
+// ----------------------------------------------------------------------------
+// Re-acquire the mutex after waiting on a condition.
+// The task may have been moved from the condition to the
+// mutex futex by notify_all() so must always leave the
+// mutex marked as having waiters, to ensure the next unlock
+// wakes any other moved tasks.
+// This function is not part of the public API,
+// and specific to the POSIX implementation.
+//
+void feabhOS_mutex_relock(feabhOS_MUTEX * const mutex_handle)
+{
+  feabhOS_MUTEX mutex = *mutex_handle;
+
+  while(__atomic_exchange_n(&mutex->handle, 2, __ATOMIC_ACQUIRE) != 0)
+  {
+    futex_wait(&mutex->handle, 2, NULL);
+  }
+
+  set_owner(mutex);
+}
@@ -0,0 +1,181 @@
+// feabhOS_mutex_sim.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "feabhOS_mutex.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_sim.h"
+
+// ----------------------------------------------------------------------------
+//  Simulation mutex (see feabhOS_sim.h).
+//  Unlocking a mutex with waiting tasks hands ownership directly
+//  to the highest priority waiting task.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_mutex
+{
+  sim_task*  owner;
+  sim_queue  waiting_tasks;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR MUTEX STRUCTURES
+//  -----------------------------------
+//
+//  For a fixed number of mutexes we use a fixed-block
+//  dynamic allocator.
+//  If MAX_MUTEXES == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_MUTEXES==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_MUTEX allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_mutex));
+}
+
+
+static void deallocate(feabhOS_MUTEX mutex)
+{
+  feabhOS_memory_free(mutex);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_mutex mutexes[MAX_MUTEXES];
+static feabhOS_POOL mutex_pool = NULL;
+
+
+static feabhOS_MUTEX allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(mutex_pool == NULL)
+  {
+    feabhOS_pool_create(&mutex_pool,
+                        mutexes,
+                        sizeof(mutexes),
+                        sizeof(struct feabhOS_mutex),
+                        MAX_MUTEXES);
+  }
+
+  return feabhOS_block_allocate(&mutex_pool);
+}
+
+
+static void deallocate(feabhOS_MUTEX mutex)
+{
+  feabhOS_block_free(&mutex_pool, mutex);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_create(feabhOS_MUTEX * const mutex_handle)
+{
+  feabhOS_MUTEX mutex = allocate();
+  if(mutex == NULL) return ERROR_OUT_OF_MEMORY;
+
+  mutex->owner              = NULL;
+  mutex->waiting_tasks.head = NULL;
+
+  *mutex_handle = mutex;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_lock(feabhOS_MUTEX * const mutex_handle, duration_mSec_t timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(mutex_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_MUTEX mutex = *mutex_handle;
+
+  if(mutex->owner == NULL)
+  {
+    mutex->owner = sim_self();
+    return ERROR_OK;
+  }
+
+  if(timeout == NO_WAIT) return ERROR_TIMED_OUT;
+
+  // Ownership is handed over by feabhOS_mutex_unlock()
+  //
+  if(!sim_block(&mutex->waiting_tasks, timeout)) return ERROR_TIMED_OUT;
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+// Release the mutex without rescheduling.
+// This function is not part of the public API,
+// and specific to the simulation implementation.
+//
+feabhOS_error feabhOS_mutex_release(feabhOS_MUTEX * const mutex_handle)
+{
+  if(mutex_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_MUTEX mutex = *mutex_handle;
+
+  if(mutex->owner != sim_self()) return ERROR_NOT_OWNER;
+
+  mutex->owner = sim_wake_one(&mutex->waiting_tasks);
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_unlock(feabhOS_MUTEX * const mutex_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+
+  feabhOS_error error = feabhOS_mutex_release(mutex_handle);
+  if(error != ERROR_OK) return error;
+
+  sim_preempt();
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_mutex_destroy(feabhOS_MUTEX * const mutex_handle)
+{
+  // Parameter checking:
+  //
+  if(mutex_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_MUTEX mutex = *mutex_handle;
+  deallocate(mutex);
+
+  return ERROR_OK;
+}
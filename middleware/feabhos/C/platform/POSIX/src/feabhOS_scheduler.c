@@ -6,6 +6,15 @@
 #include "feabhOS_scheduler.h"
 #include "feabhOS_memory.h"
 
+#if defined(FEABHOS_SIMULATION)
+#include "feabhOS_sim.h"
+#endif
+
+#if defined(FEABHOS_REALTIME)
+#include <stdio.h>
+#include <sys/mman.h>
+#endif
+
 
 // This global variable can be queried by
 // other modules to know if the underlying
@@ -25,6 +34,23 @@ bool scheduler_started = true;
 feabhOS_error feabhOS_scheduler_init(void)
 {
   feabhOS_memory_init();
+
+#if defined(FEABHOS_SIMULATION)
+  // The calling thread becomes the first simulated task
+  //
+  sim_init();
+#endif
+
+#if defined(FEABHOS_REALTIME)
+  // Lock all current and future pages (including task
+  // stacks) so tasks never take a page fault.
+  //
+  if(mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    perror("feabhOS: mlockall failed, memory not locked");
+  }
+#endif
+
   return ERROR_OK;
 }
 
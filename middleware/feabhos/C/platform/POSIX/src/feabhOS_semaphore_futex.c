@@ -0,0 +1,219 @@
+// feabhOS_semaphore_futex.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "feabhOS_semaphore.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_futex.h"
+
+// ----------------------------------------------------------------------------
+//  Futex counting semaphore.
+//  The futex word is the semaphore count.  take() and give()
+//  update the count atomically; the kernel is only entered
+//  to block when the count is zero, or by give() when more
+//  tasks are waiting than the count already satisfies.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_semaphore
+{
+  OS_COUNTING_SEMAPHORE_TYPE handle;
+  OS_COUNTING_SEMAPHORE_TYPE waiting_tasks;
+  num_elements_t             max;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR SEMAPHORE STRUCTURES
+//  ---------------------------------------
+//
+//  For a fixed number of semaphores we use a fixed-block
+//  dynamic allocator.
+//  If MAX_SEMAPHORES == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_SEMAPHORES==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_SEMAPHORE allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_semaphore));
+}
+
+
+static void deallocate(feabhOS_SEMAPHORE semaphore)
+{
+  feabhOS_memory_free(semaphore);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_semaphore semaphores[MAX_SEMAPHORES];
+static feabhOS_POOL semaphore_pool = NULL;
+
+
+static feabhOS_SEMAPHORE allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(semaphore_pool == NULL)
+  {
+    feabhOS_pool_create(&semaphore_pool,
+                        semaphores,
+                        sizeof(semaphores),
+                        sizeof(struct feabhOS_semaphore),
+                        MAX_SEMAPHORES);
+  }
+
+  return feabhOS_block_allocate(&semaphore_pool);
+}
+
+
+static void deallocate(feabhOS_SEMAPHORE semaphore)
+{
+  feabhOS_block_free(&semaphore_pool, semaphore);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_create(feabhOS_SEMAPHORE * const semaphore_handle,
+                                       num_elements_t            max_count,
+                                       num_elements_t            init_count)
+{
+  feabhOS_SEMAPHORE semaphore = allocate();
+  if(semaphore == NULL) return ERROR_OUT_OF_MEMORY;
+
+  semaphore->handle        = init_count;
+  semaphore->waiting_tasks = 0;
+  semaphore->max           = max_count;
+
+  *semaphore_handle = semaphore;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+// Decrement the count if it is non-zero
+//
+static bool try_take(feabhOS_SEMAPHORE semaphore)
+{
+  OS_COUNTING_SEMAPHORE_TYPE count = __atomic_load_n(&semaphore->handle, __ATOMIC_SEQ_CST);
+
+  while(count > 0)
+  {
+    if(__atomic_compare_exchange_n(&semaphore->handle, &count, count - 1,
+                                   false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_take(feabhOS_SEMAPHORE * const semaphore_handle,
+                                     duration_mSec_t           timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(semaphore_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SEMAPHORE semaphore = *semaphore_handle;
+
+  if(try_take(semaphore))  return ERROR_OK;
+  if(timeout == NO_WAIT)   return ERROR_TIMED_OUT;
+
+  struct timespec deadline;
+  struct timespec *until = NULL;
+  if(timeout != WAIT_FOREVER)
+  {
+    deadline = futex_deadline(timeout);
+    until    = &deadline;
+  }
+
+  feabhOS_error error = ERROR_OK;
+
+  __atomic_add_fetch(&semaphore->waiting_tasks, 1, __ATOMIC_SEQ_CST);
+  pthread_cleanup_push(futex_cancel_waiting, &semaphore->waiting_tasks);
+
+  while(!try_take(semaphore))
+  {
+    if(!futex_wait(&semaphore->handle, 0, until))
+    {
+      if(!try_take(semaphore)) error = ERROR_TIMED_OUT;
+      break;
+    }
+  }
+
+  pthread_cleanup_pop(1);
+  return error;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_give(feabhOS_SEMAPHORE * const semaphore_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(semaphore_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SEMAPHORE semaphore = *semaphore_handle;
+
+  OS_COUNTING_SEMAPHORE_TYPE count = __atomic_load_n(&semaphore->handle, __ATOMIC_SEQ_CST);
+  do
+  {
+    if(count >= semaphore->max) return ERROR_MAX_COUNT;
+  }
+  while(!__atomic_compare_exchange_n(&semaphore->handle, &count, count + 1,
+                                     false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+  // 'count' is the value before this give.  A task can only
+  // be blocked if there are more waiting tasks than that.
+  //
+  if(__atomic_load_n(&semaphore->waiting_tasks, __ATOMIC_SEQ_CST) > count)
+  {
+    futex_wake(&semaphore->handle, 1);
+  }
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_destroy(feabhOS_SEMAPHORE * const semaphore_handle)
+{
+  // Parameter checking:
+  //
+  if(semaphore_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SEMAPHORE semaphore = *semaphore_handle;
+  deallocate(semaphore);
+
+  return ERROR_OK;
+}
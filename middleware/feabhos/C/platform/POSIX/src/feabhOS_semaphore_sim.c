@@ -0,0 +1,174 @@
+// feabhOS_semaphore_sim.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "feabhOS_semaphore.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_sim.h"
+
+// ----------------------------------------------------------------------------
+//  Simulation counting semaphore (see feabhOS_sim.h).
+//  Giving a semaphore with waiting tasks hands the count directly
+//  to the highest priority waiting task.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_semaphore
+{
+  num_elements_t count;
+  num_elements_t max;
+  sim_queue      waiting_tasks;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR SEMAPHORE STRUCTURES
+//  ---------------------------------------
+//
+//  For a fixed number of semaphores we use a fixed-block
+//  dynamic allocator.
+//  If MAX_SEMAPHORES == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_SEMAPHORES==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_SEMAPHORE allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_semaphore));
+}
+
+
+static void deallocate(feabhOS_SEMAPHORE semaphore)
+{
+  feabhOS_memory_free(semaphore);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_semaphore semaphores[MAX_SEMAPHORES];
+static feabhOS_POOL semaphore_pool = NULL;
+
+
+static feabhOS_SEMAPHORE allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(semaphore_pool == NULL)
+  {
+    feabhOS_pool_create(&semaphore_pool,
+                        semaphores,
+                        sizeof(semaphores),
+                        sizeof(struct feabhOS_semaphore),
+                        MAX_SEMAPHORES);
+  }
+
+  return feabhOS_block_allocate(&semaphore_pool);
+}
+
+
+static void deallocate(feabhOS_SEMAPHORE semaphore)
+{
+  feabhOS_block_free(&semaphore_pool, semaphore);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_create(feabhOS_SEMAPHORE * const semaphore_handle,
+                                       num_elements_t            max_count,
+                                       num_elements_t            init_count)
+{
+  feabhOS_SEMAPHORE semaphore = allocate();
+  if(semaphore == NULL) return ERROR_OUT_OF_MEMORY;
+
+  semaphore->count              = init_count;
+  semaphore->max                = max_count;
+  semaphore->waiting_tasks.head = NULL;
+
+  *semaphore_handle = semaphore;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_take(feabhOS_SEMAPHORE * const semaphore_handle,
+                                     duration_mSec_t           timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(semaphore_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SEMAPHORE semaphore = *semaphore_handle;
+
+  if(semaphore->count > 0)
+  {
+    --semaphore->count;
+    return ERROR_OK;
+  }
+
+  if(timeout == NO_WAIT) return ERROR_TIMED_OUT;
+
+  if(!sim_block(&semaphore->waiting_tasks, timeout)) return ERROR_TIMED_OUT;
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_give(feabhOS_SEMAPHORE * const semaphore_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(semaphore_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SEMAPHORE semaphore = *semaphore_handle;
+
+  if(sim_wake_one(&semaphore->waiting_tasks) != NULL)
+  {
+    sim_preempt();
+    return ERROR_OK;
+  }
+
+  if(semaphore->count >= semaphore->max) return ERROR_MAX_COUNT;
+
+  ++semaphore->count;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_semaphore_destroy(feabhOS_SEMAPHORE * const semaphore_handle)
+{
+  // Parameter checking:
+  //
+  if(semaphore_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SEMAPHORE semaphore = *semaphore_handle;
+  deallocate(semaphore);
+
+  return ERROR_OK;
+}
@@ -6,6 +6,8 @@
 #include <stdbool.h>
 #include <errno.h>
 #include <semaphore.h>
+#include <pthread.h>
+#include <sched.h>
 #include "feabhOS_signal.h"
 #include "feabhOS_port_defs.h"
 #include "feabhOS_time_utils.h"
@@ -34,6 +36,7 @@ struct feabhOS_signal
 {
   OS_BINARY_SEMAPHORE_TYPE handle;
   num_elements_t           waiting_tasks;
+  num_elements_t           released_tasks;
 
 };
 
@@ -113,6 +116,66 @@ static void deallocate(feabhOS_SIGNAL signal)
 
 #endif
 
+// ----------------------------------------------------------------------------
+// Every task in feabhOS_signal_wait() is counted either as
+// waiting, or as released by a notifier (which then 'gives'
+// the semaphore for it).  The counts are shared between
+// waiting and notifying tasks so must be updated atomically.
+// Returns true if the count was non-zero.
+//
+static bool decrement(num_elements_t * const count)
+{
+  num_elements_t value = __atomic_load_n(count, __ATOMIC_SEQ_CST);
+
+  while(value > 0)
+  {
+    if(__atomic_compare_exchange_n(count, &value, value - 1,
+                                   false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// ----------------------------------------------------------------------------
+// Move one task from waiting to released.
+// Returns true if there was a waiting task to release.
+//
+static bool release_waiter(feabhOS_SIGNAL signal)
+{
+  if(!decrement(&signal->waiting_tasks)) return false;
+
+  __atomic_add_fetch(&signal->released_tasks, 1, __ATOMIC_SEQ_CST);
+  return true;
+}
+
+
+// ----------------------------------------------------------------------------
+// Remove the caller from the counts once it has taken a
+// 'give'.  That give may have been made for this task, for
+// another waiting task (which is then still counted as
+// waiting) or by notify_one() with no task waiting; either
+// way one fewer task is in feabhOS_signal_wait().
+// Both counts are only zero while a notifier is between
+// its two updates in release_waiter().
+//
+static void leave(feabhOS_SIGNAL signal)
+{
+  while(!decrement(&signal->released_tasks) &&
+        !decrement(&signal->waiting_tasks))
+  {
+    sched_yield();
+  }
+}
+
+
+static void leave_cancelled(void * signal)
+{
+  leave((feabhOS_SIGNAL)signal);
+}
+
 // ----------------------------------------------------------------------------
 //
 feabhOS_error feabhOS_signal_create(feabhOS_SIGNAL * const signal_handle)
@@ -132,7 +195,8 @@ feabhOS_error feabhOS_signal_create(feabhOS_SIGNAL * const signal_handle)
   //
   sem_wait(&signal->handle);
 
-  signal->waiting_tasks = 0;
+  signal->waiting_tasks  = 0;
+  signal->released_tasks = 0;
 
   *signal_handle = signal;
   return ERROR_OK;
@@ -150,13 +214,13 @@ feabhOS_error feabhOS_signal_notify_one(feabhOS_SIGNAL * const signal_handle)
 
   feabhOS_SIGNAL signal = *signal_handle;
 
-  // 'Give' the semaphore, releasing one waiting tasks
+  // 'Give' the semaphore, releasing one waiting task; or
+  // leaving the semaphore given if no task is waiting.
+  // The task is counted as released before the give, so
+  // the task that takes it is never still counted as waiting.
   //
+  release_waiter(signal);
   sem_post(&signal->handle);
-  if(signal->waiting_tasks > 0)
-  {
-    signal->waiting_tasks--;
-  }
 
   return ERROR_OK;
 }
@@ -174,10 +238,9 @@ feabhOS_error feabhOS_signal_notify_all(feabhOS_SIGNAL * const signal_handle)
 
   // 'Give' the semaphore, releasing all waiting tasks
   //
-  while(signal->waiting_tasks > 0)
+  while(release_waiter(signal))
   {
     sem_post(&signal->handle);
-    signal->waiting_tasks--;
   }
 
   return ERROR_OK;
@@ -199,6 +262,12 @@ feabhOS_error feabhOS_signal_wait(feabhOS_SIGNAL * const signal_handle,
   OS_ERROR_TYPE OS_error;
   feabhOS_error error;
 
+  // Record the waiting task so notify_all() can release it.
+  // A task destroyed while blocked is removed from the count.
+  //
+  __atomic_add_fetch(&signal->waiting_tasks, 1, __ATOMIC_SEQ_CST);
+  pthread_cleanup_push(leave_cancelled, signal);
+
   // POSIX semphores don't support infinite timeouts, but
   // there are try-, blocking and timed-blocking calls
   //
@@ -242,6 +311,19 @@ feabhOS_error feabhOS_signal_wait(feabhOS_SIGNAL * const signal_handle,
    }
   }
 
+  // If a notifier has already counted this task as
+  // released its 'give' is on the way, so take it.
+  //
+  if((error != ERROR_OK) && !decrement(&signal->waiting_tasks))
+  {
+    sem_wait(&signal->handle);
+    error = ERROR_OK;
+  }
+
+  pthread_cleanup_pop(0);
+
+  if(error == ERROR_OK) leave(signal);
+
   return error;
 }
 
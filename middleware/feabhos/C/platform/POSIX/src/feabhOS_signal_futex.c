@@ -0,0 +1,270 @@
+// feabhOS_signal_futex.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <limits.h>
+
+#include "feabhOS_signal.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_futex.h"
+
+// ----------------------------------------------------------------------------
+//  Futex signal.
+//  The futex word counts the releases given to waiting tasks.
+//  notify_one() gives one release, which persists if no task
+//  is waiting (as a binary semaphore); notify_all() gives one
+//  release to every waiting task.  A waiting task takes a
+//  release with an atomic decrement so the kernel is only
+//  entered to block, or to wake a task when a notify gives
+//  a release that no waiting task already has.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_signal
+{
+  OS_SIGNAL_TYPE handle;
+  OS_SIGNAL_TYPE waiting_tasks;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR SIGNAL STRUCTURES
+//  ------------------------------------
+//
+//  For a fixed number of signals we use a fixed-block
+//  dynamic allocator.
+//  If MAX_SIGNALS == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_SIGNALS==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_SIGNAL allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_signal));
+}
+
+
+static void deallocate(feabhOS_SIGNAL signal)
+{
+  feabhOS_memory_free(signal);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_signal signals[MAX_SIGNALS];
+static feabhOS_POOL signal_pool = NULL;
+
+
+static feabhOS_SIGNAL allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(signal_pool == NULL)
+  {
+    feabhOS_pool_create(&signal_pool,
+                        signals,
+                        sizeof(signals),
+                        sizeof(struct feabhOS_signal),
+                        MAX_SIGNALS);
+  }
+
+  return feabhOS_block_allocate(&signal_pool);
+}
+
+
+static void deallocate(feabhOS_SIGNAL signal)
+{
+  feabhOS_block_free(&signal_pool, signal);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_create(feabhOS_SIGNAL * const signal_handle)
+{
+  feabhOS_SIGNAL signal = allocate();
+  if(signal == NULL) return ERROR_OUT_OF_MEMORY;
+
+  signal->handle        = 0;
+  signal->waiting_tasks = 0;
+
+  *signal_handle = signal;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+// Take a release if one is available
+//
+static bool try_take(feabhOS_SIGNAL signal)
+{
+  OS_SIGNAL_TYPE releases = __atomic_load_n(&signal->handle, __ATOMIC_SEQ_CST);
+
+  while(releases > 0)
+  {
+    if(__atomic_compare_exchange_n(&signal->handle, &releases, releases - 1,
+                                   false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// ----------------------------------------------------------------------------
+// Raise the number of releases to at least 'count'.
+// Returns false if there were already enough releases
+//
+static bool give(feabhOS_SIGNAL signal, OS_SIGNAL_TYPE count)
+{
+  OS_SIGNAL_TYPE releases = __atomic_load_n(&signal->handle, __ATOMIC_SEQ_CST);
+
+  while(releases < count)
+  {
+    if(__atomic_compare_exchange_n(&signal->handle, &releases, count,
+                                   false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_notify_one(feabhOS_SIGNAL * const signal_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+
+  // Release one more waiting task than has already been
+  // released; or leave a single release pending if no
+  // task is waiting.  The increment is made against the
+  // release count it was calculated from, so concurrent
+  // notifies each add a release.  If every waiting task
+  // already has a release, nothing changes and no task
+  // needs to be woken.
+  //
+  OS_SIGNAL_TYPE releases = __atomic_load_n(&signal->handle, __ATOMIC_SEQ_CST);
+  OS_SIGNAL_TYPE waiting;
+
+  do
+  {
+    waiting = __atomic_load_n(&signal->waiting_tasks, __ATOMIC_SEQ_CST);
+    if(releases >= ((waiting > 0) ? waiting : 1)) return ERROR_OK;
+  }
+  while(!__atomic_compare_exchange_n(&signal->handle, &releases, releases + 1,
+                                     false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+  if(waiting > 0)
+  {
+    futex_wake(&signal->handle, 1);
+  }
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_notify_all(feabhOS_SIGNAL * const signal_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+
+  OS_SIGNAL_TYPE waiting = __atomic_load_n(&signal->waiting_tasks, __ATOMIC_SEQ_CST);
+  if(waiting == 0) return ERROR_OK;
+
+  if(give(signal, waiting))
+  {
+    futex_wake(&signal->handle, INT_MAX);
+  }
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_wait(feabhOS_SIGNAL * const signal_handle,
+                                  duration_mSec_t        timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+
+  if(try_take(signal))   return ERROR_OK;
+  if(timeout == NO_WAIT) return ERROR_TIMED_OUT;
+
+  struct timespec deadline;
+  struct timespec *until = NULL;
+  if(timeout != WAIT_FOREVER)
+  {
+    deadline = futex_deadline(timeout);
+    until    = &deadline;
+  }
+
+  feabhOS_error error = ERROR_OK;
+
+  __atomic_add_fetch(&signal->waiting_tasks, 1, __ATOMIC_SEQ_CST);
+  pthread_cleanup_push(futex_cancel_waiting, &signal->waiting_tasks);
+
+  while(!try_take(signal))
+  {
+    if(!futex_wait(&signal->handle, 0, until))
+    {
+      if(!try_take(signal)) error = ERROR_TIMED_OUT;
+      break;
+    }
+  }
+
+  pthread_cleanup_pop(1);
+  return error;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_destroy(feabhOS_SIGNAL * const signal_handle)
+{
+  // Parameter checking:
+  //
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+  deallocate(signal);
+
+  return ERROR_OK;
+}
@@ -0,0 +1,188 @@
+// feabhOS_signal_sim.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include "feabhOS_signal.h"
+#include "feabhOS_port_defs.h"
+#include "feabhOS_sim.h"
+
+// ----------------------------------------------------------------------------
+//  Simulation signal (see feabhOS_sim.h).
+//  notify_one() releases the highest priority waiting task; if
+//  no task is waiting the notification is held (as a binary
+//  semaphore) for the next call to wait().  notify_all() releases
+//  every waiting task.
+//
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Management structure
+//
+struct feabhOS_signal
+{
+  bool      pending;
+  sim_queue waiting_tasks;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR SIGNAL STRUCTURES
+//  ------------------------------------
+//
+//  For a fixed number of signals we use a fixed-block
+//  dynamic allocator.
+//  If MAX_SIGNALS == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_SIGNALS==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_SIGNAL allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_signal));
+}
+
+
+static void deallocate(feabhOS_SIGNAL signal)
+{
+  feabhOS_memory_free(signal);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_signal signals[MAX_SIGNALS];
+static feabhOS_POOL signal_pool = NULL;
+
+
+static feabhOS_SIGNAL allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(signal_pool == NULL)
+  {
+    feabhOS_pool_create(&signal_pool,
+                        signals,
+                        sizeof(signals),
+                        sizeof(struct feabhOS_signal),
+                        MAX_SIGNALS);
+  }
+
+  return feabhOS_block_allocate(&signal_pool);
+}
+
+
+static void deallocate(feabhOS_SIGNAL signal)
+{
+  feabhOS_block_free(&signal_pool, signal);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_create(feabhOS_SIGNAL * const signal_handle)
+{
+  feabhOS_SIGNAL signal = allocate();
+  if(signal == NULL) return ERROR_OUT_OF_MEMORY;
+
+  signal->pending            = false;
+  signal->waiting_tasks.head = NULL;
+
+  *signal_handle = signal;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_notify_one(feabhOS_SIGNAL * const signal_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+
+  if(sim_wake_one(&signal->waiting_tasks) == NULL)
+  {
+    signal->pending = true;
+    return ERROR_OK;
+  }
+
+  sim_preempt();
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_notify_all(feabhOS_SIGNAL * const signal_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+
+  sim_wake_all(&signal->waiting_tasks);
+  sim_preempt();
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_wait(feabhOS_SIGNAL * const signal_handle,
+                                  duration_mSec_t        timeout)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+
+  if(signal->pending)
+  {
+    signal->pending = false;
+    return ERROR_OK;
+  }
+
+  if(timeout == NO_WAIT) return ERROR_TIMED_OUT;
+
+  if(!sim_block(&signal->waiting_tasks, timeout)) return ERROR_TIMED_OUT;
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_signal_destroy(feabhOS_SIGNAL * const signal_handle)
+{
+  // Parameter checking:
+  //
+  if(signal_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_SIGNAL signal = *signal_handle;
+  deallocate(signal);
+
+  return ERROR_OK;
+}
@@ -0,0 +1,566 @@
+// feabhOS_sim.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "feabhOS_sim.h"
+#include "feabhOS_port_defs.h"
+
+// ----------------------------------------------------------------------------
+//  The kernel lock is held by whichever thread is inside the
+//  simulation kernel; every other thread is either the running
+//  task (executing task code) or parked on its 'run' condition.
+//  Kernel state is therefore only ever accessed with the lock
+//  held, and task code only ever runs on one thread at a time.
+// ----------------------------------------------------------------------------
+
+#define SIM_PRIORITIES (OS_PRIORITY_HIGHEST + 1)
+
+static struct
+{
+  pthread_mutex_t lock;
+  sim_task*       current;
+  sim_task*       ready_head[SIM_PRIORITIES];
+  sim_task*       ready_tail[SIM_PRIORITIES];
+  sim_task*       timers;
+  uint64_t        now;
+} kernel = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static sim_task main_task;
+static __thread sim_task* this_task = NULL;
+
+
+// ----------------------------------------------------------------------------
+// Ready lists; one FIFO per priority
+//
+static void ready_push_back(sim_task* const task)
+{
+  unsigned prio = task->priority;
+
+  task->state = SIM_READY;
+  task->next  = NULL;
+
+  if(kernel.ready_tail[prio] == NULL) kernel.ready_head[prio] = task;
+  else                                kernel.ready_tail[prio]->next = task;
+
+  kernel.ready_tail[prio] = task;
+}
+
+
+static void ready_push_front(sim_task* const task)
+{
+  unsigned prio = task->priority;
+
+  task->state = SIM_READY;
+  task->next  = kernel.ready_head[prio];
+
+  kernel.ready_head[prio] = task;
+  if(kernel.ready_tail[prio] == NULL) kernel.ready_tail[prio] = task;
+}
+
+
+static void ready_remove(sim_task* const task)
+{
+  unsigned  prio     = task->priority;
+  sim_task* previous = NULL;
+
+  for(sim_task* t = kernel.ready_head[prio]; t != NULL; previous = t, t = t->next)
+  {
+    if(t != task) continue;
+
+    if(previous == NULL) kernel.ready_head[prio] = t->next;
+    else                 previous->next = t->next;
+
+    if(kernel.ready_tail[prio] == t) kernel.ready_tail[prio] = previous;
+    break;
+  }
+}
+
+
+static int highest_ready(void)
+{
+  for(int prio = SIM_PRIORITIES - 1; prio >= 0; --prio)
+  {
+    if(kernel.ready_head[prio] != NULL) return prio;
+  }
+  return -1;
+}
+
+
+// ----------------------------------------------------------------------------
+// Wait queues; priority order, FIFO within a priority
+//
+static void queue_insert(sim_queue* const queue, sim_task* const task)
+{
+  sim_task** link = &queue->head;
+
+  while((*link != NULL) && ((*link)->priority >= task->priority))
+  {
+    link = &(*link)->next;
+  }
+
+  task->next  = *link;
+  task->queue = queue;
+  *link       = task;
+}
+
+
+static void queue_remove(sim_queue* const queue, sim_task* const task)
+{
+  for(sim_task** link = &queue->head; *link != NULL; link = &(*link)->next)
+  {
+    if(*link == task)
+    {
+      *link = task->next;
+      break;
+    }
+  }
+  task->queue = NULL;
+}
+
+
+// ----------------------------------------------------------------------------
+// Timers; ordered by wake time, FIFO for equal times
+//
+static void timer_start(sim_task* const task, duration_mSec_t period)
+{
+  task->wake_time    = kernel.now + period;
+  task->timer_active = true;
+
+  sim_task** link = &kernel.timers;
+  while((*link != NULL) && ((*link)->wake_time <= task->wake_time))
+  {
+    link = &(*link)->timer_next;
+  }
+
+  task->timer_next = *link;
+  *link            = task;
+}
+
+
+static void timer_cancel(sim_task* const task)
+{
+  if(!task->timer_active) return;
+
+  for(sim_task** link = &kernel.timers; *link != NULL; link = &(*link)->timer_next)
+  {
+    if(*link == task)
+    {
+      *link = task->timer_next;
+      break;
+    }
+  }
+  task->timer_active = false;
+}
+
+
+// ----------------------------------------------------------------------------
+// Advance virtual time to the next timeout and ready every task
+// whose timeout expires at that instant.
+//
+static void expire_timers(void)
+{
+  kernel.now = kernel.timers->wake_time;
+
+  while((kernel.timers != NULL) && (kernel.timers->wake_time == kernel.now))
+  {
+    sim_task* task = kernel.timers;
+    kernel.timers      = task->timer_next;
+    task->timer_active = false;
+
+    if(task->queue != NULL)
+    {
+      queue_remove(task->queue, task);
+      task->timed_out = true;
+    }
+    ready_push_back(task);
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// Hand the processor to the highest priority ready task.
+// The caller must already be on a ready list, a wait queue
+// or the timer list (or be finished).
+//
+static void schedule_next(void)
+{
+  for(;;)
+  {
+    int prio = highest_ready();
+
+    if(prio >= 0)
+    {
+      sim_task* next = kernel.ready_head[prio];
+      ready_remove(next);
+
+      kernel.current = next;
+      pthread_cond_signal(&next->run);
+      return;
+    }
+
+    if(kernel.timers == NULL)
+    {
+      fprintf(stderr, "feabhOS simulation: deadlock at %llu ms, no task can run\n",
+              (unsigned long long)kernel.now);
+      abort();
+    }
+
+    expire_timers();
+  }
+}
+
+
+// ----------------------------------------------------------------------------
+// Park the calling thread until its task is scheduled.
+// A task that is killed while parked exits here.
+//
+static void wait_for_processor(sim_task* const self)
+{
+  while((kernel.current != self) && !self->killed)
+  {
+    pthread_cond_wait(&self->run, &kernel.lock);
+  }
+
+  if(self->killed)
+  {
+    pthread_mutex_unlock(&kernel.lock);
+    pthread_exit(NULL);
+  }
+}
+
+
+static void switch_from(sim_task* const self)
+{
+  schedule_next();
+  wait_for_processor(self);
+}
+
+
+static void preempt(sim_task* const self)
+{
+  if(highest_ready() > (int)self->priority)
+  {
+    ready_push_front(self);
+    switch_from(self);
+  }
+}
+
+
+static bool block_on(sim_task* const self, sim_queue* const queue, duration_mSec_t timeout)
+{
+  self->state     = SIM_BLOCKED;
+  self->timed_out = false;
+  queue_insert(queue, self);
+
+  if(timeout != WAIT_FOREVER) timer_start(self, timeout);
+
+  switch_from(self);
+
+  return !self->timed_out;
+}
+
+
+static void wake(sim_task* const task)
+{
+  task->queue = NULL;
+  timer_cancel(task);
+  ready_push_back(task);
+}
+
+
+// ----------------------------------------------------------------------------
+// Kernel entry; returns the calling task, or NULL if the
+// caller has been killed and is unwinding.
+//
+static sim_task* enter(void)
+{
+  assert(this_task != NULL);
+
+  pthread_mutex_lock(&kernel.lock);
+  return this_task->killed ? NULL : this_task;
+}
+
+
+static void leave(void)
+{
+  pthread_mutex_unlock(&kernel.lock);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_init(void)
+{
+  if(this_task != NULL) return;
+
+  pthread_mutex_lock(&kernel.lock);
+
+  pthread_cond_init(&main_task.run, NULL);
+  main_task.priority = OS_PRIORITY_NORMAL;
+  main_task.state    = SIM_READY;
+
+  this_task      = &main_task;
+  kernel.current = &main_task;
+  kernel.now     = 0;
+
+  pthread_mutex_unlock(&kernel.lock);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+sim_task* sim_self(void)
+{
+  assert(this_task != NULL);
+  return this_task;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_task_add(sim_task* const task, unsigned priority)
+{
+  pthread_mutex_lock(&kernel.lock);
+
+  *task = (sim_task){ .priority = priority };
+  pthread_cond_init(&task->run, NULL);
+  ready_push_back(task);
+
+  pthread_mutex_unlock(&kernel.lock);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_task_start(sim_task* const task)
+{
+  pthread_mutex_lock(&kernel.lock);
+
+  this_task = task;
+  wait_for_processor(task);
+
+  pthread_mutex_unlock(&kernel.lock);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_task_exit(void)
+{
+  sim_task* self = enter();
+
+  if(self != NULL)
+  {
+    self->state = SIM_DONE;
+
+    while(self->joiners.head != NULL)
+    {
+      sim_task* joiner = self->joiners.head;
+      self->joiners.head = joiner->next;
+      wake(joiner);
+    }
+
+    schedule_next();
+  }
+
+  leave();
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_task_join(sim_task* const task)
+{
+  sim_task* self = enter();
+
+  if((self != NULL) && (task->state != SIM_DONE))
+  {
+    block_on(self, &task->joiners, WAIT_FOREVER);
+  }
+
+  leave();
+}
+
+
+// ----------------------------------------------------------------------------
+//
+bool sim_task_kill(sim_task* const task)
+{
+  pthread_mutex_lock(&kernel.lock);
+
+  bool running = (task->state != SIM_DONE);
+
+  if(running)
+  {
+    if(task->state == SIM_READY) ready_remove(task);
+    if(task->queue != NULL)      queue_remove(task->queue, task);
+    timer_cancel(task);
+
+    task->state  = SIM_DONE;
+    task->killed = true;
+
+    while(task->joiners.head != NULL)
+    {
+      sim_task* joiner = task->joiners.head;
+      task->joiners.head = joiner->next;
+      wake(joiner);
+    }
+
+    pthread_cond_signal(&task->run);
+  }
+
+  pthread_mutex_unlock(&kernel.lock);
+  return running;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_task_set_priority(sim_task* const task, unsigned priority)
+{
+  sim_task* self = enter();
+
+  if(task->state == SIM_READY)
+  {
+    ready_remove(task);
+    task->priority = priority;
+    ready_push_back(task);
+  }
+  else if(task->queue != NULL)
+  {
+    sim_queue* queue = task->queue;
+    queue_remove(queue, task);
+    task->priority = priority;
+    queue_insert(queue, task);
+  }
+  else
+  {
+    task->priority = priority;
+  }
+
+  if(self != NULL) preempt(self);
+
+  leave();
+}
+
+
+// ----------------------------------------------------------------------------
+//
+bool sim_block(sim_queue* const queue, duration_mSec_t timeout)
+{
+  sim_task* self  = enter();
+  bool      woken = false;
+
+  if(self != NULL)
+  {
+    woken = block_on(self, queue, timeout);
+  }
+
+  leave();
+  return woken;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+sim_task* sim_wake_one(sim_queue* const queue)
+{
+  pthread_mutex_lock(&kernel.lock);
+
+  sim_task* task = queue->head;
+  if(task != NULL)
+  {
+    queue->head = task->next;
+    wake(task);
+  }
+
+  pthread_mutex_unlock(&kernel.lock);
+  return task;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+unsigned sim_wake_all(sim_queue* const queue)
+{
+  pthread_mutex_lock(&kernel.lock);
+
+  unsigned count = 0;
+  while(queue->head != NULL)
+  {
+    sim_task* task = queue->head;
+    queue->head = task->next;
+    wake(task);
+    ++count;
+  }
+
+  pthread_mutex_unlock(&kernel.lock);
+  return count;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_preempt(void)
+{
+  sim_task* self = enter();
+
+  if(self != NULL) preempt(self);
+
+  leave();
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_yield(void)
+{
+  sim_task* self = enter();
+
+  if(self != NULL)
+  {
+    ready_push_back(self);
+    switch_from(self);
+  }
+
+  leave();
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void sim_sleep(duration_mSec_t period)
+{
+  if(period == 0)
+  {
+    sim_yield();
+    return;
+  }
+
+  sim_task* self = enter();
+
+  if(self != NULL)
+  {
+    self->state = SIM_SLEEPING;
+    timer_start(self, period);
+    switch_from(self);
+  }
+
+  leave();
+}
+
+
+// ----------------------------------------------------------------------------
+//
+uint64_t feabhOS_sim_time(void)
+{
+  pthread_mutex_lock(&kernel.lock);
+  uint64_t now = kernel.now;
+  pthread_mutex_unlock(&kernel.lock);
+
+  return now;
+}
@@ -2,6 +2,10 @@
 // See project README.md for disclaimer and additional information.
 // Feabhas Ltd
 
+#if defined(FEABHOS_REALTIME)
+#define _GNU_SOURCE               // For CPU affinity
+#endif
+
 #include <assert.h>
 #include <stdbool.h>
 #include <pthread.h>
@@ -13,6 +17,12 @@
 #include "feabhOS_mutex.h"
 #include "feabhOS_time_utils.h"
 
+#if defined(FEABHOS_REALTIME)
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#endif
+
 // ----------------------------------------------------------------------------
 // Making a blocking call before the scheduler is started
 // could lock up the entire system.  Therefore, any attempt
@@ -107,6 +117,83 @@ static void deallocate(feabhOS_TASK task)
 
 #endif
 
+// ----------------------------------------------------------------------------
+//
+//  REAL-TIME SCHEDULING
+//  --------------------
+//
+//  See feabhOS_port_defs.h.  The policy, priority and CPU affinity
+//  are set in the attributes passed to pthread_create(), so a task
+//  runs with them from its first instruction.  If the process may
+//  not use SCHED_FIFO (pthread_create fails with EPERM), or the
+//  affinity names no available CPU (EINVAL), a warning is printed
+//  and all later tasks are created without that attribute.
+//
+
+#if defined(FEABHOS_REALTIME)
+
+static bool realtime_permitted = true;
+static bool affinity_permitted = (OS_TASK_CPU_AFFINITY != 0);
+
+
+static int realtime_priority(feabhOS_priority_t priority)
+{
+  int level = OS_REALTIME_PRIORITY_BASE +
+              (((int)priority - OS_PRIORITY_LOWEST) * OS_REALTIME_PRIORITY_STEP);
+  int max   = sched_get_priority_max(SCHED_FIFO);
+
+  return (level > max) ? max : level;
+}
+
+
+static void set_realtime_attributes(pthread_attr_t * const attributes,
+                                    feabhOS_priority_t     priority)
+{
+  struct sched_param param = { .sched_priority = realtime_priority(priority) };
+
+  pthread_attr_setinheritsched(attributes, PTHREAD_EXPLICIT_SCHED);
+  pthread_attr_setschedpolicy(attributes, SCHED_FIFO);
+  pthread_attr_setschedparam(attributes, &param);
+}
+
+
+static void set_affinity_attributes(pthread_attr_t * const attributes)
+{
+  cpu_set_t cpus;
+  CPU_ZERO(&cpus);
+
+  for(unsigned cpu = 0; cpu < 64; ++cpu)
+  {
+    if((((unsigned long long)OS_TASK_CPU_AFFINITY) >> cpu) & 1u) CPU_SET(cpu, &cpus);
+  }
+
+  pthread_attr_setaffinity_np(attributes, sizeof(cpus), &cpus);
+}
+
+
+// Returns true for the first caller only, which prints the warning
+//
+static bool fall_back(bool * const permitted)
+{
+  return __atomic_exchange_n(permitted, false, __ATOMIC_RELAXED);
+}
+
+
+// pthread_setschedparam() errors
+//
+static feabhOS_error scheduling_error(int OS_error)
+{
+  switch(OS_error)
+  {
+    case 0:      return ERROR_OK;
+    case ESRCH:  return ERROR_STUPID;     // The task has terminated
+    case EINVAL: return ERROR_PARAM1;     // Not a valid SCHED_FIFO priority
+    default:     return ERROR_UNKNOWN;    // EPERM: not privileged
+  }
+}
+
+#endif
+
 // ----------------------------------------------------------------------------
 //
 feabhOS_error feabhOS_task_create(feabhOS_TASK * const  task_handle,
@@ -136,14 +223,59 @@ feabhOS_error feabhOS_task_create(feabhOS_TASK * const  task_handle,
   task->user_code.parameter = param;
   task->is_joinable         = true;
 
-  pthread_attr_t task_attributes;
-  pthread_attr_init(&task_attributes);
-  pthread_attr_setstacksize(&task_attributes, stack);
+  size_t stack_size = stack;
 
-  OS_error = pthread_create(&task->handle,
-                            &task_attributes,
-                            scheduled_function,
-                            (void*)task);
+#if defined(FEABHOS_REALTIME)
+  if(stack_size < OS_REALTIME_STACK_MIN) stack_size = OS_REALTIME_STACK_MIN;
+#endif
+
+  for(;;)
+  {
+    pthread_attr_t task_attributes;
+    pthread_attr_init(&task_attributes);
+    pthread_attr_setstacksize(&task_attributes, stack_size);
+
+#if defined(FEABHOS_REALTIME)
+    bool realtime = __atomic_load_n(&realtime_permitted, __ATOMIC_RELAXED);
+    bool pinned   = __atomic_load_n(&affinity_permitted, __ATOMIC_RELAXED);
+
+    if(realtime) set_realtime_attributes(&task_attributes, priority);
+    if(pinned)   set_affinity_attributes(&task_attributes);
+#endif
+
+    OS_error = pthread_create(&task->handle,
+                              &task_attributes,
+                              scheduled_function,
+                              (void*)task);
+
+    pthread_attr_destroy(&task_attributes);
+
+#if defined(FEABHOS_REALTIME)
+    // Retry without SCHED_FIFO if not privileged, or
+    // without the affinity if its CPUs are not available
+    //
+    if(realtime && (OS_error == EPERM))
+    {
+      if(fall_back(&realtime_permitted))
+      {
+        fprintf(stderr, "feabhOS: SCHED_FIFO not permitted, tasks use the default policy\n");
+      }
+      continue;
+    }
+
+    if(pinned && (OS_error == EINVAL))
+    {
+      if(fall_back(&affinity_permitted))
+      {
+        fprintf(stderr, "feabhOS: CPU affinity 0x%llx not available, tasks not pinned\n",
+                (unsigned long long)OS_TASK_CPU_AFFINITY);
+      }
+      continue;
+    }
+#endif
+
+    break;
+  }
 
   // The OS will fail if it cannot allocate memory
   // for (its own) control structures.
@@ -225,7 +357,18 @@ feabhOS_error feabhOS_task_setPriority(feabhOS_TASK * const task_handle,
 
   feabhOS_TASK task = *task_handle;
 
-  pthread_setschedprio(task->handle, prio);
+#if defined(FEABHOS_REALTIME)
+  if(__atomic_load_n(&realtime_permitted, __ATOMIC_RELAXED))
+  {
+    struct sched_param param = { .sched_priority = realtime_priority(prio) };
+    return scheduling_error(pthread_setschedparam(task->handle, SCHED_FIFO, &param));
+  }
+#endif
+
+  // Otherwise tasks use the default (SCHED_OTHER) policy, which
+  // has no priorities: the call fails and priority has no effect.
+  //
+  (void)pthread_setschedprio(task->handle, prio);
   return ERROR_OK;
 }
 
@@ -252,8 +395,29 @@ feabhOS_error feabhOS_task_destroy(feabhOS_TASK * const task_handle)
   if((*task_handle)->handle == (OS_TASK_TYPE)NULL) return ERROR_STUPID;
 
   feabhOS_TASK task = *task_handle;
+  *task_handle = NULL;
+
+  // A task destroying itself never returns.
+  //
+  if(pthread_equal(task->handle, pthread_self()))
+  {
+    deallocate(task);
+    terminate_task(&task);
+  }
+
+  // Another task is cancelled and its resources reclaimed,
+  // unless it has already been joined (or detached).
+  // Cancellation is deferred, so the task stops at its next
+  // blocking call.  feabhOS blocking calls undo their waiting
+  // state as the task is cancelled, but any mutex it holds
+  // stays locked (see feabhOS_task.h)
+  //
+  if(task->is_joinable)
+  {
+    pthread_cancel(task->handle);
+    pthread_join(task->handle, NULL);
+  }
 
-  terminate_task(&task);
   deallocate(task);
 
   return ERROR_OK;
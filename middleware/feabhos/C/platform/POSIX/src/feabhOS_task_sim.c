@@ -0,0 +1,314 @@
+// feabhOS_task_sim.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <assert.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <stddef.h>
+
+#include "feabhOS_task.h"
+#include "feabhOS_sim.h"
+
+// ----------------------------------------------------------------------------
+//  Simulation tasks (see feabhOS_sim.h).
+//  Each task is a pthread, but only runs when scheduled by the
+//  simulation kernel.  Sleeping advances virtual time.
+// ----------------------------------------------------------------------------
+
+// ----------------------------------------------------------------------------
+// Making a blocking call before the scheduler is started
+// could lock up the entire system.  Therefore, any attempt
+// to make a blocking call should assert.
+//
+extern bool scheduler_started;
+
+// ----------------------------------------------------------------------------
+// Static function prototypes
+//
+static void* scheduled_function(void *arg);
+
+
+struct user_code
+{
+  void (*function)(void*);
+  void *parameter;
+};
+
+
+struct feabhOS_task
+{
+  OS_TASK_TYPE      handle;
+  bool              is_joinable;
+  struct user_code  user_code;
+  sim_task          sim;
+};
+
+// ----------------------------------------------------------------------------
+//
+//  MEMORY MANAGEMENT FOR TASK STRUCTURES
+//  ----------------------------------
+//
+//  For a fixed number of tasks we use a fixed-block
+//  dynamic allocator.
+//  If MAX_TASKS == NO_LIMIT we use the underlying OS'
+//  dynamic memory allocator (usually malloc)
+//
+
+#if MAX_TASKS==NO_LIMIT
+
+#include "feabhOS_memory.h"
+
+static feabhOS_TASK allocate(void)
+{
+  return feabhOS_memory_alloc(sizeof(struct feabhOS_task));
+}
+
+
+static void deallocate(feabhOS_TASK task)
+{
+  feabhOS_memory_free(task);
+}
+
+#else
+
+#include "feabhOS_allocator.h"
+
+static struct feabhOS_task tasks[MAX_TASKS];
+static feabhOS_POOL task_pool = NULL;
+
+
+static feabhOS_TASK allocate(void)
+{
+  // Create the pool the first time an object is allocated
+  //
+  if(task_pool == NULL)
+  {
+    feabhOS_pool_create(&task_pool,
+                        tasks,
+                        sizeof(tasks),
+                        sizeof(struct feabhOS_task),
+                        MAX_TASKS);
+  }
+
+  return feabhOS_block_allocate(&task_pool);
+}
+
+
+static void deallocate(feabhOS_TASK task)
+{
+  feabhOS_block_free(&task_pool, task);
+}
+
+#endif
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_task_create(feabhOS_TASK * const  task_handle,
+                                  void (*function)(void*),
+                                  void *                param,
+                                  feabhOS_stack_size_t  stack,
+                                  feabhOS_priority_t    priority)
+{
+  feabhOS_TASK  task;
+  OS_ERROR_TYPE OS_error;
+
+  // Parameter checks:
+  //
+  if(function == NULL)                                              return ERROR_PARAM1;
+  if((stack < STACK_TINY) || (stack > STACK_HUGE))                  return ERROR_PARAM3;
+  if((priority < PRIORITY_LOWEST) || (priority > PRIORITY_HIGHEST)) return ERROR_PARAM4;
+
+  task = allocate();
+  *task_handle = task;
+  if(task == NULL) return ERROR_OUT_OF_MEMORY;
+
+  task->user_code.function  = function;
+  task->user_code.parameter = param;
+  task->is_joinable         = true;
+
+  sim_task_add(&task->sim, priority);
+
+  pthread_attr_t task_attributes;
+  pthread_attr_init(&task_attributes);
+  pthread_attr_setstacksize(&task_attributes, stack);
+
+  OS_error = pthread_create(&task->handle,
+                            &task_attributes,
+                            scheduled_function,
+                            (void*)task);
+
+  pthread_attr_destroy(&task_attributes);
+
+  if(OS_error != 0)
+  {
+    sim_task_kill(&task->sim);
+    deallocate(task);
+    *task_handle = NULL;
+    return ERROR_OUT_OF_MEMORY;
+  }
+
+  // Run the new task now if it has a higher priority
+  //
+  sim_preempt();
+
+  return ERROR_OK;
+}
+
+// ----------------------------------------------------------------------------
+//
+void* scheduled_function(void *arg)
+{
+  feabhOS_TASK task = (feabhOS_TASK)arg;
+
+  sim_task_start(&task->sim);
+  task->user_code.function(task->user_code.parameter);
+  sim_task_exit();
+
+  return NULL;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_task_join(feabhOS_TASK * const task_handle)
+{
+  // Parameter checking:
+  //
+  assert(scheduler_started == true);
+  if(task_handle == NULL) return ERROR_INVALID_HANDLE;
+
+  feabhOS_TASK task = *task_handle;
+
+  if(!task->is_joinable) return ERROR_NOT_JOINABLE;
+
+  // Wait (in virtual time) for the task to finish, then
+  // reclaim its thread.  The thread exits as soon as it
+  // has handed over the processor.
+  //
+  sim_task_join(&task->sim);
+  pthread_join(task->handle, NULL);
+
+  task->is_joinable = false;
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_task_detach(feabhOS_TASK * const task_handle)
+{
+  // Parameter checking:
+  //
+  if(task_handle == NULL)                          return ERROR_INVALID_HANDLE;
+  if((*task_handle)->handle == (OS_TASK_TYPE)NULL) return ERROR_STUPID;
+
+  feabhOS_TASK task = *task_handle;
+
+  task->is_joinable = false;
+  pthread_detach(task->handle);
+
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_task_setPriority(feabhOS_TASK * const task_handle,
+                                       feabhOS_priority_t   prio)
+{
+  // Parameter checking:
+  //
+  if(task_handle == NULL)                                   return ERROR_INVALID_HANDLE;
+  if((*task_handle)->handle == (OS_TASK_TYPE)NULL)          return ERROR_STUPID;
+  if((prio < PRIORITY_LOWEST) || (prio > PRIORITY_HIGHEST)) return ERROR_PARAM1;
+
+  feabhOS_TASK task = *task_handle;
+
+  sim_task_set_priority(&task->sim, prio);
+  return ERROR_OK;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_task_destroy(feabhOS_TASK * const task_handle)
+{
+  // Parameter checking:
+  //
+  if(task_handle == NULL)                          return ERROR_INVALID_HANDLE;
+  if((*task_handle)->handle == (OS_TASK_TYPE)NULL) return ERROR_STUPID;
+
+  feabhOS_TASK task = *task_handle;
+  *task_handle = NULL;
+
+  // A task destroying itself never returns.
+  //
+  if(&task->sim == sim_self())
+  {
+    if(task->is_joinable) pthread_detach(task->handle);
+    sim_task_exit();
+    deallocate(task);
+    pthread_exit(NULL);
+  }
+
+  // Another task is removed from the simulation and
+  // its thread reclaimed, unless it has already been
+  // joined (or detached)
+  //
+  sim_task_kill(&task->sim);
+
+  if(task->is_joinable)
+  {
+    pthread_join(task->handle, NULL);
+  }
+
+  pthread_cond_destroy(&task->sim.run);
+  deallocate(task);
+
+  return ERROR_OK;
+}
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_task_suspend(feabhOS_TASK * const task_handle)
+{
+  // Parameter checking:
+  //
+  if(task_handle == NULL)                          return ERROR_INVALID_HANDLE;
+  if((*task_handle)->handle == (OS_TASK_TYPE)NULL) return ERROR_STUPID;
+
+  // As the POSIX port, suspension is not supported
+  //
+  return ERROR_STUPID;
+}
+
+
+// ----------------------------------------------------------------------------
+//
+feabhOS_error feabhOS_task_resume(feabhOS_TASK * const task_handle)
+{
+  // Parameter checking:
+  //
+  if(task_handle == NULL)                          return ERROR_INVALID_HANDLE;
+  if((*task_handle)->handle == (OS_TASK_TYPE)NULL) return ERROR_STUPID;
+
+  // As the POSIX port, suspension is not supported
+  //
+  return ERROR_STUPID;
+}
+
+// ----------------------------------------------------------------------------
+//
+void feabhOS_task_sleep(duration_mSec_t period)
+{
+  sim_sleep(period);
+}
+
+
+// ----------------------------------------------------------------------------
+//
+void feabhOS_task_yield(void)
+{
+  sim_yield();
+}
@@ -42,7 +42,13 @@ struct timespec timespec_add(const struct timespec* const lhs,
   struct timespec result;
 
   result.tv_sec  = lhs->tv_sec + rhs->tv_sec;
-  result.tv_nsec = (lhs->tv_nsec + rhs->tv_nsec) % 1000000000L;
+  result.tv_nsec = lhs->tv_nsec + rhs->tv_nsec;
+
+  if(result.tv_nsec >= 1000000000L)
+  {
+    result.tv_sec++;
+    result.tv_nsec -= 1000000000L;
+  }
 
   return result;
 }
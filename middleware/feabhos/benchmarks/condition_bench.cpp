@@ -0,0 +1,91 @@
+// condition_bench.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <benchmark/benchmark.h>
+#include "Condition.h"
+#include "Mutex.h"
+#include "Thread.h"
+
+// -------------------------------------------------------------------------------------
+// Condition broadcast.
+// A number of waiting tasks (the argument) block on a condition.
+// Each iteration the benchmark thread starts a new generation,
+// broadcasts with notify_all() and waits until every task has
+// woken and acknowledged it, so the time per iteration is the
+// cost of waking all of the waiting tasks.
+// -------------------------------------------------------------------------------------
+
+namespace {
+
+  struct Broadcast {
+    FeabhOS::Mutex     mutex        { };
+    FeabhOS::Condition generation_changed { };
+    FeabhOS::Condition acknowledged { };
+    std::uint32_t      generation   { };
+    std::uint32_t      acks         { };
+    bool               stop         { };
+  };
+
+
+  void waiter(Broadcast* shared)
+  {
+    std::uint32_t seen { };
+
+    CRITICAL_SECTION(shared->mutex)
+    {
+      while (!shared->stop) {
+        while (shared->generation == seen && !shared->stop) {
+          shared->generation_changed.wait(shared->mutex);
+        }
+        seen = shared->generation;
+        ++shared->acks;
+        shared->acknowledged.notify_one();
+      }
+    }
+  }
+
+
+  void BM_Condition_broadcast(benchmark::State& state)
+  {
+    auto num_waiters = static_cast<std::uint32_t>(state.range(0));
+
+    Broadcast shared { };
+    std::vector<std::unique_ptr<FeabhOS::Thread>> waiters { };
+
+    for (std::uint32_t w = 0; w < num_waiters; ++w) {
+      waiters.emplace_back(new FeabhOS::Thread { waiter, &shared });
+    }
+
+    for (auto _ : state) {
+      CRITICAL_SECTION(shared.mutex)
+      {
+        ++shared.generation;
+        shared.acks = 0;
+        shared.generation_changed.notify_all();
+
+        while (shared.acks < num_waiters) {
+          shared.acknowledged.wait(shared.mutex);
+        }
+      }
+    }
+
+    CRITICAL_SECTION(shared.mutex)
+    {
+      shared.stop = true;
+      shared.generation_changed.notify_all();
+    }
+
+    for (auto& w : waiters) {
+      w->join();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * num_waiters));
+  }
+
+} // namespace
+
+BENCHMARK(BM_Condition_broadcast)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
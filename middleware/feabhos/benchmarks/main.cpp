@@ -0,0 +1,27 @@
+// main.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <benchmark/benchmark.h>
+#include "Scheduler.h"
+
+// -------------------------------------------------------------------------------------
+// feabhOS host benchmarks.
+// The POSIX port runs feabhOS tasks as pthreads so the scheduler
+// is started before any benchmark creates a task.
+// Run with --help for the Google Benchmark options, for example
+// --benchmark_filter=Queue or --benchmark_format=json.
+// -------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+  FeabhOS::Scheduler::init();
+  FeabhOS::Scheduler::start();
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
@@ -0,0 +1,59 @@
+// mutex_bench.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <cstdint>
+#include <benchmark/benchmark.h>
+#include "Mutex.h"
+
+// -------------------------------------------------------------------------------------
+// Mutex handoff.
+// Each benchmark thread repeatedly locks and unlocks a shared
+// feabhOS mutex. With one thread this is the uncontended cost;
+// with more threads the lock is handed between them and the
+// time per iteration includes the wake-up latency.
+// -------------------------------------------------------------------------------------
+
+namespace {
+
+  FeabhOS::Mutex& shared_mutex()
+  {
+    static FeabhOS::Mutex mutex { };
+    return mutex;
+  }
+
+  std::uint64_t shared_count { };
+
+
+  void BM_Mutex_handoff(benchmark::State& state)
+  {
+    FeabhOS::Mutex& mutex = shared_mutex();
+
+    for (auto _ : state) {
+      mutex.lock();
+      ++shared_count;
+      mutex.unlock();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+
+  void BM_Mutex_try_lock(benchmark::State& state)
+  {
+    FeabhOS::Mutex& mutex = shared_mutex();
+
+    for (auto _ : state) {
+      if (mutex.try_lock()) {
+        ++shared_count;
+        mutex.unlock();
+      }
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+} // namespace
+
+BENCHMARK(BM_Mutex_handoff)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_Mutex_try_lock)->ThreadRange(1, 8)->UseRealTime();
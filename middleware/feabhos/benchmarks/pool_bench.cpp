@@ -0,0 +1,65 @@
+// pool_bench.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <cstdint>
+#include <array>
+#include <benchmark/benchmark.h>
+#include "feabhOS_allocator.h"
+#include "feabhOS_memory.h"
+
+// -------------------------------------------------------------------------------------
+// Pool allocation.
+// Compares the feabhOS fixed-block allocator with the general
+// purpose feabhOS_memory_alloc() (malloc on POSIX) as the number
+// of threads allocating from the same pool increases.
+// The allocator only supports a limited number of pools (and
+// never frees them) so a single pool is shared by every run.
+// -------------------------------------------------------------------------------------
+
+namespace {
+
+  constexpr std::size_t block_size { 64 };
+  constexpr std::size_t num_blocks { 256 };
+
+  feabhOS_POOL& shared_pool()
+  {
+    static std::array<std::uint8_t, block_size * num_blocks> memory { };
+    static feabhOS_POOL pool = [] {
+      feabhOS_POOL p { };
+      feabhOS_pool_create(&p, memory.data(), memory.size(), block_size, num_blocks);
+      return p;
+    }();
+    return pool;
+  }
+
+
+  void BM_Pool_allocate(benchmark::State& state)
+  {
+    feabhOS_POOL& pool = shared_pool();
+
+    for (auto _ : state) {
+      void* block = feabhOS_block_allocate(&pool);
+      benchmark::DoNotOptimize(block);
+      feabhOS_block_free(&pool, block);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+
+  void BM_Memory_allocate(benchmark::State& state)
+  {
+    for (auto _ : state) {
+      void* block = feabhOS_memory_alloc(block_size);
+      benchmark::DoNotOptimize(block);
+      feabhOS_memory_free(block);
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+} // namespace
+
+BENCHMARK(BM_Pool_allocate)->ThreadRange(1, 8)->UseRealTime();
+BENCHMARK(BM_Memory_allocate)->ThreadRange(1, 8)->UseRealTime();
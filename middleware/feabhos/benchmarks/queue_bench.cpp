@@ -0,0 +1,62 @@
+// queue_bench.cpp
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <benchmark/benchmark.h>
+#include "MessageQueue.h"
+#include "Thread.h"
+
+// -------------------------------------------------------------------------------------
+// MessageQueue throughput.
+// One or more producer tasks post messages which are retrieved
+// by the benchmark thread; the argument is the number of producers.
+// The producers share out exactly the number of messages the
+// benchmark will retrieve so every task finishes with the loop.
+// -------------------------------------------------------------------------------------
+
+namespace {
+
+  constexpr std::size_t queue_size { 16 };
+
+  using Queue = FeabhOS::MessageQueue<std::uint32_t, queue_size>;
+
+  void produce(Queue* queue, std::uint32_t count)
+  {
+    for (std::uint32_t i = 0; i < count; ++i) {
+      queue->post(i);
+    }
+  }
+
+
+  void BM_MessageQueue_throughput(benchmark::State& state)
+  {
+    auto num_producers = static_cast<std::uint32_t>(state.range(0));
+    auto total         = static_cast<std::uint32_t>(state.max_iterations);
+
+    Queue queue { };
+    std::vector<std::unique_ptr<FeabhOS::Thread>> producers { };
+
+    for (std::uint32_t p = 0; p < num_producers; ++p) {
+      std::uint32_t count = (total / num_producers) + ((p < (total % num_producers)) ? 1 : 0);
+      producers.emplace_back(new FeabhOS::Thread { produce, &queue, count });
+    }
+
+    std::uint32_t msg { };
+    for (auto _ : state) {
+      queue.get(msg);
+      benchmark::DoNotOptimize(msg);
+    }
+
+    for (auto& producer : producers) {
+      producer->join();
+    }
+
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+  }
+
+} // namespace
+
+BENCHMARK(BM_MessageQueue_throughput)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
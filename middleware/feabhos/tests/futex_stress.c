@@ -0,0 +1,232 @@
+// futex_stress.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "feabhOS_scheduler.h"
+#include "feabhOS_semaphore.h"
+#include "feabhOS_signal.h"
+
+// -------------------------------------------------------------------------------------
+// Signal and semaphore stress test.
+// NUM_TASKS producers give and NUM_TASKS waiters take at the same
+// time, and every wakeup is counted.  A lost wakeup leaves a waiter
+// blocked until its (long) timeout expires, which fails the test.
+//
+// Signal: in each round the waiters block first, then the producers
+// each call notify_one() once, together.  Every waiter must wake.
+//
+// Semaphore: each producer gives GIVES_PER_TASK times to a
+// semaphore with a maximum count of one, retrying when it is full,
+// and each waiter takes GIVES_PER_TASK times.
+// -------------------------------------------------------------------------------------
+
+#define NUM_TASKS       8
+#define SIGNAL_ROUNDS   200
+#define GIVES_PER_TASK  20000
+#define LOST_WAKEUP     5000      // mSec; a wait this long is a failure
+
+static unsigned failures = 0;
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if(!(condition))                                                      \
+    {                                                                     \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+              #condition);                                                \
+      ++failures;                                                         \
+    }                                                                     \
+  } while(0)
+
+
+static void sleep_mSec(long period)
+{
+  struct timespec delay = { period / 1000, (period % 1000) * 1000000L };
+  nanosleep(&delay, NULL);
+}
+
+
+static void start_tasks(pthread_t* tasks, void* (*fn)(void*), void* arg)
+{
+  for(unsigned i = 0; i < NUM_TASKS; ++i)
+  {
+    pthread_create(&tasks[i], NULL, fn, arg);
+  }
+}
+
+
+static void join_tasks(pthread_t* tasks)
+{
+  for(unsigned i = 0; i < NUM_TASKS; ++i)
+  {
+    pthread_join(tasks[i], NULL);
+  }
+}
+
+
+// -------------------------------------------------------------------------------------
+// Signal
+//
+static struct
+{
+  feabhOS_SIGNAL signal;
+  unsigned       round;        // Producers wait for the round to change
+  unsigned       woken;
+  unsigned       timed_out;
+} sig;
+
+
+static void* signal_waiter(void* arg)
+{
+  (void)arg;
+  if(feabhOS_signal_wait(&sig.signal, LOST_WAKEUP) == ERROR_OK)
+  {
+    __atomic_add_fetch(&sig.woken, 1, __ATOMIC_SEQ_CST);
+  }
+  else
+  {
+    __atomic_add_fetch(&sig.timed_out, 1, __ATOMIC_SEQ_CST);
+  }
+  return NULL;
+}
+
+
+static void* signal_producer(void* arg)
+{
+  unsigned round = *(unsigned*)arg;
+  while(__atomic_load_n(&sig.round, __ATOMIC_ACQUIRE) == round)
+  {
+    ; // Spin so the producers notify together
+  }
+  feabhOS_signal_notify_one(&sig.signal);
+  return NULL;
+}
+
+
+static void signal_stress(void)
+{
+  pthread_t waiters[NUM_TASKS];
+  pthread_t producers[NUM_TASKS];
+
+  CHECK(feabhOS_signal_create(&sig.signal) == ERROR_OK);
+
+  for(unsigned round = 0; round < SIGNAL_ROUNDS; ++round)
+  {
+    sig.woken     = 0;
+    sig.timed_out = 0;
+
+    start_tasks(waiters, signal_waiter, NULL);
+    sleep_mSec(10);             // Let every waiter block
+
+    start_tasks(producers, signal_producer, &round);
+    sleep_mSec(1);              // Let every producer reach the spin
+    __atomic_store_n(&sig.round, round + 1, __ATOMIC_RELEASE);
+
+    join_tasks(producers);
+    join_tasks(waiters);
+
+    if(sig.woken != NUM_TASKS)
+    {
+      fprintf(stderr, "signal round %u: %u of %u waiters woken\n",
+              round, sig.woken, NUM_TASKS);
+    }
+    CHECK(sig.woken == NUM_TASKS);
+    CHECK(sig.timed_out == 0);
+    if(failures != 0) break;
+  }
+
+  // No release is left pending once every waiter has woken
+  //
+  CHECK(feabhOS_signal_wait(&sig.signal, NO_WAIT) == ERROR_TIMED_OUT);
+
+  feabhOS_signal_destroy(&sig.signal);
+}
+
+
+// -------------------------------------------------------------------------------------
+// Semaphore
+//
+static struct
+{
+  feabhOS_SEMAPHORE semaphore;
+  unsigned          taken;
+  unsigned          timed_out;
+} sem;
+
+
+static void* semaphore_waiter(void* arg)
+{
+  (void)arg;
+  for(unsigned i = 0; i < GIVES_PER_TASK; ++i)
+  {
+    if(feabhOS_semaphore_take(&sem.semaphore, LOST_WAKEUP) != ERROR_OK)
+    {
+      __atomic_add_fetch(&sem.timed_out, 1, __ATOMIC_SEQ_CST);
+      break;
+    }
+    __atomic_add_fetch(&sem.taken, 1, __ATOMIC_SEQ_CST);
+  }
+  return NULL;
+}
+
+
+static void* semaphore_producer(void* arg)
+{
+  (void)arg;
+  for(unsigned i = 0; i < GIVES_PER_TASK; ++i)
+  {
+    while(feabhOS_semaphore_give(&sem.semaphore) == ERROR_MAX_COUNT)
+    {
+      // Stop if a waiter has given up, or this never ends
+      //
+      if(__atomic_load_n(&sem.timed_out, __ATOMIC_SEQ_CST) != 0) return NULL;
+      sched_yield();
+    }
+  }
+  return NULL;
+}
+
+
+static void semaphore_stress(void)
+{
+  pthread_t waiters[NUM_TASKS];
+  pthread_t producers[NUM_TASKS];
+
+  CHECK(feabhOS_semaphore_create(&sem.semaphore, 1, 0) == ERROR_OK);
+
+  start_tasks(waiters, semaphore_waiter, NULL);
+  start_tasks(producers, semaphore_producer, NULL);
+
+  join_tasks(producers);
+  join_tasks(waiters);
+
+  CHECK(sem.taken == NUM_TASKS * GIVES_PER_TASK);
+  CHECK(sem.timed_out == 0);
+  CHECK(feabhOS_semaphore_take(&sem.semaphore, NO_WAIT) == ERROR_TIMED_OUT);
+
+  feabhOS_semaphore_destroy(&sem.semaphore);
+}
+
+
+int main(void)
+{
+  feabhOS_scheduler_init();
+  feabhOS_scheduler_start();
+
+  signal_stress();
+  semaphore_stress();
+
+  if(failures != 0)
+  {
+    fprintf(stderr, "%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("signal: %u rounds of %u waiters, semaphore: %u gives, all woken\n",
+         SIGNAL_ROUNDS, NUM_TASKS, NUM_TASKS * GIVES_PER_TASK);
+  return 0;
+}
@@ -0,0 +1,107 @@
+// signal_notify.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <stdio.h>
+
+#include "feabhOS_scheduler.h"
+#include "feabhOS_signal.h"
+#include "feabhOS_task.h"
+
+// -------------------------------------------------------------------------------------
+// Signal notification.
+// notify_one() with no task waiting leaves one release pending;
+// notify_all() only releases the tasks waiting at the time.  A
+// task that takes a pending release must not still be counted as
+// waiting, or a later notify_all() leaves a release for it.
+// -------------------------------------------------------------------------------------
+
+#define BLOCK_TIME  50      // mSec; long enough for a task to block
+
+static unsigned failures = 0;
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if(!(condition))                                                      \
+    {                                                                     \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+              #condition);                                                \
+      ++failures;                                                         \
+    }                                                                     \
+  } while(0)
+
+
+static feabhOS_SIGNAL signal;
+
+
+// Take a pending release with each kind of wait, then check
+// notify_all() does not leave another one behind.
+//
+static void pending_release(duration_mSec_t timeout)
+{
+  CHECK(feabhOS_signal_notify_one(&signal) == ERROR_OK);
+  CHECK(feabhOS_signal_wait(&signal, timeout) == ERROR_OK);
+
+  CHECK(feabhOS_signal_notify_all(&signal) == ERROR_OK);
+  CHECK(feabhOS_signal_wait(&signal, NO_WAIT) == ERROR_TIMED_OUT);
+}
+
+
+static unsigned woken = 0;
+
+static void waiter(void* arg)
+{
+  (void)arg;
+  if(feabhOS_signal_wait(&signal, WAIT_FOREVER) == ERROR_OK)
+  {
+    __atomic_add_fetch(&woken, 1, __ATOMIC_SEQ_CST);
+  }
+}
+
+
+// notify_all() releases a blocked task, and only that task
+//
+static void blocked_waiters(void)
+{
+  feabhOS_TASK tasks[2];
+  for(unsigned i = 0; i < 2; ++i)
+  {
+    CHECK(feabhOS_task_create(&tasks[i], waiter, NULL, STACK_NORMAL, PRIORITY_NORMAL) == ERROR_OK);
+  }
+  feabhOS_task_sleep(BLOCK_TIME);
+
+  CHECK(feabhOS_signal_notify_all(&signal) == ERROR_OK);
+  for(unsigned i = 0; i < 2; ++i)
+  {
+    CHECK(feabhOS_task_join(&tasks[i]) == ERROR_OK);
+  }
+  CHECK(woken == 2);
+
+  CHECK(feabhOS_signal_wait(&signal, NO_WAIT) == ERROR_TIMED_OUT);
+  CHECK(feabhOS_signal_notify_all(&signal) == ERROR_OK);
+  CHECK(feabhOS_signal_wait(&signal, NO_WAIT) == ERROR_TIMED_OUT);
+}
+
+
+int main(void)
+{
+  feabhOS_scheduler_init();
+  feabhOS_scheduler_start();
+
+  CHECK(feabhOS_signal_create(&signal) == ERROR_OK);
+
+  pending_release(NO_WAIT);
+  pending_release(WAIT_FOREVER);
+  pending_release(BLOCK_TIME);
+  blocked_waiters();
+
+  feabhOS_signal_destroy(&signal);
+
+  if(failures != 0)
+  {
+    fprintf(stderr, "%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("signal: pending releases taken, notify_all releases only waiting tasks\n");
+  return 0;
+}
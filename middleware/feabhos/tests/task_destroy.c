@@ -0,0 +1,137 @@
+// task_destroy.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include <stdio.h>
+
+#include "feabhOS_eventflags.h"
+#include "feabhOS_queue.h"
+#include "feabhOS_scheduler.h"
+#include "feabhOS_semaphore.h"
+#include "feabhOS_signal.h"
+#include "feabhOS_task.h"
+
+// -------------------------------------------------------------------------------------
+// Destroying a blocked task.
+// Each task blocks forever on a semaphore, queue, signal or event
+// flags and is then destroyed.  A wait that is not a cancellation
+// point leaves feabhOS_task_destroy() joined on a task that never
+// stops, which the test's timeout fails.
+// Once the waiter has gone, the object must behave as though it
+// had never waited: a later notify or give is not lost to it.
+// -------------------------------------------------------------------------------------
+
+#define BLOCK_TIME  50      // mSec; long enough for a task to block
+
+static unsigned failures = 0;
+
+#define CHECK(condition)                                                  \
+  do {                                                                    \
+    if(!(condition))                                                      \
+    {                                                                     \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__,    \
+              #condition);                                                \
+      ++failures;                                                         \
+    }                                                                     \
+  } while(0)
+
+
+static feabhOS_SEMAPHORE  semaphore;
+static feabhOS_QUEUE      queue;
+static feabhOS_SIGNAL     signal;
+static feabhOS_EVENTFLAGS event_flags;
+
+static unsigned returned = 0;   // Waits that (wrongly) returned
+
+
+static void take_semaphore(void* arg)
+{
+  (void)arg;
+  feabhOS_semaphore_take(&semaphore, WAIT_FOREVER);
+  __atomic_add_fetch(&returned, 1, __ATOMIC_SEQ_CST);
+}
+
+
+static void get_from_queue(void* arg)
+{
+  (void)arg;
+  int item;
+  feabhOS_queue_get(&queue, &item, WAIT_FOREVER);
+  __atomic_add_fetch(&returned, 1, __ATOMIC_SEQ_CST);
+}
+
+
+static void wait_for_signal(void* arg)
+{
+  (void)arg;
+  feabhOS_signal_wait(&signal, WAIT_FOREVER);
+  __atomic_add_fetch(&returned, 1, __ATOMIC_SEQ_CST);
+}
+
+
+static void wait_for_flags(void* arg)
+{
+  (void)arg;
+  bitmask8_t flags = 0x01;
+  feabhOS_eventflags_wait_all(&event_flags, &flags, WAIT_FOREVER);
+  __atomic_add_fetch(&returned, 1, __ATOMIC_SEQ_CST);
+}
+
+
+static void destroy_blocked(void (*wait)(void*))
+{
+  feabhOS_TASK task;
+  CHECK(feabhOS_task_create(&task, wait, NULL, STACK_NORMAL, PRIORITY_NORMAL) == ERROR_OK);
+
+  feabhOS_task_sleep(BLOCK_TIME);
+  CHECK(feabhOS_task_destroy(&task) == ERROR_OK);
+  CHECK(task == NULL);
+}
+
+
+int main(void)
+{
+  feabhOS_scheduler_init();
+  feabhOS_scheduler_start();
+
+  CHECK(feabhOS_semaphore_create(&semaphore, 1, 0) == ERROR_OK);
+  CHECK(feabhOS_queue_create(&queue, sizeof(int), 1) == ERROR_OK);
+  CHECK(feabhOS_signal_create(&signal) == ERROR_OK);
+  CHECK(feabhOS_eventflags_create(&event_flags) == ERROR_OK);
+
+  destroy_blocked(take_semaphore);
+  destroy_blocked(get_from_queue);
+  destroy_blocked(wait_for_signal);
+  destroy_blocked(wait_for_flags);
+
+  CHECK(returned == 0);
+
+  // The destroyed tasks no longer count as waiting: a give or
+  // post is still there to be taken, and notify_all() does
+  // not leave a release for a task that has gone.
+  //
+  int item = 42;
+  CHECK(feabhOS_semaphore_give(&semaphore) == ERROR_OK);
+  CHECK(feabhOS_semaphore_take(&semaphore, NO_WAIT) == ERROR_OK);
+
+  CHECK(feabhOS_queue_post(&queue, &item, NO_WAIT) == ERROR_OK);
+  item = 0;
+  CHECK(feabhOS_queue_get(&queue, &item, NO_WAIT) == ERROR_OK);
+  CHECK(item == 42);
+
+  CHECK(feabhOS_signal_notify_all(&signal) == ERROR_OK);
+  CHECK(feabhOS_signal_wait(&signal, NO_WAIT) == ERROR_TIMED_OUT);
+
+  feabhOS_eventflags_destroy(&event_flags);
+  feabhOS_signal_destroy(&signal);
+  feabhOS_queue_destroy(&queue);
+  feabhOS_semaphore_destroy(&semaphore);
+
+  if(failures != 0)
+  {
+    fprintf(stderr, "%u check(s) failed\n", failures);
+    return 1;
+  }
+  printf("semaphore, queue, signal and event flag waiters destroyed\n");
+  return 0;
+}
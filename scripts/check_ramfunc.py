@@ -0,0 +1,79 @@
+#!/usr/bin/python3
+"""
+Usage: check_ramfunc.py [--help] [--objdump path] elf-file [function]...
+Check that functions were linked into the `.ramfunc` (SRAM) section.
+
+The linker script selects the FreeRTOS PendSV/SysTick handlers and the
+kernel functions they call by input section name (for example
+`.text.PendSV_Handler`). Anything that renames or merges those sections,
+such as compiling the kernel with link time optimisation, silently
+leaves the functions in flash. This is run after every RTOS link and
+fails the build if any of the functions is missing or is in another
+section.
+
+The functions default to PendSV_Handler, vTaskSwitchContext,
+SysTick_Handler and xTaskIncrementTick. The symbol table is read with
+`objdump -t` (default `arm-none-eabi-objdump`).
+"""
+import re
+import subprocess
+import sys
+
+
+class Config:
+    objdump = 'arm-none-eabi-objdump'
+    section = '.ramfunc'
+    functions = [
+        'PendSV_Handler',
+        'vTaskSwitchContext',
+        'SysTick_Handler',
+        'xTaskIncrementTick',
+    ]
+
+
+# objdump -t lines: address flags section size name, where the
+# flags field is a fixed seven characters wide
+SYMBOL = re.compile(r'^[0-9a-fA-F]+ .{7} (\S+)\s+[0-9a-fA-F]+\s+(\S+)$')
+
+
+def symbol_sections(elf: str) -> dict:
+    output = subprocess.run([Config.objdump, '-t', elf], check=True,
+                            capture_output=True, text=True).stdout
+    sections = {}
+    for line in output.splitlines():
+        match = SYMBOL.match(line)
+        if match:
+            sections.setdefault(match.group(2), match.group(1))
+    return sections
+
+
+def main(argv: list) -> int:
+    args = []
+    it = iter(argv)
+    for arg in it:
+        if arg in ('-h', '--help'):
+            print(__doc__)
+            return 0
+        if arg == '--objdump':
+            Config.objdump = next(it)
+        else:
+            args.append(arg)
+    if not args:
+        print(__doc__, file=sys.stderr)
+        return 2
+
+    elf, functions = args[0], args[1:] or Config.functions
+    sections = symbol_sections(elf)
+    errors = 0
+    for function in functions:
+        section = sections.get(function)
+        if section != Config.section:
+            where = f'in {section}' if section else 'not found'
+            print(f'{elf}: {function} {where}, expected {Config.section}',
+                  file=sys.stderr)
+            errors += 1
+    return 1 if errors else 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv[1:]))
@@ -0,0 +1,379 @@
+#!/usr/bin/python3
+"""
+Usage: map_size.py [--help] [options] [map-file]
+Report flash and RAM usage from a GNU linker map file broken down by
+module (CMake target, library or archive), object file and symbol.
+
+The map file defaults to `build/debug/Application.map`.
+
+Options:
+    --objects          -- list usage by object file within each module
+    --symbols N        -- list the N largest symbols (default 20, 0 for none)
+    --baseline file    -- compare against a baseline saved with --save
+    --threshold T      -- fail if any memory region grows by more than
+                          T bytes, or T percent when written as T%,
+                          compared with the baseline (default 0)
+    --save file        -- save the current usage as a new baseline
+    --bootstrap        -- report without comparing if the --baseline file
+                          does not exist (otherwise a missing baseline fails)
+
+Module names are taken from the CMake target directory of each object
+file (for example `system` or `drivers-cpp`), or the name of the archive
+it was extracted from (for example `libstdc++` or `libc_nano`).
+The middleware library is split into `feabhOS` and `FreeRTOS`. Space
+added by the linker script itself, such as the stack and heap
+reservation, is reported as `(linker script)`.
+
+For archive members the object file that first referenced them is
+shown with --objects: this explains why, say, iostream support is
+present in the image.
+"""
+import json
+import re
+import shutil
+import subprocess
+import sys
+from collections import defaultdict
+from pathlib import Path
+
+
+class MapSizeError(Exception):
+    pass
+
+
+class Config:
+    map_file = Path('build/debug/Application.map')
+    symbols = 20
+    objects = False
+    baseline = None
+    bootstrap = False
+    save = None
+    threshold = '0'
+    linker = '(linker script)'
+    fill = '(fill)'
+    lto = '(lto)'
+    named_sections = ('CCMRAM',)
+    split_archives = {
+        'middleware': [('feabhOS_', 'feabhOS'), ('feabhas_', 'feabhOS'), ('', 'FreeRTOS')],
+    }
+
+
+class Usage:
+    """Bytes used in each memory region by a set of modules, objects and symbols"""
+    def __init__(self):
+        self.regions = defaultdict(int)
+        self.modules = defaultdict(lambda: defaultdict(int))
+        self.objects = defaultdict(lambda: defaultdict(int))
+        self.symbols = defaultdict(lambda: defaultdict(int))
+        self.pulled_by = {}
+
+    def add(self, regions: list, size: int, module: str, obj: str, symbol: str):
+        for region in regions:
+            self.regions[region] += size
+            self.modules[module][region] += size
+            self.objects[f'{module}: {obj}'][region] += size
+            if symbol:
+                self.symbols[symbol][region] += size
+
+    def to_json(self) -> dict:
+        return {
+            'regions': dict(self.regions),
+            'modules': {name: dict(used) for name, used in self.modules.items()},
+            'objects': {name: dict(used) for name, used in self.objects.items()},
+        }
+
+
+class MapFile:
+    region_pattern = re.compile(r'^(\S+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)')
+    output_pattern = re.compile(r'^(\.\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)'
+                                r'(?:\s+load address 0x([0-9a-f]+))?)?\s*$')
+    input_pattern = re.compile(r'^ (\S+)(?:\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)(?:\s+(\S.*))?)?\s*$')
+    wrapped_pattern = re.compile(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$')
+    archive_pattern = re.compile(r'([^/\\]+)\.a\(([^)]+)\)$')
+    target_pattern = re.compile(r'CMakeFiles/([^/]+)\.dir/(.*)$')
+
+    def __init__(self, path: Path):
+        if not path.exists():
+            raise MapSizeError(f'Cannot find map file {path}: build the application first')
+        self.lines = path.read_text(errors='replace').splitlines()
+        self.regions = []
+        self.usage = Usage()
+
+    def region(self, address: int):
+        for name, origin, length in self.regions:
+            if origin <= address < origin + length:
+                return name
+        return None
+
+    @staticmethod
+    def module(filename: str) -> tuple:
+        filename = filename.replace('\\', '/')
+        match = MapFile.archive_pattern.search(filename)
+        if match:
+            archive, member = match.groups()
+            # project libraries are built in the build folder
+            if not Path(filename).is_absolute() and archive.startswith('lib'):
+                archive = archive[3:]
+            for prefix, name in Config.split_archives.get(archive, []):
+                if member.startswith(prefix):
+                    return name, member
+            return archive, member
+        match = MapFile.target_pattern.search(filename)
+        if match:
+            return match.groups()
+        if '.ltrans' in filename:
+            return Config.lto, Path(filename).name
+        return Path(filename).stem, Path(filename).name
+
+    @staticmethod
+    def symbol(section: str, obj: str) -> str:
+        for prefix in ('.text.', '.rodata.', '.data.', '.bss.', '.ramfunc.', '.noinit.'):
+            name = section[len(prefix):]
+            if section.startswith(prefix) and name not in Config.named_sections:
+                return name
+        return f'{section} ({obj})'
+
+    def parse_memory(self, lines):
+        for line in lines:
+            if line.startswith('Linker script and memory map'):
+                return
+            match = self.region_pattern.match(line)
+            if match and not match.group(1).startswith('*'):
+                name, origin, length = match.group(1), int(match.group(2), 16), int(match.group(3), 16)
+                if length and name != 'Name':
+                    self.regions.append((name, origin, length))
+
+    def parse_archives(self, lines):
+        # "Archive member included to satisfy reference by file (symbol)"
+        member = None
+        for line in lines:
+            if line.startswith('Discarded input sections') or line.startswith('Memory Configuration'):
+                return
+            if line and not line[0].isspace():
+                member = self.module(line.strip())
+            elif member and line.strip():
+                self.usage.pulled_by.setdefault(f'{member[0]}: {member[1]}', line.strip())
+                member = None
+
+    def parse_sections(self, lines):
+        regions = []
+        output_size = 0
+        input_size = 0
+        pending = None
+
+        def close_output():
+            if regions and output_size > input_size:
+                self.usage.add(regions, output_size - input_size, Config.linker, Config.linker, '')
+
+        for line in lines:
+            match = self.output_pattern.match(line)
+            if match:
+                close_output()
+                name, address, size, load = match.groups()
+                regions, output_size, input_size = [], 0, 0
+                if address:
+                    regions = self.output_regions(int(address, 16), load)
+                    output_size = int(size, 16)
+                else:
+                    pending = ('output', name)
+                continue
+            if pending and pending[0] == 'output':
+                match = re.match(r'^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)(?:\s+load address 0x([0-9a-f]+))?\s*$', line)
+                pending = None
+                if match:
+                    address, size, load = match.groups()
+                    regions = self.output_regions(int(address, 16), load)
+                    output_size = int(size, 16)
+                    continue
+            if not regions:
+                continue
+            match = self.input_pattern.match(line)
+            if match:
+                section, address, size, filename = match.groups()
+                if not address:
+                    # long section names wrap onto the next line
+                    if section.startswith('.') or section == 'COMMON':
+                        pending = ('input', section)
+                    continue
+                pending = None
+            elif pending and pending[0] == 'input':
+                match = self.wrapped_pattern.match(line)
+                pending_section = pending[1]
+                pending = None
+                if not match:
+                    continue
+                section = pending_section
+                address, size, filename = match.groups()
+            else:
+                continue
+            size = int(size, 16)
+            if not size:
+                continue
+            input_size += size
+            if section == '*fill*' or not filename:
+                self.usage.add(regions, size, Config.fill, Config.fill, '')
+                continue
+            module, obj = self.module(filename.strip())
+            self.usage.add(regions, size, module, obj, self.symbol(section, obj))
+        close_output()
+
+    def output_regions(self, address: int, load) -> list:
+        regions = []
+        vma = self.region(address)
+        if vma:
+            regions.append(vma)
+            lma = self.region(int(load, 16)) if load else None
+            if lma and lma != vma:
+                regions.append(lma)
+        return regions
+
+    def parse(self) -> Usage:
+        heading = 'Archive member included'
+        if any(line.startswith(heading) for line in self.lines):
+            self.parse_archives(self.lines[self.index(heading):])
+        self.parse_memory(self.lines[self.index('Memory Configuration'):])
+        self.parse_sections(self.lines[self.index('Linker script and memory map'):])
+        if not self.regions:
+            raise MapSizeError('No memory configuration found in map file')
+        return self.usage
+
+    def index(self, heading: str) -> int:
+        for n, line in enumerate(self.lines):
+            if line.startswith(heading):
+                return n + 1
+        raise MapSizeError(f'Map file has no "{heading}" section')
+
+
+def demangle(names: list) -> dict:
+    for tool in ('arm-none-eabi-c++filt', 'c++filt'):
+        path = shutil.which(tool)
+        if path:
+            result = subprocess.run([path], input='\n'.join(names), capture_output=True, text=True)
+            if result.returncode == 0:
+                return dict(zip(names, result.stdout.splitlines()))
+    return {}
+
+
+def region_names(usage: Usage) -> list:
+    # flash first, then RAM regions in decreasing size
+    return sorted(usage.regions, key=lambda r: (not r.startswith('FLASH'), -usage.regions[r]))
+
+
+def print_table(title: str, rows: dict, regions: list, baseline: dict = None, limit: int = 0):
+    width = min(max((len(name) for name in rows), default=10), 60)
+    names = sorted(rows, key=lambda n: -sum(rows[n].values()))
+    if limit:
+        names = names[:limit]
+    print(f'\n{title:<{width}} ' + ' '.join(f'{r:>10}' for r in regions) + ('    change' if baseline is not None else ''))
+    for name in names:
+        used = rows[name]
+        line = f'{name[:width]:<{width}} ' + ' '.join(f'{used.get(r, 0):10}' for r in regions)
+        if baseline is not None:
+            old = baseline.get(name, {})
+            delta = sum(used.values()) - sum(old.values())
+            line += f' {delta:+9}' if delta else ''
+        print(line)
+    if baseline is not None:
+        for name in sorted(set(baseline) - set(rows)):
+            print(f'{name[:width]:<{width}} ' + ' '.join(f'{0:10}' for r in regions)
+                  + f' {-sum(baseline[name].values()):+9}')
+
+
+def report(usage: Usage, baseline: dict):
+    regions = region_names(usage)
+    print_table('Module', usage.modules, regions, baseline and baseline.get('modules', {}))
+    if Config.objects:
+        print_table('Object', usage.objects, regions, baseline and baseline.get('objects', {}))
+        pulled = {name: by for name, by in usage.pulled_by.items() if name in usage.objects}
+        if pulled:
+            print('\nArchive members and the first reference to them:')
+            for name in sorted(pulled):
+                print(f'  {name:<40} {pulled[name]}')
+    if Config.symbols:
+        names = demangle(list(usage.symbols))
+        symbols = {names.get(n, n): used for n, used in usage.symbols.items()}
+        print_table('Symbol', symbols, regions, limit=Config.symbols)
+    print('\nTotal     ' + ' '.join(f'{r:>10}' for r in regions))
+    print('          ' + ' '.join(f'{usage.regions[r]:10}' for r in regions))
+
+
+def check_growth(usage: Usage, baseline: dict) -> bool:
+    threshold = Config.threshold.strip()
+    percent = threshold.endswith('%')
+    limit = float(threshold.rstrip('%'))
+    ok = True
+    print()
+    for region in region_names(usage):
+        old = baseline['regions'].get(region, 0)
+        new = usage.regions[region]
+        growth = new - old
+        allowed = old * limit / 100 if percent else limit
+        status = 'ok'
+        if growth > allowed:
+            status = f'FAIL: exceeds {threshold} threshold'
+            ok = False
+        print(f'{region:<10} {old:10} -> {new:10} {growth:+9}  {status}')
+    return ok
+
+
+def usage_help():
+    print(__doc__.strip(), file=sys.stderr)
+    sys.exit(1)
+
+
+def main():
+    args = iter(sys.argv[1:])
+    for arg in args:
+        if arg in ('--help', '-h', '-?'):
+            usage_help()
+        elif arg == '--objects':
+            Config.objects = True
+        elif arg == '--symbols':
+            Config.symbols = int(next(args, '') or usage_help())
+        elif arg == '--baseline':
+            Config.baseline = Path(next(args, '') or usage_help())
+        elif arg == '--threshold':
+            Config.threshold = next(args, '') or usage_help()
+        elif arg == '--save':
+            Config.save = Path(next(args, '') or usage_help())
+        elif arg == '--bootstrap':
+            Config.bootstrap = True
+        elif arg.startswith('-'):
+            usage_help()
+        else:
+            Config.map_file = Path(arg)
+
+    usage = MapFile(Config.map_file).parse()
+
+    if Config.save:
+        Config.save.write_text(json.dumps(usage.to_json(), indent=2, sort_keys=True) + '\n')
+        print(f'Saved size baseline to {Config.save}')
+        return 0
+
+    baseline = None
+    if Config.baseline:
+        if Config.baseline.exists():
+            baseline = json.loads(Config.baseline.read_text())
+        elif Config.bootstrap:
+            print(f'No size baseline {Config.baseline}: build the size-baseline target to create one')
+        else:
+            raise MapSizeError(f'No size baseline {Config.baseline}: build the size-baseline '
+                               f'target to create one (or use --bootstrap)')
+    report(usage, baseline)
+    if baseline and not check_growth(usage, baseline):
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except MapSizeError as ex:
+        print(ex, file=sys.stderr)
+        exit(1)
+    except ValueError as ex:
+        print(f'Invalid option value: {ex}', file=sys.stderr)
+        exit(1)
+    except KeyboardInterrupt:
+        print('\nInterrupted', file=sys.stderr)
+        exit(1)
@@ -0,0 +1,217 @@
+#!/usr/bin/python3
+"""
+Usage: qemu_bench.py [--help] [options] [elf-image]
+Run the benchmark firmware (built from `benchmarks/`) headless under the
+xPack QEMU emulator and collect its semihosted results as JSON.
+
+The image defaults to `build/debug/benchmarks/Benchmarks.elf`.
+
+Options:
+    --output file      -- write the JSON results to file
+    --icount N         -- QEMU instruction counting: each instruction
+                          advances virtual time by 2^N ns (default 4)
+    --timeout S        -- stop QEMU after S seconds (default 300)
+    --qemu path        -- QEMU executable (default: search the xPack
+                          install in the current, home and /opt folders)
+    --verbose          -- echo all firmware output
+
+The firmware times each benchmark with the DWT cycle counter on real
+hardware, or with SysTick under QEMU (which has no DWT). SysTick ticks
+are converted to instruction counts using the firmware's calibration
+loop; as QEMU executes one instruction per virtual clock step, cycle
+figures under QEMU are estimates equal to the instruction count. On
+hardware only cycles are reported.
+
+The exit status is 0 only if every benchmark ran and passed.
+"""
+import json
+import os
+import re
+import subprocess
+import sys
+from pathlib import Path
+
+
+class BenchError(Exception):
+    pass
+
+
+class Config:
+    image = Path('build/debug/benchmarks/Benchmarks.elf')
+    output = None
+    icount = 4
+    timeout = 300
+    qemu = None
+    verbose = False
+    qemu_path = 'xpack-qemu-arm-2.8.0-9/bin/qemu-system-gnuarmeclipse'
+    qemu_dirs = ['.', os.environ.get('HOME', '.'), '/opt']
+    board = 'Feabhas-WMS'
+    line_pattern = re.compile(r'^BENCH(-CAL|-END)? (\{.*\})\s*$')
+
+
+def find_qemu() -> Path:
+    if Config.qemu:
+        return Path(Config.qemu)
+    for folder in Config.qemu_dirs:
+        qemu = Path(folder) / Config.qemu_path
+        if os.access(qemu, os.X_OK):
+            return qemu
+    raise BenchError(f'Cannot find QEMU in standard locations: {" ".join(Config.qemu_dirs)}')
+
+
+def run_qemu(qemu: Path, image: Path) -> tuple:
+    command = [
+        str(qemu), '--board', Config.board, '-d', 'unimp,guest_errors',
+        '--semihosting-config', 'enable=on,target=native',
+        '-nographic', '-icount', f'shift={Config.icount}',
+        '--image', str(image),
+    ]
+    try:
+        result = subprocess.run(command, stdout=subprocess.PIPE, stderr=subprocess.STDOUT,
+                                stdin=subprocess.DEVNULL, timeout=Config.timeout,
+                                universal_newlines=True, errors='replace')
+    except subprocess.TimeoutExpired:
+        raise BenchError(f'QEMU did not exit within {Config.timeout} seconds')
+    return result.returncode, result.stdout.splitlines()
+
+
+def parse(lines: list) -> tuple:
+    calibration, results, end = None, [], None
+    for line in lines:
+        match = Config.line_pattern.match(line)
+        if not match:
+            if Config.verbose:
+                print(line)
+            continue
+        try:
+            record = json.loads(match.group(2))
+        except ValueError:
+            raise BenchError(f'Malformed benchmark output: {line}')
+        if match.group(1) == '-CAL':
+            calibration = record
+        elif match.group(1) == '-END':
+            end = record
+        else:
+            results.append(record)
+    if calibration is None:
+        raise BenchError('No benchmark output: did the firmware start?')
+    return calibration, results, end
+
+
+def per_iteration(value, iterations: int):
+    if value is None or not iterations:
+        return None
+    return round(value / iterations, 1)
+
+
+def analyse(calibration: dict, results: list) -> list:
+    counter = calibration['counter']
+    ticks_per_instruction = None
+    if counter == 'systick' and calibration['instructions']:
+        ticks_per_instruction = calibration['ticks'] / calibration['instructions']
+        if ticks_per_instruction == 0:
+            raise BenchError('SysTick did not advance during calibration')
+
+    benchmarks = []
+    for result in results:
+        ticks, iterations = result['ticks'], result['iterations']
+        if counter == 'dwt':
+            cycles, instructions = ticks, None
+        else:
+            instructions = round(ticks / ticks_per_instruction)
+            cycles = instructions
+        benchmarks.append({
+            'name': result['name'],
+            'iterations': iterations,
+            'ticks': ticks,
+            'instructions': instructions,
+            'cycles': cycles,
+            'instructions_per_iteration': per_iteration(instructions, iterations),
+            'cycles_per_iteration': per_iteration(cycles, iterations),
+            'overflow': result.get('overflow', False),
+            'pass': result['pass'],
+        })
+    return benchmarks
+
+
+def report(counter: str, benchmarks: list):
+    cycles = 'cycles' if counter == 'dwt' else 'cycles (est)'
+    width = max([len('Benchmark')] + [len(b['name']) for b in benchmarks])
+    print(f'{"Benchmark":<{width}} {"iterations":>10} {"instructions/iter":>18} '
+          f'{cycles + "/iter":>18}  result')
+    for b in benchmarks:
+        instructions = b['instructions_per_iteration']
+        instructions = '-' if instructions is None else f'{instructions:.1f}'
+        result = 'pass' if b['pass'] else ('FAIL (overflow)' if b['overflow'] else 'FAIL')
+        print(f'{b["name"]:<{width}} {b["iterations"]:>10} {instructions:>18} '
+              f'{b["cycles_per_iteration"]:>18.1f}  {result}')
+
+
+def usage():
+    print(__doc__.strip(), file=sys.stderr)
+    sys.exit(1)
+
+
+def main():
+    args = iter(sys.argv[1:])
+    for arg in args:
+        if arg in ('--help', '-h', '-?'):
+            usage()
+        elif arg in ('--verbose', '-v'):
+            Config.verbose = True
+        elif arg == '--output':
+            Config.output = Path(next(args, '') or usage())
+        elif arg == '--icount':
+            Config.icount = int(next(args, '') or usage())
+        elif arg == '--timeout':
+            Config.timeout = int(next(args, '') or usage())
+        elif arg == '--qemu':
+            Config.qemu = next(args, '') or usage()
+        elif arg.startswith('-'):
+            usage()
+        else:
+            Config.image = Path(arg)
+
+    if not Config.image.is_file():
+        raise BenchError(f'Missing image file: {Config.image}')
+
+    qemu = find_qemu()
+    status, lines = run_qemu(qemu, Config.image)
+    calibration, results, end = parse(lines)
+    benchmarks = analyse(calibration, results)
+
+    completed = end is not None and end['benchmarks'] == len(benchmarks)
+    passed = completed and all(b['pass'] for b in benchmarks)
+
+    report(calibration['counter'], benchmarks)
+    if not completed:
+        print(f'Benchmark firmware stopped after {len(benchmarks)} results '
+              f'(QEMU exit status {status})', file=sys.stderr)
+
+    if Config.output:
+        document = {
+            'firmware': str(Config.image),
+            'qemu': {'path': str(qemu), 'icount_shift': Config.icount, 'exit_status': status},
+            'calibration': calibration,
+            'benchmarks': benchmarks,
+            'completed': completed,
+            'pass': passed,
+        }
+        Config.output.write_text(json.dumps(document, indent=2) + '\n')
+        print(f'Results written to {Config.output}')
+
+    return 0 if passed else 1
+
+
+if __name__ == '__main__':
+    try:
+        sys.exit(main())
+    except BenchError as ex:
+        print(ex, file=sys.stderr)
+        exit(1)
+    except ValueError as ex:
+        print(f'Invalid option value: {ex}', file=sys.stderr)
+        exit(1)
+    except KeyboardInterrupt:
+        print('\nInterrupted', file=sys.stderr)
+        exit(1)
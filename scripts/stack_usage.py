@@ -0,0 +1,248 @@
+#!/usr/bin/python3
+"""
+Usage: stack_usage.py [--help] [--entry name]... [--context bytes] [build-dir]
+Report the worst-case stack depth of every interrupt handler, main()
+and RTOS task entry point in the application.
+
+The compiler writes a `.su` (stack usage) file and a `.ci` (call graph)
+file alongside each object file when invoked with `-fstack-usage` and
+`-fcallgraph-info=su,da`. This script reads all of these files under
+`build-dir` (default `build/debug`), combines the frame sizes with the
+call graph and finds the deepest call chain from each entry point.
+
+Entry points are functions ending in `_Handler` or `IRQHandler`, `main`,
+any name given with `--entry`, and every application function (from
+`src/`) that is never called directly: these are task functions and
+callbacks passed by address.
+
+A task stack must also hold the context saved by the RTOS on a task
+switch (`--context`, default 64 bytes for the Cortex-M4 soft float port).
+The suggested `OS_STACK_*` size includes this.
+
+Results are marked:
+    +  a frame in the chain has dynamic size (alloca/VLA)
+    ?  a callee has no stack information (library code or assembler)
+    *  the chain contains an indirect call (function pointer or virtual)
+    R  the chain is recursive so the depth is unbounded
+"""
+import re
+import sys
+from pathlib import Path
+
+
+class StackUsageError(Exception):
+    pass
+
+
+class Config:
+    build_dir = Path('build/debug')
+    app_dir = 'Application.dir'
+    context = 64
+    isr_pattern = re.compile(r'(_Handler|IRQHandler)$')
+    buckets = [
+        ('OS_STACK_TINY', 256),
+        ('OS_STACK_SMALL', 512),
+        ('OS_STACK_NORMAL', 1024),
+        ('OS_STACK_LARGE', 2048),
+        ('OS_STACK_HUGE', 4096),
+    ]
+
+
+class Function:
+    def __init__(self, name: str, label: str = ''):
+        self.name = name
+        self.label = label or name
+        self.location = ''
+        self.frame = None
+        self.dynamic = False
+        self.application = False
+        self.callees = set()
+
+
+class CallGraph:
+    node_pattern = re.compile(r'node:\s*{\s*title:\s*"([^"]*)"\s*label:\s*"([^"]*)"')
+    edge_pattern = re.compile(r'edge:\s*{\s*sourcename:\s*"([^"]*)"\s*targetname:\s*"([^"]*)"')
+    bytes_pattern = re.compile(r'^(\d+) bytes \((\w+)')
+    indirect = '__indirect_call'
+
+    def __init__(self):
+        self.functions = {}
+        self.called = set()
+
+    def function(self, name: str, label: str = '') -> Function:
+        fn = self.functions.get(name)
+        if not fn:
+            fn = self.functions[name] = Function(name, label)
+        elif label and fn.label == fn.name:
+            fn.label = label
+        return fn
+
+    def set_frame(self, fn: Function, size: int, qualifier: str, application: bool):
+        # static functions with the same name in different files share
+        # a node so keep the largest frame
+        if fn.frame is None or size > fn.frame:
+            fn.frame = size
+        fn.dynamic |= qualifier != 'static'
+        fn.application |= application
+
+    def read_ci(self, path: Path, application: bool):
+        text = path.read_text(errors='replace')
+        for title, label in self.node_pattern.findall(text):
+            lines = label.split('\\n')
+            fn = self.function(title, lines[0])
+            for line in lines[1:]:
+                match = self.bytes_pattern.match(line)
+                if match:
+                    fn.location = lines[1]
+                    self.set_frame(fn, int(match.group(1)), match.group(2), application)
+        for source, target in self.edge_pattern.findall(text):
+            self.function(source).callees.add(target)
+            self.called.add(target)
+
+    def read_su(self, path: Path, application: bool):
+        # only used for objects compiled without a call graph file
+        for line in path.read_text(errors='replace').splitlines():
+            fields = line.split('\t')
+            if len(fields) < 3:
+                continue
+            location, _, name = fields[0].rpartition(':')
+            fn = self.function(name)
+            fn.location = fn.location or location
+            self.set_frame(fn, int(fields[1]), fields[2].split(',')[0], application)
+
+    def load(self, build_dir: Path):
+        found = False
+        for path in sorted(build_dir.rglob('*.su')):
+            application = Config.app_dir in path.parts
+            ci = path.with_suffix('.ci')
+            if ci.exists():
+                self.read_ci(ci, application)
+            else:
+                self.read_su(path, application)
+            found = True
+        if not found:
+            raise StackUsageError(f'No .su files found in {build_dir}: '
+                                  f'configure with -DSTACK_USAGE=ON first')
+
+
+class Depth:
+    def __init__(self, graph: CallGraph):
+        self.graph = graph
+        self.cache = {}
+
+    def __call__(self, name: str, active: tuple = ()):
+        """Return (bytes, flags, path) for the deepest chain from name"""
+        if name in active:
+            return 0, {'R'}, [name]
+        if name in self.cache:
+            return self.cache[name]
+        if name == CallGraph.indirect:
+            return 0, {'*'}, []
+        fn = self.graph.functions.get(name)
+        if fn is None or fn.frame is None:
+            return 0, {'?'}, [name]
+        deepest, flags, chain = 0, set(), []
+        for callee in sorted(fn.callees):
+            size, callee_flags, callee_chain = self(callee, active + (name,))
+            flags |= callee_flags
+            if size > deepest or not chain:
+                deepest, chain = size, callee_chain
+        if fn.dynamic:
+            flags.add('+')
+        result = fn.frame + deepest, flags, [name] + chain
+        if 'R' not in flags:
+            self.cache[name] = result
+        return result
+
+
+def suggest_bucket(size: int) -> str:
+    for name, bucket in Config.buckets:
+        if size <= bucket:
+            return name
+    return f'{size} bytes'
+
+
+def find_entries(graph: CallGraph, extra: list) -> tuple:
+    defined = {name: fn for name, fn in graph.functions.items() if fn.frame is not None}
+    isrs = sorted(name for name in defined if Config.isr_pattern.search(name))
+    tasks = sorted(name for name, fn in defined.items()
+                   if fn.application and name not in graph.called
+                   and name != 'main' and name not in isrs)
+    tasks += [name for name in extra if name not in tasks]
+    return isrs, ['main'] if 'main' in defined else [], tasks
+
+
+def report(graph: CallGraph, verbose: bool):
+    depth = Depth(graph)
+    isrs, mains, tasks = find_entries(graph, Config.entries)
+    width = max((len(graph.function(n).label) for n in isrs + mains + tasks), default=10)
+    width = min(width, 48)
+
+    def show(title: str, names: list, context: int):
+        if not names:
+            return
+        print(f'\n{title}')
+        for name in names:
+            size, flags, chain = depth(name)
+            size += context
+            label = graph.function(name).label[:width]
+            marks = ''.join(sorted(flags))
+            bucket = f'  {suggest_bucket(size)}' if context else ''
+            print(f'  {label:<{width}} {size:6} {marks:<4}{bucket}')
+            if verbose:
+                for step in chain:
+                    fn = graph.functions.get(step)
+                    frame = fn.frame if fn and fn.frame is not None else '?'
+                    label = fn.label if fn else step
+                    print(f'      {frame:>6}  {label}')
+
+    print('Worst case stack depth (bytes)')
+    show('Interrupt handlers (main stack):', isrs, 0)
+    show('Main (main stack):', mains, 0)
+    show(f'Tasks (including {Config.context} byte context):', tasks, Config.context)
+    deepest_isr = max((depth(n)[0] for n in isrs), default=0)
+    print(f'\nThe main stack must also hold {deepest_isr} bytes for the '
+          f'deepest interrupt handler, plus the hardware frame for each '
+          f'nested priority level.')
+
+
+def usage():
+    print(__doc__.strip(), file=sys.stderr)
+    sys.exit(1)
+
+
+def main():
+    Config.entries = []
+    verbose = False
+    args = iter(sys.argv[1:])
+    for arg in args:
+        if arg in ('--help', '-h', '-?'):
+            usage()
+        elif arg in ('--verbose', '-v'):
+            verbose = True
+        elif arg == '--entry':
+            Config.entries.append(next(args, '') or usage())
+        elif arg == '--context':
+            Config.context = int(next(args, '') or usage())
+        elif arg.startswith('-'):
+            usage()
+        else:
+            Config.build_dir = Path(arg)
+
+    graph = CallGraph()
+    graph.load(Config.build_dir)
+    report(graph, verbose)
+
+
+if __name__ == '__main__':
+    try:
+        main()
+    except StackUsageError as ex:
+        print(ex, file=sys.stderr)
+        exit(1)
+    except ValueError as ex:
+        print(f'Invalid option value: {ex}', file=sys.stderr)
+        exit(1)
+    except KeyboardInterrupt:
+        print('\nInterrupted', file=sys.stderr)
+        exit(1)
@@ -0,0 +1,93 @@
+// cycle_counter.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#ifndef CYCLE_COUNTER_H_
+#define CYCLE_COUNTER_H_
+
+#include "cmsis_device.h"
+
+// ----------------------------------------------------------------------------
+
+// Access to the Cortex-M4 DWT cycle and event counters.
+//
+// CYCCNT is a free running 32-bit count of core clock cycles. The event
+// counters (CPI, exception, sleep, LSU and folded instructions) are only
+// 8 bits wide, so instruction counts derived from them are only accurate
+// over short intervals (fewer than 256 stall cycles of each kind).
+//
+// The counters are not implemented by QEMU; cycle_counter_enable()
+// returns 0 if the cycle counter is not present or does not run.
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  typedef struct
+  {
+    uint32_t cycles;
+    uint32_t cpi;
+    uint32_t exc;
+    uint32_t sleep;
+    uint32_t lsu;
+    uint32_t fold;
+  } cycle_counter_events;
+
+  static inline int
+  cycle_counter_enable (void)
+  {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    if ((DWT->CTRL & DWT_CTRL_NOCYCCNT_Msk) != 0)
+      {
+        return 0;
+      }
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk | DWT_CTRL_CPIEVTENA_Msk
+        | DWT_CTRL_EXCEVTENA_Msk | DWT_CTRL_SLEEPEVTENA_Msk
+        | DWT_CTRL_LSUEVTENA_Msk | DWT_CTRL_FOLDEVTENA_Msk;
+
+    uint32_t start = DWT->CYCCNT;
+    __NOP ();
+    __NOP ();
+    return DWT->CYCCNT != start;
+  }
+
+  static inline uint32_t
+  cycle_counter_read (void)
+  {
+    return DWT->CYCCNT;
+  }
+
+  static inline void
+  cycle_counter_snapshot (cycle_counter_events* events)
+  {
+    events->cycles = DWT->CYCCNT;
+    events->cpi = DWT->CPICNT;
+    events->exc = DWT->EXCCNT;
+    events->sleep = DWT->SLEEPCNT;
+    events->lsu = DWT->LSUCNT;
+    events->fold = DWT->FOLDCNT;
+  }
+
+  // Instructions executed between two snapshots:
+  // cycles - CPI - exception - sleep - LSU stalls + folded instructions
+  static inline uint32_t
+  cycle_counter_instructions (const cycle_counter_events* before,
+                              const cycle_counter_events* after)
+  {
+    uint32_t cycles = after->cycles - before->cycles;
+    uint32_t stalls = ((after->cpi - before->cpi) & 0xFFu)
+        + ((after->exc - before->exc) & 0xFFu)
+        + ((after->sleep - before->sleep) & 0xFFu)
+        + ((after->lsu - before->lsu) & 0xFFu);
+    uint32_t folded = (after->fold - before->fold) & 0xFFu;
+    return cycles - stalls + folded;
+  }
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // CYCLE_COUNTER_H_
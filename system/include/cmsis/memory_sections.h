@@ -0,0 +1,45 @@
+// memory_sections.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#ifndef MEMORY_SECTIONS_H_
+#define MEMORY_SECTIONS_H_
+
+// ----------------------------------------------------------------------------
+
+// Placement attributes for the STM32F4 64K core-coupled memory (CCMRAM).
+//
+// CCMRAM is on the D-bus only: it has zero wait states and does not
+// contend with DMA for the SRAM bus matrix, but it cannot be accessed by
+// DMA or execute code. Use it for stacks, RTOS structures and buffers
+// only touched by the CPU (ISR-only buffers); keep DMA buffers in SRAM.
+//
+//   static uint32_t rx_buffer[64] FEABHAS_CCM_BSS;
+//   static int table[4] FEABHAS_CCM_DATA = { 1, 2, 3, 4 };
+//
+// The sections are initialised by _start() from the region arrays in
+// ldscripts/sections.ld:
+// - FEABHAS_CCM_DATA    initialised data, copied from flash
+// - FEABHAS_CCM_BSS     zero initialised data
+// - FEABHAS_CCM_NOINIT  uninitialised data (not touched at startup)
+
+#define FEABHAS_CCM_DATA   __attribute__((section(".data.CCMRAM")))
+#define FEABHAS_CCM_BSS    __attribute__((section(".bss.CCMRAM")))
+#define FEABHAS_CCM_NOINIT __attribute__((section(".noinit.CCMRAM")))
+
+// Placement of functions in SRAM.
+//
+// FEABHAS_RAMFUNC places a function in the .ramfunc section, copied from
+// flash to SRAM by _start() before main(). Use it for interrupt handlers
+// and other hot paths that need deterministic fetch latency:
+//
+//   extern "C" void USART3_IRQHandler() FEABHAS_RAMFUNC;
+//
+// The function is never inlined and callers use a long call, as SRAM is
+// out of branch range of flash.
+
+#define FEABHAS_RAMFUNC    __attribute__((section(".ramfunc"), long_call, noinline))
+
+// ----------------------------------------------------------------------------
+
+#endif // MEMORY_SECTIONS_H_
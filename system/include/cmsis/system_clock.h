@@ -0,0 +1,82 @@
+// system_clock.h
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#ifndef SYSTEM_CLOCK_H_
+#define SYSTEM_CLOCK_H_
+
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+
+// Clock tree configuration for the STM32F407.
+//
+// After reset the core runs from the 16MHz HSI. SystemClock_Config()
+// switches SYSCLK to the main PLL driven from the 8MHz HSE crystal:
+//
+//   HSE 8MHz / PLLM 8 * PLLN 336 = VCO 336MHz
+//   SYSCLK = VCO / PLLP 2 = 168MHz       HCLK  = SYSCLK / 1 = 168MHz
+//   USB/SDIO = VCO / PLLQ 7 = 48MHz      PCLK1 = HCLK / 4   = 42MHz
+//                                        PCLK2 = HCLK / 2   = 84MHz
+//
+// If the HSE fails to start the PLL is driven from the HSI (PLLM 16)
+// giving the same frequencies. If the PLL fails to lock the core is
+// left running from the HSI.
+//
+// SystemClock_Config() is called from __initialize_hardware_early()
+// when OS_USE_SYSCLK_PLL is defined. Drivers must derive baud rates and
+// timer periods from the bus clock accessors below rather than assume
+// a fixed frequency.
+//
+// SystemFlash_Config() sets the flash wait states for a given HCLK and
+// supply voltage range and enables the ART accelerator (prefetch buffer,
+// instruction and data caches). It is called from
+// __initialize_hardware_early() for the reset clock and again by
+// SystemClock_Config() before switching to the PLL. The supply range is
+// taken from OS_FLASH_VOLTAGE_RANGE (default SystemVoltage_2V7_3V6).
+
+#if defined(__cplusplus)
+extern "C"
+{
+#endif
+
+  // Board supply voltage range (RM0090 table 10). Each range sets the
+  // maximum HCLK per flash wait state; prefetch is unavailable below 2.1V.
+  typedef enum
+  {
+    SystemVoltage_2V7_3V6,      // 30MHz per wait state
+    SystemVoltage_2V4_2V7,      // 24MHz per wait state
+    SystemVoltage_2V1_2V4,      // 22MHz per wait state
+    SystemVoltage_1V8_2V1       // 20MHz per wait state, no prefetch
+  } SystemVoltage_Range;
+
+  // The board's range, used by both the reset-clock and the PLL flash
+  // configuration; override with -DOS_FLASH_VOLTAGE_RANGE=...
+#if !defined(OS_FLASH_VOLTAGE_RANGE)
+#define OS_FLASH_VOLTAGE_RANGE SystemVoltage_2V7_3V6
+#endif
+
+  void
+  SystemFlash_Config (uint32_t hclk, SystemVoltage_Range range);
+
+  void
+  SystemClock_Config (void);
+
+  // Bus clock frequencies in Hz, derived from SystemCoreClock (HCLK)
+  // and the current RCC prescaler settings.
+  uint32_t
+  SystemClock_HCLK (void);
+
+  uint32_t
+  SystemClock_PCLK1 (void);
+
+  uint32_t
+  SystemClock_PCLK2 (void);
+
+#if defined(__cplusplus)
+}
+#endif
+
+// ----------------------------------------------------------------------------
+
+#endif // SYSTEM_CLOCK_H_
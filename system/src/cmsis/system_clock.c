@@ -0,0 +1,155 @@
+// system_clock.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+#include "stm32f4xx.h"
+#include "system_clock.h"
+
+// ----------------------------------------------------------------------------
+
+// Number of polling iterations to wait for the HSE and PLL ready flags.
+#if !defined(OS_CLOCK_STARTUP_TIMEOUT)
+#define OS_CLOCK_STARTUP_TIMEOUT (0x5000u)
+#endif
+
+#define PLL_M_HSE (8u)          // 8MHz HSE  -> 1MHz VCO input
+#define PLL_M_HSI (16u)         // 16MHz HSI -> 1MHz VCO input
+#define PLL_N     (336u)        // VCO output 336MHz
+#define PLL_P     (2u)          // SYSCLK 168MHz
+#define PLL_Q     (7u)          // USB OTG FS, SDIO, RNG 48MHz
+
+// HCLK after switching to the PLL; flash wait states are derived from this.
+#define SYSCLK_PLL_HZ (168000000u)
+
+// APB prescaler encoding: 0xx = /1, 100 = /2, 101 = /4, 110 = /8, 111 = /16
+static const uint8_t APBPrescTable[8] = { 0, 0, 0, 0, 1, 2, 3, 4 };
+
+// ----------------------------------------------------------------------------
+
+static int
+wait_for_flag (volatile uint32_t* reg, uint32_t flag)
+{
+  for (uint32_t count = 0; count < OS_CLOCK_STARTUP_TIMEOUT; ++count)
+    {
+      if ((*reg & flag) != 0)
+        {
+          return 1;
+        }
+    }
+  return 0;
+}
+
+// ----------------------------------------------------------------------------
+
+void
+SystemFlash_Config (uint32_t hclk, SystemVoltage_Range range)
+{
+  static const uint32_t hz_per_wait_state[] =
+    { 30000000u, 24000000u, 22000000u, 20000000u };
+
+  uint32_t latency = (hclk - 1u) / hz_per_wait_state[range];
+  if (latency > FLASH_ACR_LATENCY_7WS)
+    {
+      latency = FLASH_ACR_LATENCY_7WS;
+    }
+
+  // The caches may only be reset while they are disabled.
+  uint32_t acr = FLASH->ACR;
+  acr &= ~(FLASH_ACR_ICEN | FLASH_ACR_DCEN);
+  FLASH->ACR = acr;
+  FLASH->ACR = acr | FLASH_ACR_ICRST | FLASH_ACR_DCRST;
+  FLASH->ACR = acr;
+
+  acr = latency | FLASH_ACR_ICEN | FLASH_ACR_DCEN;
+  if (range != SystemVoltage_1V8_2V1)
+    {
+      acr |= FLASH_ACR_PRFTEN;
+    }
+  FLASH->ACR = acr;
+
+  // The new latency must be in effect before the clock is raised.
+  while ((FLASH->ACR & FLASH_ACR_LATENCY) != latency)
+    ;
+}
+
+// ----------------------------------------------------------------------------
+
+void
+SystemClock_Config (void)
+{
+  // Regulator voltage scale 1 is required for HCLK above 144MHz.
+  uint32_t apb1enr = RCC->APB1ENR;
+  apb1enr |= RCC_APB1ENR_PWREN;
+  RCC->APB1ENR = apb1enr;
+
+  uint32_t pwr_cr = PWR->CR;
+  pwr_cr |= PWR_CR_VOS_0;
+  PWR->CR = pwr_cr;
+
+  uint32_t cr = RCC->CR;
+  cr |= RCC_CR_HSEON;
+  RCC->CR = cr;
+
+  uint32_t pllcfgr = (PLL_N << 6) | (((PLL_P >> 1) - 1u) << 16) | (PLL_Q << 24);
+  if (wait_for_flag (&RCC->CR, RCC_CR_HSERDY))
+    {
+      pllcfgr |= RCC_PLLCFGR_PLLSRC_HSE | PLL_M_HSE;
+    }
+  else
+    {
+      cr = RCC->CR;
+      cr &= ~RCC_CR_HSEON;
+      RCC->CR = cr;
+      pllcfgr |= PLL_M_HSI;
+    }
+  RCC->PLLCFGR = pllcfgr;
+
+  cr = RCC->CR;
+  cr |= RCC_CR_PLLON;
+  RCC->CR = cr;
+
+  if (!wait_for_flag (&RCC->CR, RCC_CR_PLLRDY))
+    {
+      // Stay on the HSI rather than hang.
+      return;
+    }
+
+  SystemFlash_Config (SYSCLK_PLL_HZ, OS_FLASH_VOLTAGE_RANGE);
+
+  uint32_t cfgr = RCC->CFGR;
+  cfgr &= ~(RCC_CFGR_HPRE | RCC_CFGR_PPRE1 | RCC_CFGR_PPRE2);
+  cfgr |= RCC_CFGR_HPRE_DIV1 | RCC_CFGR_PPRE1_DIV4 | RCC_CFGR_PPRE2_DIV2;
+  RCC->CFGR = cfgr;
+
+  cfgr = RCC->CFGR;
+  cfgr &= ~RCC_CFGR_SW;
+  cfgr |= RCC_CFGR_SW_PLL;
+  RCC->CFGR = cfgr;
+
+  while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL)
+    ;
+
+  SystemCoreClockUpdate ();
+}
+
+// ----------------------------------------------------------------------------
+
+uint32_t
+SystemClock_HCLK (void)
+{
+  return SystemCoreClock;
+}
+
+uint32_t
+SystemClock_PCLK1 (void)
+{
+  return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE1) >> 10];
+}
+
+uint32_t
+SystemClock_PCLK2 (void)
+{
+  return SystemCoreClock >> APBPrescTable[(RCC->CFGR & RCC_CFGR_PPRE2) >> 13];
+}
+
+// ----------------------------------------------------------------------------
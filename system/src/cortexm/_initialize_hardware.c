@@ -6,6 +6,11 @@
 // ----------------------------------------------------------------------------
 
 #include "cmsis_device.h"
+#include "system_clock.h"
+
+#if !defined(HSI_VALUE)
+#define HSI_VALUE (16000000u)
+#endif
 
 // ----------------------------------------------------------------------------
 
@@ -19,6 +24,19 @@ __initialize_hardware_early(void);
 void
 __initialize_hardware(void);
 
+#if defined(OS_INCLUDE_STARTUP_BENCHMARK)
+void
+__startup_benchmark(void);
+#endif
+
+// The USART writer is part of _write.c, which is not built
+// for semihosted or freestanding applications
+#if defined(OS_USE_WRITE_USART) && !defined(OS_USE_SEMIHOSTING) && !(__STDC_HOSTED__ == 0)
+#define OS_INITIALIZE_WRITE_USART
+void
+_write_usart_initialize(void);
+#endif
+
 // ----------------------------------------------------------------------------
 
 // This is the early hardware initialisation routine, it can be
@@ -43,6 +61,16 @@ __initialize_hardware_early(void)
   SCB->VTOR = (uint32_t)(&__vectors_start);
 #endif
 
+  // Enable the flash prefetch buffer and instruction/data caches for
+  // the reset (HSI) clock; SystemClock_Config() updates the wait states.
+  SystemFlash_Config(HSI_VALUE, OS_FLASH_VOLTAGE_RANGE);
+
+#if defined(OS_USE_SYSCLK_PLL)
+  // Switch to the 168MHz PLL clock so the data and bss initialisation,
+  // and everything after it, run at full speed.
+  SystemClock_Config();
+#endif
+
   // The current version of SystemInit() leaves the value of the clock
   // in a RAM variable (SystemCoreClock), which will be cleared shortly,
   // so it needs to be recomputed after the RAM initialisations
@@ -86,6 +114,18 @@ __initialize_hardware(void)
   // Call the CSMSIS system clock routine to store the clock frequency
   // in the SystemCoreClock global RAM location.
   SystemCoreClockUpdate();
+
+#if defined(OS_INITIALIZE_WRITE_USART)
+  // stdout / stderr on USART3, set up before any constructor
+  // or task can write to them.
+  _write_usart_initialize();
+#endif
+
+#if defined(OS_INCLUDE_STARTUP_BENCHMARK)
+  // Report the cycle cost of running from flash with and
+  // without the ART accelerator.
+  __startup_benchmark();
+#endif
 }
 
 // ----------------------------------------------------------------------------
@@ -0,0 +1,132 @@
+// startup_benchmark.c
+// See project README.md for disclaimer and additional information.
+// Feabhas Ltd
+
+// ----------------------------------------------------------------------------
+
+// Measures the effect of the flash ART accelerator at startup.
+//
+// A fixed workload reading a constant table from flash is run with the
+// prefetch buffer and caches disabled, then enabled, keeping the wait
+// states required for the current clock. Cycles and instructions are
+// taken from the DWT counters in short chunks so the 8-bit event counters
+// do not wrap. Results are reported with trace_printf().
+//
+// Enabled by defining OS_INCLUDE_STARTUP_BENCHMARK; called from
+// __initialize_hardware().
+
+#if defined(OS_INCLUDE_STARTUP_BENCHMARK)
+
+#include "cmsis_device.h"
+#include "cycle_counter.h"
+#include "diag/Trace.h"
+
+// ----------------------------------------------------------------------------
+
+#define CHUNK_SIZE (4u)
+#define TABLE_SIZE (512u)
+
+void
+__startup_benchmark (void);
+
+// Placed in flash so the data cache is exercised as well as the
+// instruction path.
+static const uint32_t table[TABLE_SIZE] =
+  {
+#define ROW(n) (n) * 0x9E3779B9u, (n) * 0x7F4A7C15u, (n) * 0x85EBCA6Bu, (n) * 0xC2B2AE35u
+#define ROW4(n) ROW(n), ROW(n + 1), ROW(n + 2), ROW(n + 3)
+#define ROW16(n) ROW4(n), ROW4(n + 4), ROW4(n + 8), ROW4(n + 12)
+#define ROW64(n) ROW16(n), ROW16(n + 16), ROW16(n + 32), ROW16(n + 48)
+    ROW64(0), ROW64(64)
+#undef ROW64
+#undef ROW16
+#undef ROW4
+#undef ROW
+  };
+
+static volatile uint32_t result;
+
+static uint32_t __attribute__((noinline))
+workload_chunk (const uint32_t* p, uint32_t seed)
+{
+  for (unsigned int i = 0; i < CHUNK_SIZE; ++i)
+    {
+      seed ^= p[i];
+      seed = (seed << 5) + seed + (seed >> 3);
+      if ((seed & 1u) != 0)
+        {
+          seed ^= 0xA5A5A5A5u;
+        }
+    }
+  return seed;
+}
+
+static void
+set_acceleration (uint32_t enable)
+{
+  uint32_t acr = FLASH->ACR & FLASH_ACR_LATENCY;
+
+  // Reset the caches (only permitted while disabled) so each run
+  // starts cold.
+  FLASH->ACR = acr;
+  FLASH->ACR = acr | FLASH_ACR_ICRST | FLASH_ACR_DCRST;
+  FLASH->ACR = acr | enable;
+}
+
+static void
+run (const char* name, uint32_t enable)
+{
+  cycle_counter_events before;
+  cycle_counter_events after;
+  uint32_t cycles = 0;
+  uint32_t instructions = 0;
+  uint32_t seed = 0;
+
+  set_acceleration (enable);
+
+  for (unsigned int i = 0; i < TABLE_SIZE; i += CHUNK_SIZE)
+    {
+      cycle_counter_snapshot (&before);
+      seed = workload_chunk (&table[i], seed);
+      cycle_counter_snapshot (&after);
+
+      cycles += after.cycles - before.cycles;
+      instructions += cycle_counter_instructions (&before, &after);
+    }
+  result = seed;
+
+  uint32_t ipc_x100 = (cycles != 0) ? (instructions * 100u) / cycles : 0;
+  trace_printf ("%s: %u cycles, %u instructions, IPC %u.%02u\n", name,
+                (unsigned int) cycles, (unsigned int) instructions,
+                (unsigned int) (ipc_x100 / 100u),
+                (unsigned int) (ipc_x100 % 100u));
+}
+
+// ----------------------------------------------------------------------------
+
+void
+__startup_benchmark (void)
+{
+  if (!cycle_counter_enable ())
+    {
+      trace_puts ("startup benchmark: DWT cycle counter not available");
+      return;
+    }
+
+  uint32_t saved = FLASH->ACR;
+
+  trace_printf ("startup benchmark: HCLK %u Hz, %u wait states\n",
+                (unsigned int) SystemCoreClock,
+                (unsigned int) (saved & FLASH_ACR_LATENCY));
+
+  run ("flash ART disabled",  0);
+  run ("flash ART enabled ",
+       FLASH_ACR_PRFTEN | FLASH_ACR_ICEN | FLASH_ACR_DCEN);
+
+  set_acceleration (saved & (FLASH_ACR_PRFTEN | FLASH_ACR_ICEN
+                             | FLASH_ACR_DCEN));
+}
+
+#endif // defined(OS_INCLUDE_STARTUP_BENCHMARK)
+
+// ----------------------------------------------------------------------------
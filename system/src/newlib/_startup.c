@@ -23,6 +23,14 @@
 // If OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS is defined, the
 // code is capable of initialising multiple regions.
 //
+// If OS_USE_STARTUP_BURST_INIT is defined, the regions are copied and
+// cleared 8 words at a time using LDM/STM bursts instead of a word
+// at a time.
+//
+// If OS_INCLUDE_STARTUP_BOOT_TIME is defined, the DWT cycle counter is
+// started on entry to _start() and the number of cycles taken to reach
+// main() is stored in __startup_boot_cycles (and reported via trace).
+//
 // The normal configuration is standalone, with all support
 // functions implemented locally.
 //
@@ -34,6 +42,11 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#if defined(OS_INCLUDE_STARTUP_BOOT_TIME)
+#include "cycle_counter.h"
+#include "diag/Trace.h"
+#endif
+
 // ----------------------------------------------------------------------------
 
 #if !defined(OS_INCLUDE_STARTUP_GUARD_CHECKS)
@@ -112,6 +125,73 @@ __initialize_hardware (void);
 
 // ----------------------------------------------------------------------------
 
+#if defined(OS_USE_STARTUP_BURST_INIT)
+
+// The burst registers avoid r7 (the Thumb frame pointer) and leave
+// registers free for the pointers.
+#define BURST_REGS "{r3-r6, r8-r10, r12}"
+#define BURST_CLOBBERS "r3", "r4", "r5", "r6", "r8", "r9", "r10", "r12"
+
+inline void
+__attribute__((always_inline))
+__initialize_data (unsigned int* from, unsigned int* region_begin,
+		   unsigned int* region_end)
+{
+  // Copy 8 words per iteration, then the remaining words one by one.
+  // It is assumed that the pointers are word aligned.
+  unsigned int *p = region_begin;
+  unsigned int *burst_end = p + ((unsigned int)(region_end - p) & ~7u);
+
+  __asm volatile (
+      "1:                       \n"
+      "  cmp   %[p], %[end]     \n"
+      "  bhs   2f               \n"
+      "  ldmia %[from]!, " BURST_REGS " \n"
+      "  stmia %[p]!, " BURST_REGS "    \n"
+      "  b     1b               \n"
+      "2:                       \n"
+      : [p] "+r" (p), [from] "+r" (from)
+      : [end] "r" (burst_end)
+      : BURST_CLOBBERS, "cc", "memory");
+
+  while (p < region_end)
+    *p++ = *from++;
+}
+
+inline void
+__attribute__((always_inline))
+__initialize_bss (unsigned int* region_begin, unsigned int* region_end)
+{
+  // Clear 8 words per iteration, then the remaining words one by one.
+  // It is assumed that the pointers are word aligned.
+  unsigned int *p = region_begin;
+  unsigned int *burst_end = p + ((unsigned int)(region_end - p) & ~7u);
+
+  __asm volatile (
+      "  movs  r3, #0           \n"
+      "  movs  r4, #0           \n"
+      "  movs  r5, #0           \n"
+      "  movs  r6, #0           \n"
+      "  mov   r8, r3           \n"
+      "  mov   r9, r3           \n"
+      "  mov   r10, r3          \n"
+      "  mov   r12, r3          \n"
+      "1:                       \n"
+      "  cmp   %[p], %[end]     \n"
+      "  bhs   2f               \n"
+      "  stmia %[p]!, " BURST_REGS "    \n"
+      "  b     1b               \n"
+      "2:                       \n"
+      : [p] "+r" (p)
+      : [end] "r" (burst_end)
+      : BURST_CLOBBERS, "cc", "memory");
+
+  while (p < region_end)
+    *p++ = 0;
+}
+
+#else
+
 inline void
 __attribute__((always_inline))
 __initialize_data (unsigned int* from, unsigned int* region_begin,
@@ -135,6 +215,8 @@ __initialize_bss (unsigned int* region_begin, unsigned int* region_end)
     *p++ = 0;
 }
 
+#endif // defined(OS_USE_STARTUP_BURST_INIT)
+
 // These magic symbols are provided by the linker.
 extern void
 (*__preinit_array_start[]) (void) __attribute__((weak));
@@ -223,6 +305,14 @@ __data_end_guard = DATA_END_GUARD_VALUE;
 
 #endif // defined(DEBUG) && (OS_INCLUDE_STARTUP_GUARD_CHECKS)
 
+#if defined(OS_INCLUDE_STARTUP_BOOT_TIME)
+
+// Cycles from entry to _start() to the call of main(); zero if the DWT
+// cycle counter is not available (e.g. under QEMU).
+uint32_t __startup_boot_cycles;
+
+#endif // defined(OS_INCLUDE_STARTUP_BOOT_TIME)
+
 // This is the place where Cortex-M core will go immediately after reset,
 // via a call or jump from the Reset_Handler.
 //
@@ -233,6 +323,13 @@ void __attribute__ ((section(".after_vectors"),noreturn,weak))
 _start (void)
 {
 
+#if defined(OS_INCLUDE_STARTUP_BOOT_TIME)
+  // Start counting as early as possible; the few instructions of the
+  // reset handler before this are not included.
+  int boot_counting = cycle_counter_enable ();
+  DWT->CYCCNT = 0;
+#endif
+
   // Initialise hardware right after reset, to switch clock to higher
   // frequency and have the rest of the initialisations run faster.
   //
@@ -320,6 +417,15 @@ _start (void)
   // execute the constructors for the static objects).
   __run_init_array ();
 
+#if defined(OS_INCLUDE_STARTUP_BOOT_TIME)
+  if (boot_counting)
+    {
+      __startup_boot_cycles = cycle_counter_read ();
+      trace_printf ("boot: %u cycles from reset to main()\n",
+                    (unsigned int) __startup_boot_cycles);
+    }
+#endif
+
   // Call the main entry point, and save the exit code.
   int code = main (argc, argv);
 
@@ -11,6 +11,12 @@
 #include <errno.h>
 #include "diag/Trace.h"
 
+#if defined(OS_USE_WRITE_USART)
+#include "cmsis_device.h"
+#include "system_clock.h"
+#include "memory_sections.h"
+#endif
+
 // ----------------------------------------------------------------------------
 
 // When using retargetted configurations, the standard write() system call,
@@ -19,13 +25,184 @@
 // Based on the file descriptor, it can send arrays of characters to
 // different physical devices.
 
-// Currently only the output and error file descriptors are tested,
+// By default only the output and error file descriptors are tested,
 // and the characters are forwarded to the trace device, mainly
 // for demonstration purposes. Adjust it for your specific needs.
 
+// If OS_USE_WRITE_USART is defined the output and error file descriptors
+// are instead routed to USART3 (GPIO B pins 10/11, 115.2kb 8,N,1) via a
+// transmit ring buffer emptied by the USART3 TXE interrupt. _write() only
+// copies into the buffer and never waits for the transmitter; characters
+// that do not fit are dropped and counted in _write_usart_dropped.
+// _write() still reports every character as written: newlib treats a
+// short write as an error and stops writing to the stream until
+// clearerr() is called.
+// This option defines USART3_IRQHandler() so cannot be combined with
+// application code that services USART3 interrupts.
+//
+// The USART is configured by _write_usart_initialize(), called from
+// __initialize_hardware(); an application that redefines that must
+// call it too. Any task (or interrupt handler) may write: the producer
+// side of the buffer is updated with interrupts masked, so concurrent
+// writers cannot corrupt it, and the output of each _write() call is
+// contiguous.
+//
+// Buffering is selected by OS_WRITE_USART_BUFFERING:
+// - OS_WRITE_USART_LINE (default): transmission starts on each '\n'
+// - OS_WRITE_USART_FULL: transmission starts once OS_WRITE_USART_FLUSH_LEVEL
+//   characters are pending
+// Output to stderr (fd 2) always starts transmission immediately.
+
 // For freestanding applications this file is not used and can be safely
 // ignored.
 
+// ----------------------------------------------------------------------------
+
+#if defined(OS_USE_WRITE_USART)
+
+#define OS_WRITE_USART_LINE (0)
+#define OS_WRITE_USART_FULL (1)
+
+#if !defined(OS_WRITE_USART_BUFFER_SIZE)
+#define OS_WRITE_USART_BUFFER_SIZE (256)
+#endif
+
+#if !defined(OS_WRITE_USART_BUFFERING)
+#define OS_WRITE_USART_BUFFERING OS_WRITE_USART_LINE
+#endif
+
+#if !defined(OS_WRITE_USART_FLUSH_LEVEL)
+#define OS_WRITE_USART_FLUSH_LEVEL (OS_WRITE_USART_BUFFER_SIZE / 2)
+#endif
+
+#if (OS_WRITE_USART_BUFFER_SIZE & (OS_WRITE_USART_BUFFER_SIZE - 1)) != 0
+#error "OS_WRITE_USART_BUFFER_SIZE must be a power of 2"
+#endif
+
+// Ring buffer filled by _write() with interrupts masked, so writers
+// are serialised, and emptied by the USART3 ISR. The indices run
+// freely and are masked on access, so head - tail is always the
+// number of pending characters. Only accessed by the CPU so placed
+// in CCMRAM.
+static char tx_buffer[OS_WRITE_USART_BUFFER_SIZE] FEABHAS_CCM_BSS;
+static volatile unsigned int tx_head;
+static volatile unsigned int tx_tail;
+
+// Characters discarded because the buffer was full, for
+// applications to inspect:
+//   extern volatile unsigned int _write_usart_dropped;
+volatile unsigned int _write_usart_dropped;
+
+void
+USART3_IRQHandler (void) FEABHAS_RAMFUNC;
+
+void
+_write_usart_initialize (void);
+
+void
+_write_usart_initialize (void)
+{
+  // USART3 GPIO Configuration
+  // PortB:10     ------> USART3_TX
+  // PortB:11     ------> USART3_RX
+  uint32_t ahb1enr = RCC->AHB1ENR;
+  ahb1enr |= RCC_AHB1ENR_GPIOBEN;
+  RCC->AHB1ENR = ahb1enr;
+
+  uint32_t afr1 = GPIOB->AFR[1];
+  afr1 |= (0x07u << (4 * (10 % 8)));           // USART 3 Alt fn
+  afr1 |= (0x07u << (4 * (11 % 8)));            //
+  GPIOB->AFR[1] = afr1;
+
+  uint32_t moder = GPIOB->MODER;
+  moder |= (0x02u << (10 * 2));                 // Alt function mode
+  moder |= (0x02u << (11 * 2));                 //
+  GPIOB->MODER = moder;
+
+  uint32_t apb1enr = RCC->APB1ENR;
+  apb1enr |= RCC_APB1ENR_USART3EN;
+  RCC->APB1ENR = apb1enr;
+
+  USART3->CR2 &= ~USART_CR2_STOP;               // 1 stop bit
+  USART3->BRR = (SystemClock_PCLK1 () + (115200u / 2)) / 115200u; // 115.2kb
+  USART3->CR1 = USART_CR1_UE | USART_CR1_TE;    // 8,N,1 Tx only
+
+  tx_head = 0;
+  tx_tail = 0;
+
+  NVIC_SetPriority (USART3_IRQn, 10);
+  NVIC_EnableIRQ (USART3_IRQn);
+}
+
+static ssize_t
+_write_usart (int fd, const char* buf, size_t nbyte)
+{
+  // Mask interrupts (and so task switches) while the characters are
+  // copied in; at most OS_WRITE_USART_BUFFER_SIZE bytes are copied.
+  uint32_t primask = __get_PRIMASK ();
+  __disable_irq ();
+
+  unsigned int head = tx_head;
+  unsigned int free_space = OS_WRITE_USART_BUFFER_SIZE - (head - tx_tail);
+  size_t count = (nbyte < free_space) ? nbyte : free_space;
+  int flush = (fd == 2);
+
+  for (size_t i = 0; i < count; ++i)
+    {
+      char c = buf[i];
+      tx_buffer[head & (OS_WRITE_USART_BUFFER_SIZE - 1)] = c;
+      ++head;
+#if OS_WRITE_USART_BUFFERING == OS_WRITE_USART_LINE
+      if (c == '\n')
+        {
+          flush = 1;
+        }
+#endif
+    }
+
+  tx_head = head;
+
+#if OS_WRITE_USART_BUFFERING == OS_WRITE_USART_FULL
+  if ((head - tx_tail) >= OS_WRITE_USART_FLUSH_LEVEL)
+    {
+      flush = 1;
+    }
+#endif
+
+  // A full buffer can only drain once transmission has started.
+  if (flush || (count < nbyte))
+    {
+      USART3->CR1 |= USART_CR1_TXEIE;
+    }
+  _write_usart_dropped += (unsigned int) (nbyte - count);
+
+  __set_PRIMASK (primask);
+  return (ssize_t) nbyte;
+}
+
+void
+USART3_IRQHandler (void)
+{
+  if ((USART3->SR & USART_SR_TXE) != 0)
+    {
+      unsigned int tail = tx_tail;
+      if (tail != tx_head)
+        {
+          USART3->DR = (uint32_t) tx_buffer[tail
+              & (OS_WRITE_USART_BUFFER_SIZE - 1)];
+          tx_tail = tail + 1;
+        }
+      else
+        {
+          USART3->CR1 &= ~USART_CR1_TXEIE;
+        }
+    }
+}
+
+#endif // defined(OS_USE_WRITE_USART)
+
+// ----------------------------------------------------------------------------
+
 ssize_t
 _write (int fd, const char* buf, size_t nbyte);
 
@@ -33,7 +210,13 @@ ssize_t
 _write (int fd __attribute__((unused)), const char* buf __attribute__((unused)),
 	size_t nbyte __attribute__((unused)))
 {
-#if defined(TRACE)
+#if defined(OS_USE_WRITE_USART)
+  // STDOUT and STDERR are routed to USART3
+  if (fd == 1 || fd == 2)
+    {
+      return _write_usart (fd, buf, nbyte);
+    }
+#elif defined(TRACE)
   // STDOUT and STDERR are routed to the trace device
   if (fd == 1 || fd == 2)
     {
@@ -61,6 +61,7 @@ add_compile_options(
 
 add_compile_definitions(
   STM32F407xx
+  OS_INCLUDE_STARTUP_INIT_MULTIPLE_RAM_SECTIONS   # initialise CCMRAM data/bss
   USE_FULL_ASSERT
   $<$<CONFIG:DEBUG>:TRACE>
   # OS_USE_TRACE_SEMIHOSTING_DEBUG  # semi-hosting options mutually exclusive